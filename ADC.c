@@ -31,76 +31,76 @@ void initialiseADCModule(){
 }
 
 /*------------------------------------------------------------------------------
- Function: initialiseADCPin(gpioNumber)
- *Use: This function sets up the registers required for the gpio pin specified
+ Function: readADCChannelRaw(channelSelect)
+ *Use: This function reads the raw ADC value from a fixed channel, the channel
+ * select bits are passed already shifted into the ADCON0 position by ADC_READ()
+ * so no pin decode or validity checks are needed at runtime
 ------------------------------------------------------------------------------*/
-void initialiseADCPin(const enum GPIO_PORTS gpioNumber){
-        
-    uint8_t portNumber = 0;     //the number of port gpio, ie RA1 = 1
-    uint8_t portType = 0;       //the port type, ie A or B
-    uint8_t gpioValid = 0;      //flag gpio as having valid ADC - prevent trying to set a pin which doesnt have an ADC
+uint16_t readADCChannelRaw(const uint8_t channelSelect){
     
-    if(gpioNumber < 4){                //RA0 to RA4
-        portNumber = gpioNumber;           
-        portType = GPIO_PORTA;
-        gpioValid = 1;      
+    if(!ADCON0bits.GO_nDONE){                                //ensure we are not interrupting another read
+        ADCON0 = channelSelect | 0b00000001;                 //Set to desired channel, keep ADC enabled
+        for(uint8_t i = 0; i < 16; i++);                     //insert a small time delay using a for loop to allow channel change
+        
+        ADCON0bits.GO_nDONE = 1;                             //Set the Conversion begin bit
+        while(ADCON0bits.GO_nDONE);                          //Wait until the conversion finishes
+        uint16_t returnValue = ((ADRESH<<8)+ADRESL);
+        ADCON0 = (DEFAULT_ADC << 2) | 0b00000001;            //Set the channel select bits to default channel
+        
+        return returnValue;                                  //Return the result  
     }
     
-    if((gpioNumber > 8u) && (gpioNumber <= 15u)){    //starting at RB1 (9), until RB7 (15).
-        portNumber = gpioNumber - 8;                 //According to the GPIO enum in GPIO.h, first 8 are PORT A, last 8 are PORT B
-        portType = GPIO_PORTB;    
-        gpioValid = 1;
-    }
+    else return 0;
+}
 
-    if(gpioValid){
-        if(portType == GPIO_PORTA){
-            TRISA |= (1 << (uint8_t)portNumber);            //set bit in TRISA to operate as input
-            ANSELA |= (1 << (uint8_t)portNumber);           //we also need to set the bit in the ANSEL (analog) register as we want analog Input
+/*------------------------------------------------------------------------------
+ Function: readADCChannelOversampled(channelSelect, exponent)
+ *Use: This function selects the channel once and then takes 4^exponent back
+ * to back conversions, the sum is decimated by 2^exponent to give a result
+ * with 10 + exponent bits. This relies on at least 1 LSB of noise on the
+ * signal to dither the samples, which the switching ripple provides
+------------------------------------------------------------------------------*/
+uint16_t readADCChannelOversampled(const uint8_t channelSelect, const uint8_t exponent){
+    
+    if(!ADCON0bits.GO_nDONE){                                //ensure we are not interrupting another read
+        ADCON0 = channelSelect | 0b00000001;                 //Set to desired channel, keep ADC enabled
+        for(uint8_t i = 0; i < 16; i++);                     //insert a small time delay using a for loop to allow channel change
+        
+        uint16_t sumOfSamples = 0;
+        uint8_t numberOfSamples = (uint8_t) (1u << (exponent << 1));     //4^exponent
+        for(uint8_t i = 0; i < numberOfSamples; i++){
+            ADCON0bits.GO_nDONE = 1;                         //Set the Conversion begin bit
+            while(ADCON0bits.GO_nDONE);                      //Wait until the conversion finishes, channel is unchanged so no settling delay needed
+            sumOfSamples += ((ADRESH<<8)+ADRESL);
         }
-        else if(portType == GPIO_PORTB){                    //perform the same for PORTB
-            TRISB |= (1 << (uint8_t)portNumber); 
-            ANSELB |= (1 << (uint8_t)portNumber);
-        } 
+        ADCON0 = (DEFAULT_ADC << 2) | 0b00000001;            //Set the channel select bits to default channel
+        
+        return (sumOfSamples >> exponent);                   //decimate, keeping exponent extra bits
     }
+    
+    else return 0;
 }
 
 /*------------------------------------------------------------------------------
- Function: readADCRaw(gpioNumber)
- *Use: This function reads the raw ADC value from the specified gpio pin
+ Function: readADCChannelBurst(channelSelect, samples, count)
+ *Use: This function takes count back to back conversions of one channel as
+ * fast as the ADC allows and stores the top 8 bits of each, used by scope mode
+ * to capture the switching ripple
 ------------------------------------------------------------------------------*/
-uint16_t readADCRaw(const enum GPIO_PORTS gpioNumber){
-    uint8_t channel = 0;        //the ADC channel numbering, see datasheet
-    uint8_t gpioValid = 0;      //flag gpio as having valid ADC - prevent trying to set a pin which doesnt have an ADC    
+void readADCChannelBurst(const uint8_t channelSelect, uint8_t *samples, const uint8_t count){
     
-    if(gpioNumber <= 4){
-        channel = gpioNumber;  //RA0 to RA4 directly converts to ADC numbering
-        gpioValid = 1;         //flag gpio as having valid ADC
-    }
-    if((gpioNumber > 8u) && (gpioNumber <= 15u)){  //starting at RB1 (9), until RB7 (15)
-        channel = 12u - (gpioNumber - 8);          //convert the enum to standard port B numbering, then convert to ADC numbering (see datasheet)
-        gpioValid = 1;                             //flag gpio as having valid ADC 
-    }
-    if(gpioValid){  
-        //Only attempt to read if there is an ADC on the requested GPIO
-        if(~ADCON0bits.GO_nDONE){                                //ensure we are not interrupting another read
-            ADCON0 &= ~(0b01111100);                             //Clear ADC Channel Select
-            ADCON0 |= (channel << 2);                            //Set to desired channel
-            for(uint8_t i = 0; i < 16; i++);                      //insert a small time delay using a for loop to allow channel change
-            
-            ADCON0bits.GO_nDONE = 1;                             //Set the Conversion begin bit
-            while(ADCON0bits.GO_nDONE);                          //Wait until the conversion finishes
-            //for(uint8_t i = 0; i < 8; i++);
-            unsigned int returnValue = ((ADRESH<<8)+ADRESL);
-            ADCON0 &= ~(0b01111100);                             //Clear channel select
-            ADCON0 |= (DEFAULT_ADC << 2);                        //Set the channel select bits to default channel 
-            //for(uint8_t i = 0; i < 8; i++);                    
-            
-            return returnValue;                                  //Return the result  
+    if(count == 0) return;
+    if(!ADCON0bits.GO_nDONE){                                //ensure we are not interrupting another read
+        ADCON0 = channelSelect | 0b00000001;                 //Set to desired channel, keep ADC enabled
+        for(uint8_t i = 0; i < 16; i++);                     //insert a small time delay using a for loop to allow channel change
+        
+        for(uint8_t i = 0; i < count; i++){
+            ADCON0bits.GO_nDONE = 1;                         //Set the Conversion begin bit
+            while(ADCON0bits.GO_nDONE);                      //Wait until the conversion finishes, channel is unchanged so no settling delay needed
+            samples[i] = (uint8_t) ((ADRESH << 6) | (ADRESL >> 2));     //top 8 bits of the right justified result
         }
-
-    }  
-    
-    else return 0;
+        ADCON0 = (DEFAULT_ADC << 2) | 0b00000001;            //Set the channel select bits to default channel
+    }
 }
 
 /*------------------------------------------------------------------------------
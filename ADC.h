@@ -22,11 +22,33 @@ extern "C" {
     
 #define DEFAULT_ADC 0b010     //the ADC read select is set to RA2 by default to reduce speed of reads
 #define MAX_ADC_VALUE 1023u
+#define MAX_OVERSAMPLE_EXPONENT 3u    //4^3 = 64 samples of 1023 is the most that fits the 16 bit oversampling sum
+
+//compile time ADC channel binding, see the pin binding tables in GPIO.h. Channel numbers are from the datasheet,
+//pins without an ADC have no entry so ADC_READ(pinRA5) fails to compile
+#define ADC_CHANNEL(gpio)           PIN_XCAT(PIN_ADC_CHANNEL_, gpio)
+#define ADC_READ(gpio)              readADCChannelRaw(ADC_CHANNEL(gpio) << 2)     //channel is pre-shifted into the ADCON0 CHS position
+#define ADC_INIT_PIN(gpio)          GPIO_SET_ANALOG(gpio)
+#define ADC_READ_OVERSAMPLED(gpio, exponent)    readADCChannelOversampled(ADC_CHANNEL(gpio) << 2, (exponent))
+    
+#define PIN_ADC_CHANNEL_pinRA0      0u
+#define PIN_ADC_CHANNEL_pinRA1      1u
+#define PIN_ADC_CHANNEL_pinRA2      2u
+#define PIN_ADC_CHANNEL_pinRA3      3u
+#define PIN_ADC_CHANNEL_pinRA4      4u
+#define PIN_ADC_CHANNEL_pinRB1      11u
+#define PIN_ADC_CHANNEL_pinRB2      10u
+#define PIN_ADC_CHANNEL_pinRB3      9u
+#define PIN_ADC_CHANNEL_pinRB4      8u
+#define PIN_ADC_CHANNEL_pinRB5      7u
+#define PIN_ADC_CHANNEL_pinRB6      5u
+#define PIN_ADC_CHANNEL_pinRB7      6u
 
-void initialiseADCPin(const enum GPIO_PORTS gpioNumber);
 void initialiseADCModule();
-uint16_t readADCRaw(const enum GPIO_PORTS gpioNumber);
+uint16_t readADCChannelRaw(const uint8_t channelSelect);
+uint16_t readADCChannelOversampled(const uint8_t channelSelect, const uint8_t exponent);
 uint16_t readILCurrentADCRaw();
+void readADCChannelBurst(const uint8_t channelSelect, uint8_t *samples, const uint8_t count);
 
 #ifdef	__cplusplus
 }
@@ -0,0 +1,66 @@
+/* 
+ * File:   Benchmark.c
+ * Author: agent
+ *
+ * Created on 19 October 2026, 11:34
+ */
+
+#include "Global.h"
+#include "Benchmark.h"
+#include "Telemetry.h"
+
+/*------------------------------------------------------------------------------
+ Function: recordBenchmarkLoop(filteredVout, error)
+ *Use: This function is called from the control routine each control period
+ * while in closed loop, it tracks the output range and the control error
+------------------------------------------------------------------------------*/
+void recordBenchmarkLoop(uint16_t filteredVout, int16_t error){
+#if BENCHMARK_ENABLED == 1
+    if(filteredVout < benchmarkVoutMin) benchmarkVoutMin = filteredVout;
+    if(filteredVout > benchmarkVoutMax) benchmarkVoutMax = filteredVout;
+    uint16_t magnitude = (error < 0) ? (uint16_t) (0 - error) : (uint16_t) error;
+    if(magnitude > benchmarkErrorMax) benchmarkErrorMax = magnitude;
+    if(benchmarkErrorCount < 255u){
+        benchmarkErrorSum += error;
+        benchmarkErrorCount++;
+    }
+#endif
+}
+
+/*------------------------------------------------------------------------------
+ Function: sendBenchmarkTelemetry()
+ *Use: This function queues the benchmark telemetry frame and clears the
+ * measurements for the next period
+ * payload: slot maxima (4), Vout min (2), Vout max (2), error max (2), mean
+ * error (2), all big endian, Vout is in raw oversampled LSBs and error in mV
+------------------------------------------------------------------------------*/
+void sendBenchmarkTelemetry(){
+#if BENCHMARK_ENABLED == 1
+    uint8_t payload[NUMBER_OF_BENCHMARK_SLOTS + 8];
+    uint8_t i = 0;
+    
+    INTCONbits.GIE = 0;
+    for(uint8_t slot = 0; slot < NUMBER_OF_BENCHMARK_SLOTS; slot++){
+        payload[i++] = benchmarkSlotMax[slot];
+        benchmarkSlotMax[slot] = 0;
+    }
+    int16_t errorMean = 0;
+    if(benchmarkErrorCount > 0) errorMean = (int16_t) (benchmarkErrorSum / benchmarkErrorCount);
+    payload[i++] = (uint8_t) (benchmarkVoutMin >> 8);
+    payload[i++] = (uint8_t) benchmarkVoutMin;
+    payload[i++] = (uint8_t) (benchmarkVoutMax >> 8);
+    payload[i++] = (uint8_t) benchmarkVoutMax;
+    payload[i++] = (uint8_t) (benchmarkErrorMax >> 8);
+    payload[i++] = (uint8_t) benchmarkErrorMax;
+    payload[i++] = (uint8_t) ((uint16_t) errorMean >> 8);
+    payload[i++] = (uint8_t) errorMean;
+    benchmarkVoutMin = 0xFFFF;
+    benchmarkVoutMax = 0;
+    benchmarkErrorMax = 0;
+    benchmarkErrorSum = 0;
+    benchmarkErrorCount = 0;
+    INTCONbits.GIE = 1;
+    
+    queueTelemetryFrame(TELEMETRY_ID_BENCHMARK, payload, sizeof(payload));
+#endif
+}
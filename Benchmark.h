@@ -0,0 +1,58 @@
+/* 
+ * File:   Benchmark.h
+ * Author: agent
+ *
+ * Created on 19 October 2026, 11:34
+ */
+
+#ifndef BENCHMARK_H
+#define	BENCHMARK_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <xc.h>                                     //PIC hardware mapping
+#include "Global.h"
+
+//benchmark measurements - the worst case time through each part of the interrupt and the loop performance over each
+//telemetry period are recorded and sent as a telemetry frame, then cleared. Timer0 restarts from 0 at each tick so the
+//TMR0 count at the end of a slot is the time since the tick started, in units of 64 instruction cycles (8us at 32MHz)
+//a tick is 255 counts (2.04ms), so a slot maximum approaching 255 means the interrupt is overrunning
+#define BENCHMARK_ENABLED           0       //1 records and sends the benchmark frame, 0 removes the code
+    
+//interrupt sections timed, each ends at the TMR0 count recorded
+enum benchmarkSlot{
+    benchmarkCommon,                        //trip monitor, fault manager, telemetry tick and PWM update
+    benchmarkSlot1,                         //slot 1, control routine
+    benchmarkSlot3,                         //slot 2 with slot 3, filters and pot scaling
+    benchmarkSlot4,                         //slot 2 with slot 4, filters, pot filters and mode select
+    NUMBER_OF_BENCHMARK_SLOTS
+};
+
+#if BENCHMARK_ENABLED == 1
+uint8_t benchmarkSlotMax[NUMBER_OF_BENCHMARK_SLOTS];
+uint16_t benchmarkVoutMin = 0xFFFF;                 //filtered raw Vout range over the period, gives the low frequency ripple
+uint16_t benchmarkVoutMax = 0;
+uint16_t benchmarkErrorMax = 0;                     //largest magnitude of the control error over the period
+int32_t benchmarkErrorSum = 0;                      //sum of the control error, mean gives the steady state error
+uint8_t benchmarkErrorCount = 0;
+
+//records the time through a section, cheap enough to leave in every tick
+#define BENCHMARK_SLOT_END(slot)    do{ uint8_t t = TMR0; if(t > benchmarkSlotMax[slot]) benchmarkSlotMax[slot] = t; }while(0)
+#else
+#define BENCHMARK_SLOT_END(slot)    do{ }while(0)
+#endif
+
+void recordBenchmarkLoop(uint16_t filteredVout, int16_t error);
+void sendBenchmarkTelemetry();
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* BENCHMARK_H */
@@ -0,0 +1,123 @@
+/* 
+ * File:   Command.c
+ * Author: agent
+ *
+ * Created on 19 October 2026, 11:29
+ */
+
+#include "Global.h"
+#include "Command.h"
+#include "Reference.h"
+#include "Telemetry.h"
+#include "Scope.h"
+#include "Controller.h"
+#include "Share.h"
+
+/*------------------------------------------------------------------------------
+ Function: initialiseCommands()
+ *Use: This function sets up the EUSART receiver at 115200 baud with RX
+ * steered onto RB2
+------------------------------------------------------------------------------*/
+void initialiseCommands(){
+#if COMMAND_ENABLED == 1
+    APFCON0bits.RXDTSEL = 1;        //steer RX onto RB2
+    GPIO_SET_INPUT(gpioCommandRX);
+    
+    BAUDCONbits.BRG16 = 1;          //16 bit baud rate generator
+    TXSTAbits.BRGH = 1;             //high speed baud rate
+    SPBRGH = 0;
+    SPBRGL = COMMAND_BAUD_DIVIDER;
+    
+    TXSTAbits.SYNC = 0;             //asynchronous mode
+    RCSTAbits.SPEN = 1;             //enable the serial port
+    RCSTAbits.CREN = 1;             //enable the receiver, RCIE is left off as bytes are polled from main loop
+#endif
+}
+
+/*------------------------------------------------------------------------------
+ Function: runCommands()
+ *Use: This function is called repeatedly from the main loop, it takes any
+ * received byte through the frame parser and executes complete frames with a
+ * valid checksum. Bad frames are dropped and the parser waits for a new sync
+------------------------------------------------------------------------------*/
+void runCommands(){
+#if COMMAND_ENABLED == 1
+    if(RCSTAbits.OERR){             //overrun stops the receiver, clear it by resetting CREN
+        RCSTAbits.CREN = 0;
+        RCSTAbits.CREN = 1;
+        commandState = commandWaitSync;
+    }
+    if(!PIR1bits.RCIF) return;
+    
+    uint8_t received = RCREG;
+    switch(commandState){
+        case commandWaitSync:
+            if(received == TELEMETRY_SYNC) commandState = commandWaitID;
+            break;
+        case commandWaitID:
+            commandID = received;
+            commandChecksum = received;
+            commandState = commandWaitLength;
+            break;
+        case commandWaitLength:
+            commandLength = received;
+            commandChecksum += received;
+            commandCount = 0;
+            if(commandLength > SIZE_OF_COMMAND_PAYLOAD) commandState = commandWaitSync;
+            else if(commandLength == 0) commandState = commandWaitChecksum;
+            else commandState = commandWaitPayload;
+            break;
+        case commandWaitPayload:
+            commandPayload[commandCount++] = received;
+            commandChecksum += received;
+            if(commandCount >= commandLength) commandState = commandWaitChecksum;
+            break;
+        case commandWaitChecksum:
+            if(received == commandChecksum) executeCommand(commandID, commandPayload, commandLength);
+            commandState = commandWaitSync;
+            break;
+        default:
+            commandState = commandWaitSync;
+            break;
+    }
+#endif
+}
+
+/*------------------------------------------------------------------------------
+ Function: executeCommand(id, payload, length)
+ *Use: This function carries out a received command, commands with the wrong
+ * payload length are ignored, as is a reference above REFERENCE_MAX_MV
+------------------------------------------------------------------------------*/
+void executeCommand(uint8_t id, const uint8_t *payload, uint8_t length){
+    switch(id){
+        case COMMAND_ID_START_PROFILE:
+            if(length == 1) startReferenceProfile(payload[0]);
+            break;
+        case COMMAND_ID_SET_REFERENCE:
+            if(length == 2){
+                uint16_t target = ((uint16_t) payload[0] << 8) | payload[1];
+                if(target <= REFERENCE_MAX_MV) setReferenceTarget(target);
+            }
+            break;
+        case COMMAND_ID_RELEASE_REFERENCE:
+            releaseReference();
+            break;
+        case COMMAND_ID_SET_MODE:
+            if(length == 1) requestControlMode(payload[0] != 0);
+            break;
+        case COMMAND_ID_SCOPE_ARM:
+            if(length == 4) armScope(payload[0], (enum scopeTrigger) payload[1], ((uint16_t) payload[2] << 8) | payload[3]);
+            break;
+        case COMMAND_ID_SCOPE_TRIGGER:
+            triggerScope(scopeTriggerCommand);
+            break;
+        case COMMAND_ID_SET_CURRENT:
+            if(length == 2) setCurrentTarget(((uint16_t) payload[0] << 8) | payload[1]);
+            break;
+        case TELEMETRY_ID_SHARE:
+            if(length == 3) recordShareCurrent(payload[0], (int16_t) (((uint16_t) payload[1] << 8) | payload[2]));
+            break;
+        default:
+            break;
+    }
+}
@@ -0,0 +1,66 @@
+/* 
+ * File:   Command.h
+ * Author: agent
+ *
+ * Created on 19 October 2026, 11:29
+ */
+
+#ifndef COMMAND_H
+#define	COMMAND_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <xc.h>                                     //PIC hardware mapping
+#include "Global.h"
+
+//commands are received on the EUSART RX, which is steered onto RB2 (shared with the frequency pot, so with commands
+//enabled pot control runs at the fixed COMMAND_POT_PERIOD). Frames use the same format as telemetry:
+//TELEMETRY_SYNC, command ID, payload length, payload, then a checksum of the ID, length and payload bytes
+#define COMMAND_ENABLED             0       //1 enables the EUSART receiver and command handling, 0 removes the code
+#define COMMAND_BAUD_DIVIDER        68u     //must match TELEMETRY_BAUD_DIVIDER, 115200 baud
+#define COMMAND_POT_PERIOD          79u     //pot control period used when the frequency pot pin is taken by RX, 100kHz
+#define SIZE_OF_COMMAND_PAYLOAD     4u      //longest command payload accepted
+    
+//command IDs
+#define COMMAND_ID_START_PROFILE    0x10u   //payload: profile number
+#define COMMAND_ID_SET_REFERENCE    0x11u   //payload: target in mV, big endian, ignored above REFERENCE_MAX_MV
+#define COMMAND_ID_RELEASE_REFERENCE 0x12u  //no payload, return the target to the jumper
+#define COMMAND_ID_SET_MODE         0x13u   //payload: 0 pot control, 1 closed loop control
+#define COMMAND_ID_SCOPE_ARM         0x14u  //payload: ADC channel (| SCOPE_BURST_FLAG), trigger, raw threshold big endian
+#define COMMAND_ID_SCOPE_TRIGGER     0x15u  //no payload, fires a capture armed with scopeTriggerCommand
+#define COMMAND_ID_SET_CURRENT      0x16u   //payload: current target (limit in CC/CV) in mA, big endian, 0 returns to the jumper
+    
+//states of the frame parser
+enum commandParserState{
+    commandWaitSync,
+    commandWaitID,
+    commandWaitLength,
+    commandWaitPayload,
+    commandWaitChecksum
+};
+
+#if COMMAND_ENABLED == 1
+enum commandParserState commandState = commandWaitSync;
+uint8_t commandID = 0;
+uint8_t commandLength = 0;
+uint8_t commandCount = 0;                           //payload bytes received so far
+uint8_t commandChecksum = 0;
+uint8_t commandPayload[SIZE_OF_COMMAND_PAYLOAD];
+#endif
+
+void initialiseCommands();
+void runCommands();
+void executeCommand(uint8_t id, const uint8_t *payload, uint8_t length);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* COMMAND_H */
+
@@ -12,12 +12,17 @@
 #include "CurrentSensor.h"
 #include "StateMachine.h"
 #include "PWM.h"
+#include "Reference.h"
+#include "Benchmark.h"
+#include "Observer.h"
+#include "FixedPoint.h"
+#include "Share.h"
 
-#if CONTROL_METHOD == VOLTAGE_MODE_CONTROL
+#if VOLTAGE_LOOP_ENABLED
 struct controllerVariables voltageModeVariables = {0, 0, 0, 0, 0, 0};
 #endif
 
-#if CONTROL_METHOD == CURRENT_MODE_CONTROL
+#if CURRENT_LOOP_ENABLED
 struct controllerVariables currentModeVariables = {0, 0, 0, 0, 0, 0};
 #endif
 
@@ -26,19 +31,83 @@ struct controllerVariables currentModeVariables = {0, 0, 0, 0, 0, 0};
  *Use: This function initialises the voltage sensor
 ------------------------------------------------------------------------------*/
 void initialiseController(){
-    initialiseGPIO(gpioOutputVoltage, GPIO_Input);
-    initialiseADCPin(gpioOutputVoltage);
-    integratorScaledLimit = (int64_t) ((int64_t) (INTEGRAL_LIMIT) << (VOLTAGE_MODE_KI_EXPONENT + DT_EXPONENT));
+    ADC_INIT_PIN(gpioOutputVoltage);
+}
+
+/*------------------------------------------------------------------------------
+ Function: startSoftStart()
+ *Use: This function clears the integrator and drops the duty limit to
+ * MIN_DUTY, from where controlRoutine() ramps it back up to MAX_DUTY. The
+ * voltage reference is ramped from the measured output, so no error builds up
+ * while the output is still at its starting voltage. Used on start up and when
+ * restarting after a fault so the converter does not trip again on inrush
+------------------------------------------------------------------------------*/
+void startSoftStart(){
+    softStartLimit = MIN_DUTY;
+    enablePhase2(1);                    //restore phase 2 if it was shed after a trip
+    balanceIntegral = 0;
+    cccvStateCount = 0;
+    resetReference(convertRawToMilliVolts(hotState.filteredVout), 1);  //ramp the voltage reference up from the present output at the start up slew rate
+#if VOLTAGE_LOOP_ENABLED
+    voltageModeVariables.integralOutputScaled = 0;
+    voltageModeVariables.saturation = 0;
+#endif
+#if CURRENT_LOOP_ENABLED
+    currentModeVariables.integralOutputScaled = 0;
+    currentModeVariables.saturation = 0;
+#endif
+}
+
+/*------------------------------------------------------------------------------
+ Function: preloadController()
+ *Use: This function prepares the controller to take over from pot control
+ * without a duty step. The reference starts from the measured output so the
+ * error is close to zero, and the integrator is loaded so the controller
+ * output matches the present duty, scaled to the closed loop period. The
+ * filters run in every state so are already settled
+------------------------------------------------------------------------------*/
+void preloadController(){
+    if(hotState.setPeriod == 0) return;         //PWM is off, start from the normal initial state
+    softStartLimit = MAX_DUTY;                  //running already, no soft start
+    
+#if VOLTAGE_LOOP_ENABLED
+    resetReference(convertRawToMilliVolts(hotState.filteredVout), 0);  //reference then slews to the target
+    int16_t heldDuty = (int16_t) (((uint32_t) hotState.setDuty * VOLTAGE_MODE_CONTROL_PERIOD) / hotState.setPeriod);
+    int16_t offsetDuty = (int16_t) calculateOffsetDuty(referenceMilliVolts, VOLTAGE_MODE_CONTROL_PERIOD);
+    voltageModeVariables.integralOutputScaled = (int64_t) (heldDuty - offsetDuty) << (DT_EXPONENT + VOLTAGE_MODE_KI_EXPONENT);
+    voltageModeVariables.saturation = 0;
+#endif
+#if CONTROL_METHOD == CCCV_MODE_CONTROL
+    currentModeVariables.integralOutputScaled = (int64_t) (heldDuty - offsetDuty) << (DT_EXPONENT + CURRENT_MODE_KI_EXPONENT);    //tracking the voltage loop
+    currentModeVariables.saturation = 0;
+    cccvStateCount = 0;
+#elif CURRENT_LOOP_ENABLED
+    int16_t heldDuty = (int16_t) (((uint32_t) hotState.setDuty * CURRENT_MODE_CONTROL_PERIOD) / hotState.setPeriod);
+    int16_t offsetDuty = (int16_t) (((uint32_t)(((uint16_t) PID_OFFSET) * CURRENT_MODE_CONTROL_PERIOD)) /  25);
+    currentModeVariables.integralOutputScaled = (int64_t) (heldDuty - offsetDuty) << (DT_EXPONENT + CURRENT_MODE_KI_EXPONENT);
+    currentModeVariables.saturation = 0;
+#endif
+}
+
+/*------------------------------------------------------------------------------
+ Function: prefillVoutFilter()
+ *Use: This function fills the Vout FIFO with a burst of real samples so the
+ * filtered value is valid before any control decision, rather than rising
+ * from 0 over the first SIZE_OF_VSENSOR_FILTER slots. Takes approx 4ms
+------------------------------------------------------------------------------*/
+void prefillVoutFilter(){
+    for(uint8_t i=0; i<SIZE_OF_VSENSOR_FILTER; i++) hotState.filteredVout = readFilteredVout();
 }
 
 /*------------------------------------------------------------------------------
  Function: readFilteredVout()
- *Use: This function obtains a new ADC sample and performs the moving average 
- * FIFO filter for the Vout sensor, returning the filtered value
+ *Use: This function obtains a new oversampled ADC sample and performs the moving
+ * average FIFO filter for the Vout sensor, returning the filtered value with
+ * 10 + VSENSOR_OVERSAMPLE_EXPONENT bits
 ------------------------------------------------------------------------------*/
 uint16_t readFilteredVout(){
     for(uint8_t i=0; i<SIZE_OF_VSENSOR_FILTER-1; i++) voutFIFO[i] = voutFIFO[i+1];       //shift all values in array to next 
-    voutFIFO[SIZE_OF_VSENSOR_FILTER-1] =  readADCRaw(gpioOutputVoltage);                 //take the newest sample
+    voutFIFO[SIZE_OF_VSENSOR_FILTER-1] =  ADC_READ_OVERSAMPLED(gpioOutputVoltage, VSENSOR_OVERSAMPLE_EXPONENT);   //take the newest sample
     uint32_t sumOfSamples = 0;
     for(uint8_t i=0; i<SIZE_OF_VSENSOR_FILTER; i++) sumOfSamples += voutFIFO[i];         //add all samples together
     
@@ -52,9 +121,7 @@ uint16_t readFilteredVout(){
 ------------------------------------------------------------------------------*/
 int16_t convertRawToMilliVolts(uint16_t rawValue){
     int16_t offsetted = (int16_t)(rawValue) - VOLTAGE_SENSOR_OFFSET; //subtract the offset obtained from calibration
-    int32_t vsenseMult = ((int32_t)(((int32_t) offsetted) * VOLTAGE_SENSOR_GAIN));
-    int16_t returnValuedV = (int16_t) (vsenseMult >> VOLTAGE_SENSOR_EXPONENT);
-    return returnValuedV;
+    return mulShiftSigned(offsetted, VOLTAGE_SENSOR_GAIN, VOLTAGE_SENSOR_EXPONENT);
 }
 
 /*------------------------------------------------------------------------------
@@ -67,34 +134,62 @@ void controlRoutine(){
     if((currentState == voltageModeControl) || (currentState == currentModeControl)){
         int16_t setDuty_unreg = 0;
 
-
+#if CONTROL_METHOD == CCCV_MODE_CONTROL
+        setDuty_unreg = runConstantCurrentConstantVoltage();      //both loops run in either state
+#else
         if(currentState == voltageModeControl){      //decides whether to run voltage mode control
-#if CONTROL_METHOD == VOLTAGE_MODE_CONTROL
+#if VOLTAGE_LOOP_ENABLED
+#if VOLTAGE_MODE_ALGORITHM == VOLTAGE_MODE_PREDICTIVE
+            hotState.setPeriod = VOLTAGE_MODE_CONTROL_PERIOD;
+            setDuty_unreg = runPredictiveControl();
+#else
             runVoltageModeControl();
-            setPeriod = VOLTAGE_MODE_CONTROL_PERIOD;
-            //add 50% duty offset to the output of PID controller to allow positive and negative output 
-            setDuty_unreg = (int16_t) (((uint32_t)(((uint16_t) PID_OFFSET) * setPeriod)) /  25)  + voltageModeVariables.sumOutput;
+            hotState.setPeriod = VOLTAGE_MODE_CONTROL_PERIOD;
+            //add the nominal duty to the output of PID controller to allow positive and negative output 
+            setDuty_unreg = saturateToInt16((int32_t) calculateOffsetDuty(referenceMilliVolts, hotState.setPeriod) + voltageModeVariables.sumOutput);
+#endif
 #endif
         }
         if(currentState == currentModeControl){     //decides whether to run current mode control
-#if CONTROL_METHOD == CURRENT_MODE_CONTROL
+#if CURRENT_LOOP_ENABLED
             runCurrentModeControl();                    //NO CODE YET WRITTEN FOR CURRENT MODE
-            setPeriod = CURRENT_MODE_CONTROL_PERIOD;
+            hotState.setPeriod = CURRENT_MODE_CONTROL_PERIOD;
             //add 50% duty offset to the output of PID controller to allow positive and negative output 
-            setDuty_unreg = (uint16_t) (((uint32_t)(((uint16_t) PID_OFFSET) * setPeriod)) /  25)  + currentModeVariables.sumOutput;
+            setDuty_unreg = saturateToInt16((int32_t) (((uint32_t)(((uint16_t) PID_OFFSET) * hotState.setPeriod)) /  25)  + currentModeVariables.sumOutput);
+#endif
+        }
 #endif
+        //ramp the soft start limit up towards MAX_DUTY, one step per control period
+        if(softStartLimit < MAX_DUTY){
+            softStartLimit += SOFT_START_STEP;
+            if(softStartLimit > MAX_DUTY) softStartLimit = MAX_DUTY;
         }
+        
         //limit duty cycle between specified min and max values. Divide by 25 as MAX_DUTY is in %, and 100% duty corresponds to 4*period
-        uint16_t maxDuty = (uint16_t) (((uint32_t)(((uint16_t) MAX_DUTY) * setPeriod)) /  25);
-        uint16_t minDuty = (uint16_t) (((uint32_t)(((uint16_t) MIN_DUTY) * setPeriod)) /  25);
+        uint16_t maxDuty = (uint16_t) (((uint32_t)(((uint16_t) softStartLimit) * hotState.setPeriod)) /  25);
+        uint16_t minDuty = (uint16_t) (((uint32_t)(((uint16_t) MIN_DUTY) * hotState.setPeriod)) /  25);
 
-        setDuty = setDuty_unreg;
+        hotState.setDuty = setDuty_unreg;
 
-        if(setDuty_unreg < 0) setDuty = minDuty;
+        if(setDuty_unreg < 0) hotState.setDuty = minDuty;
         else if(setDuty_unreg >= 0){
-            if(setDuty_unreg < minDuty) setDuty = minDuty;
-            else if(setDuty_unreg > maxDuty) setDuty = maxDuty;
+            if(setDuty_unreg < minDuty) hotState.setDuty = minDuty;
+            else if(setDuty_unreg > maxDuty) hotState.setDuty = maxDuty;
         }
+        
+        //record how far the limits moved the duty, so the integrator knows the duty that was actually applied
+        //in CC/CV only the loop in control sees the limits, the other is already held to the applied duty by tracking
+#if VOLTAGE_LOOP_ENABLED
+        voltageModeVariables.saturation = subSaturated(setDuty_unreg, (int16_t) hotState.setDuty);
+        recordBenchmarkLoop(hotState.filteredVout, voltageModeVariables.error);
+#endif
+#if CURRENT_LOOP_ENABLED
+        currentModeVariables.saturation = subSaturated(setDuty_unreg, (int16_t) hotState.setDuty);
+#endif
+#if CONTROL_METHOD == CCCV_MODE_CONTROL
+        if(cccvCurrentSelected) voltageModeVariables.saturation = 0;
+        else currentModeVariables.saturation = 0;
+#endif
     }
 }
 
@@ -105,29 +200,41 @@ void controlRoutine(){
 ------------------------------------------------------------------------------*/
 void runVoltageModeControl(){
  
-#if CONTROL_METHOD == VOLTAGE_MODE_CONTROL
+#if VOLTAGE_LOOP_ENABLED
     
-   //Obtain latest voltage reading in millivolts
-   uint16_t newVoltage = convertRawToMilliVolts(filteredVout);
+   //Obtain latest voltage reading in millivolts, from the observer if enabled otherwise the moving average
+   int16_t newVoltage = readObservedVout();
    
-   //calculate the latest error value, use the second target voltage value if jumper has been removed
-   if(readGPIO(gpioControlSelect)) voltageModeVariables.error = TARGET_VOLTAGE_MV_2 - newVoltage;
-   else voltageModeVariables.error = TARGET_VOLTAGE_MV_1 - newVoltage;
+   //calculate the latest error value against the slew limited reference, the target is chosen by the reference generator
+   runReferenceGenerator();
+   voltageModeVariables.error = subSaturated(calculateVoltageTarget(), newVoltage);
    
    //calculate integral component using gain and bit shift to do .dt multiplication, avoiding floating points
    int64_t integralMult = ((int64_t) (VOLTAGE_MODE_KI * ((int64_t) voltageModeVariables.error) )) * DT_GAIN;
    //dont perform the bit shift until after calculating the cumulative value otherwise precision (fractional values) will be permanently lost
    voltageModeVariables.integral = integralMult;
+#if ANTI_WINDUP_METHOD == ANTI_WINDUP_CONDITIONAL
+   //only integrate if the duty is not limited, or the error would bring it back off the limit
+   if(!(((voltageModeVariables.saturation > 0) && (voltageModeVariables.error > 0)) ||
+        ((voltageModeVariables.saturation < 0) && (voltageModeVariables.error < 0)))){
+       voltageModeVariables.integralOutputScaled = (voltageModeVariables.integralOutputScaled + voltageModeVariables.integral);
+   }
+#else
    voltageModeVariables.integralOutputScaled = (voltageModeVariables.integralOutputScaled + voltageModeVariables.integral);
+#endif
+#if ANTI_WINDUP_METHOD == ANTI_WINDUP_BACK_CALCULATION
+   //remove a fraction of the excess duty from the integrator, scaled up to match the pre-shifted value
+   voltageModeVariables.integralOutputScaled -= ((int64_t) voltageModeVariables.saturation << (DT_EXPONENT + VOLTAGE_MODE_KI_EXPONENT)) >> BACK_CALCULATION_SHIFT;
+#endif
  
    //anti windup for integrator, limit integral component to reasonable values, using a limit which has been scaled up to match the pre-shifted value
-   if(voltageModeVariables.integralOutputScaled > (integratorScaledLimit)){
-       voltageModeVariables.integralOutputScaled = (integratorScaledLimit);
+   if(voltageModeVariables.integralOutputScaled > (INTEGRATOR_SCALED_LIMIT)){
+       voltageModeVariables.integralOutputScaled = (INTEGRATOR_SCALED_LIMIT);
    }
    //anti windup for negative values
    if(voltageModeVariables.integralOutputScaled < 0){
-        if(abs(voltageModeVariables.integralOutputScaled) > (integratorScaledLimit)){
-                voltageModeVariables.integralOutputScaled = (int64_t) (0 -(integratorScaledLimit));
+        if(abs(voltageModeVariables.integralOutputScaled) > (INTEGRATOR_SCALED_LIMIT)){
+                voltageModeVariables.integralOutputScaled = (int64_t) (0 -(INTEGRATOR_SCALED_LIMIT));
         }
    }
    
@@ -144,6 +251,90 @@ void runVoltageModeControl(){
 #endif
 }
 
+/*------------------------------------------------------------------------------
+ Function: calculateVoltageTarget()
+ *Use: This function returns the voltage the PI loop regulates to, the slew
+ * limited reference less the droop at the present output current, plus the
+ * current sharing trim
+------------------------------------------------------------------------------*/
+int16_t calculateVoltageTarget(){
+    int16_t target = (int16_t) referenceMilliVolts;
+#if DROOP_ENABLED == 1
+    int16_t outputCurrent = convertRawToMilliAmps(hotState.filteredIL);
+    if(outputCurrent > 0) target = subSaturated(target, mulShiftSigned(outputCurrent, DROOP_GAIN, DROOP_EXPONENT));
+#endif
+    return addSaturated(target, readShareTrim());
+}
+
+/*------------------------------------------------------------------------------
+ Function: calculateOffsetDuty(milliVolts, period)
+ *Use: This function returns the duty the voltage mode PI output is added to,
+ * the feed forward duty which gives the requested output at the present Vin,
+ * or the fixed PID_OFFSET when feed forward is disabled
+------------------------------------------------------------------------------*/
+uint16_t calculateOffsetDuty(uint16_t milliVolts, uint8_t period){
+#if VOLTAGE_FEEDFORWARD_ENABLED == 1
+    return (uint16_t) (((uint32_t) ((uint32_t) milliVolts * period) * readDutyGain()) >> DUTY_GAIN_EXPONENT);
+#else
+    return (uint16_t) (((uint32_t)(((uint16_t) PID_OFFSET) * period)) /  25);
+#endif
+}
+
+/*------------------------------------------------------------------------------
+ Function: runPredictiveControl()
+ *Use: This function runs the predictive voltage mode control method and
+ * returns the unlimited duty. The next output is chosen to close 1/(2^n) of
+ * the present error to the reference, reduced if the load current predicted
+ * at that voltage exceeds PREDICTIVE_CURRENT_LIMIT_MA, so the error decays
+ * geometrically by (1 - 1/(2^n)) each period. The duty to reach it is found
+ * from the observer model, with the estimated losses added. The duty limits
+ * are then applied by controlRoutine() as for the PI controller
+------------------------------------------------------------------------------*/
+int16_t runPredictiveControl(){
+#if (CONTROL_METHOD == VOLTAGE_MODE_CONTROL) && (VOLTAGE_MODE_ALGORITHM == VOLTAGE_MODE_PREDICTIVE)
+    runReferenceGenerator();
+    int16_t newVoltage = observer.vout;
+    voltageModeVariables.error = subSaturated((int16_t) referenceMilliVolts, newVoltage);
+    int16_t targetVoltage = addSaturated(newVoltage, voltageModeVariables.error >> PREDICTIVE_HORIZON_SHIFT);
+    
+    //current constraint, for a resistive load the current scales with the output voltage
+    if((observer.loadCurrent > 0) && (newVoltage > 0)){
+        int32_t targetCurrent = ((int32_t) targetVoltage * observer.loadCurrent) / newVoltage;
+        if(targetCurrent > PREDICTIVE_CURRENT_LIMIT_MA){
+            targetVoltage = saturateToInt16(((int32_t) PREDICTIVE_CURRENT_LIMIT_MA * newVoltage) / observer.loadCurrent);
+        }
+    }
+    
+    //the switch node voltage needed to give the target after the losses and the inductor resistance drop
+    int16_t requiredVoltage = addSaturated(addSaturated(targetVoltage, observer.loss), mulShiftSigned(observer.loadCurrent, OBSERVER_DCR_GAIN, OBSERVER_GAIN_EXPONENT));
+    if(requiredVoltage < 0) requiredVoltage = 0;
+    return saturateToInt16((((uint32_t) requiredVoltage * hotState.setPeriod) * readDutyGain()) >> DUTY_GAIN_EXPONENT);
+#else
+    return 0;
+#endif
+}
+
+/*------------------------------------------------------------------------------
+ Function: runCurrentBalance()
+ *Use: This function is called from slot 2 with the interleaved converter, it
+ * integrates the difference between the filtered phase 1 (IL) and phase 2
+ * (IDS) currents into the phase 2 duty correction, so phase 2 takes more duty
+ * while it carries less current. The correction is cleared while phase 2 is
+ * shed or the PWM is off
+------------------------------------------------------------------------------*/
+void runCurrentBalance(){
+#if INTERLEAVED_ENABLED == 1
+    if(!phase2Enabled || (hotState.setDuty == 0)){
+        balanceIntegral = 0;
+        phaseBalance = 0;
+        return;
+    }
+    int16_t difference = subSaturated(convertRawToMilliAmps(hotState.filteredIL), convertRawToMilliAmps(hotState.filteredIDS));
+    balanceIntegral = clampInt16(balanceIntegral + (difference >> BALANCE_SHIFT), -(BALANCE_LIMIT << BALANCE_EXPONENT), (BALANCE_LIMIT << BALANCE_EXPONENT));
+    phaseBalance = (int8_t) (balanceIntegral >> BALANCE_EXPONENT);
+#endif
+}
+
 /*------------------------------------------------------------------------------
  Function: runCurrentModeControl()
  *Use: This function runs the current mode control method and sets the variables
@@ -153,27 +344,38 @@ void runCurrentModeControl(){
     
 // NOTE - this controller has not been tested, or properly designed, the PI controller template from Voltage Mode has simply been copied across
     
-#if CONTROL_METHOD == CURRENT_MODE_CONTROL
-    int16_t newCurrent = convertRawToMilliAmps(filteredIL); 
+#if CURRENT_LOOP_ENABLED
+    int16_t newCurrent = convertRawToMilliAmps(hotState.filteredIL); 
    
    //calculate the latest error value, use the second target current value if jumper has been removed
-   if(readGPIO(gpioControlSelect)) currentModeVariables.error = TARGET_CURRENT_MA_2 - newCurrent;
-   else currentModeVariables.error = TARGET_CURRENT_MA_1 - newCurrent;
+   if(currentTargetMilliAmps != 0) currentModeVariables.error = subSaturated((int16_t) currentTargetMilliAmps, newCurrent);
+   else if(READ_CONTROL_SELECT()) currentModeVariables.error = subSaturated(TARGET_CURRENT_MA_2, newCurrent);
+   else currentModeVariables.error = subSaturated(TARGET_CURRENT_MA_1, newCurrent);
    
    //calculate integral component using gain and bit shift to do .dt multiplication, avoiding floating points
    int64_t integralMult = ((int64_t) (CURRENT_MODE_KI * ((int64_t) currentModeVariables.error) )) * DT_GAIN;
    //dont perform the bit shift until after calculating the cumulative value otherwise precision (fractional values) will be permanently lost
    currentModeVariables.integral = integralMult;
+#if ANTI_WINDUP_METHOD == ANTI_WINDUP_CONDITIONAL
+   if(!(((currentModeVariables.saturation > 0) && (currentModeVariables.error > 0)) ||
+        ((currentModeVariables.saturation < 0) && (currentModeVariables.error < 0)))){
+       currentModeVariables.integralOutputScaled = (currentModeVariables.integralOutputScaled + currentModeVariables.integral);
+   }
+#else
    currentModeVariables.integralOutputScaled = (currentModeVariables.integralOutputScaled + currentModeVariables.integral);
+#endif
+#if ANTI_WINDUP_METHOD == ANTI_WINDUP_BACK_CALCULATION
+   currentModeVariables.integralOutputScaled -= ((int64_t) currentModeVariables.saturation << (DT_EXPONENT + CURRENT_MODE_KI_EXPONENT)) >> BACK_CALCULATION_SHIFT;
+#endif
  
    //anti windup for integrator, limit integral component to reasonable values, using a limit which has been scaled up to match the pre-shifted value
-   if(currentModeVariables.integralOutputScaled > (integratorScaledLimit)){
-       currentModeVariables.integralOutputScaled = (integratorScaledLimit);
+   if(currentModeVariables.integralOutputScaled > (CURRENT_INTEGRATOR_SCALED_LIMIT)){
+       currentModeVariables.integralOutputScaled = (CURRENT_INTEGRATOR_SCALED_LIMIT);
    }
    //anti windup for negative values
-   if(currenteModeVariables.integralOutputScaled < 0){
-        if(abs(currentModeVariables.integralOutputScaled) > (integratorScaledLimit)){
-                currentModeVariables.integralOutputScaled = (int64_t) (0 -(integratorScaledLimit));
+   if(currentModeVariables.integralOutputScaled < 0){
+        if(abs(currentModeVariables.integralOutputScaled) > (CURRENT_INTEGRATOR_SCALED_LIMIT)){
+                currentModeVariables.integralOutputScaled = (int64_t) (0 -(CURRENT_INTEGRATOR_SCALED_LIMIT));
         }
    }
    
@@ -189,3 +391,69 @@ void runCurrentModeControl(){
    
 #endif
 }
+
+/*------------------------------------------------------------------------------
+ Function: runConstantCurrentConstantVoltage()
+ *Use: This function runs the voltage and current loops together for CC/CV and
+ * returns the lower of their duty requests. The integrator of the loop not in
+ * control is held so its request does not exceed the applied duty, so it
+ * takes over as soon as its error reaches 0. The state is changed to follow
+ * the loop in control once it has held for CCCV_STATE_DEBOUNCE periods
+------------------------------------------------------------------------------*/
+int16_t runConstantCurrentConstantVoltage(){
+#if CONTROL_METHOD == CCCV_MODE_CONTROL
+    hotState.setPeriod = VOLTAGE_MODE_CONTROL_PERIOD;
+    runVoltageModeControl();
+    runCurrentModeControl();
+    
+    //both loops work around the feed forward duty so their integrators hold comparable values
+    int16_t offsetDuty = (int16_t) calculateOffsetDuty(referenceMilliVolts, hotState.setPeriod);
+    int16_t voltageDuty = saturateToInt16((int32_t) offsetDuty + voltageModeVariables.sumOutput);
+    int16_t currentDuty = saturateToInt16((int32_t) offsetDuty + currentModeVariables.sumOutput);
+    
+    cccvCurrentSelected = (currentDuty < voltageDuty);
+    int16_t selectedDuty = cccvCurrentSelected ? currentDuty : voltageDuty;
+    if(cccvCurrentSelected) trackIntegrator(&voltageModeVariables, subSaturated(selectedDuty, offsetDuty), VOLTAGE_MODE_KI_EXPONENT);
+    else trackIntegrator(&currentModeVariables, subSaturated(selectedDuty, offsetDuty), CURRENT_MODE_KI_EXPONENT);
+    
+    if(cccvCurrentSelected == (currentState == currentModeControl)) cccvStateCount = 0;
+    else if(++cccvStateCount >= CCCV_STATE_DEBOUNCE){
+        cccvStateCount = 0;
+        if(cccvCurrentSelected) transToCurrentModeControl();
+        else transToVoltageModeControl();
+    }
+    return selectedDuty;
+#else
+    return 0;
+#endif
+}
+
+/*------------------------------------------------------------------------------
+ Function: trackIntegrator(loop, integralLimit, exponent)
+ *Use: This function pulls the integrator of a loop that is not in control
+ * down to integralLimit duty counts, and recalculates its output. Only the
+ * integral term is held, so the loop's request is the applied duty plus its
+ * proportional term, which falls to 0 as its error does
+------------------------------------------------------------------------------*/
+void trackIntegrator(struct controllerVariables *loop, int16_t integralLimit, uint8_t exponent){
+#if CONTROL_METHOD == CCCV_MODE_CONTROL
+    int64_t scaledLimit = (int64_t) integralLimit << (DT_EXPONENT + exponent);
+    if(loop->integralOutputScaled > scaledLimit){
+        loop->integralOutputScaled = scaledLimit;
+        loop->integralOutput = integralLimit;
+        loop->sumOutput = loop->integralOutput + loop->proportionalOutput;
+    }
+#endif
+}
+
+/*------------------------------------------------------------------------------
+ Function: setCurrentTarget(milliAmps)
+ *Use: This function sets the current loop target, the current limit in CC/CV,
+ * 0 returns to the target chosen by the jumper
+------------------------------------------------------------------------------*/
+void setCurrentTarget(uint16_t milliAmps){
+    if(milliAmps > INT16_MAX) milliAmps = INT16_MAX;
+    INTCONbits.GIE = 0;         //called from main loop, so prevent the control period seeing half of the new target
+    currentTargetMilliAmps = milliAmps;
+    INTCONbits.GIE = 1;
+}
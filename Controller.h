@@ -18,12 +18,18 @@ extern "C" {
 #include <stdbool.h>
 #include <stdint.h>   
 #include "Global.h" 
+#include "PWM.h"
+#include "Observer.h"
+#include "InputVoltage.h"
 
 //select the closed loop control method    
 #define VOLTAGE_MODE_CONTROL    1
 #define CURRENT_MODE_CONTROL    0
+#define CCCV_MODE_CONTROL       2                          //constant current / constant voltage, both loops run together
 #define CONTROL_METHOD          VOLTAGE_MODE_CONTROL       //used to guide state machine to enter voltage or current mode control,
                                                            //and compile switches removes code to reduce memory consumption
+#define VOLTAGE_LOOP_ENABLED    ((CONTROL_METHOD == VOLTAGE_MODE_CONTROL) || (CONTROL_METHOD == CCCV_MODE_CONTROL))
+#define CURRENT_LOOP_ENABLED    ((CONTROL_METHOD == CURRENT_MODE_CONTROL) || (CONTROL_METHOD == CCCV_MODE_CONTROL))
     
 //closed loop control settings 
 #define PID_OFFSET                  50u            //make the PI controller operate around 50% duty (negative output corresponds to 0-50%, positive 50-100%)
@@ -31,40 +37,123 @@ extern "C" {
                                                    //to by DT_EXPONENT + VOLTAGE_MODE_KI_EXPONENT in intialisation code
 //need a DT multiplication of 1/245 = 0.0040816
 //to get required accuracy with gain/exponent need to bit shift by 16, 0.0040816 * 2^16 (65536) = 267.49
+#if DESIGN_SPEC_ENABLED == 0
 #define DT_GAIN     267u    //GAIN of 267 / (2^16) = 0.004074  
 #define DT_EXPONENT 16u
+#endif
+//integrator limit scaled up to match the pre-shifted integral, constants rather than variables to save 16 bytes of RAM
+#define INTEGRATOR_SCALED_LIMIT         ((int64_t) INTEGRAL_LIMIT << (VOLTAGE_MODE_KI_EXPONENT + DT_EXPONENT))
+#define CURRENT_INTEGRATOR_SCALED_LIMIT ((int64_t) INTEGRAL_LIMIT << (CURRENT_MODE_KI_EXPONENT + DT_EXPONENT))
+    
+//anti windup method - the INTEGRAL_LIMIT clamp is always applied, these add saturation awareness using the duty actually
+//applied after the MIN_DUTY/MAX_DUTY limits in controlRoutine()
+#define ANTI_WINDUP_CLAMP           0              //INTEGRAL_LIMIT clamp only
+#define ANTI_WINDUP_CONDITIONAL     1              //stop integrating while the duty is saturated and the error would push it further
+#define ANTI_WINDUP_BACK_CALCULATION 2             //feed the difference between requested and applied duty back into the integrator
+//tools/benchmark.py, mean of noise seeds 1-8   startup  load_step_up  input_dip  forced_trip settling
+//  CLAMP                                       92mV     110mV         3991mV     999ms
+//  CONDITIONAL                                 82mV     126mV         1099mV     243ms
+//  BACK_CALCULATION                            101mV    118mV         1104mV     239ms
+//the step results are within the seed to seed spread (approx 50-130mV), only saturation (input_dip, which holds the duty
+//at MAX_DUTY, and the forced trip) separates the methods. Conditional recovers as well as back calculation without its
+//64 bit shift each control period. The 1.1V left on input_dip is the loop following the input ramp
+#define ANTI_WINDUP_METHOD          ANTI_WINDUP_CONDITIONAL
+#define BACK_CALCULATION_SHIFT      1u             //tracking gain of 1/(2^1), half of the excess duty is removed from the integrator each period
+    
+//soft start - after a restart the duty limit ramps from MIN_DUTY up to MAX_DUTY rather than allowing full duty immediately
+#define SOFT_START_STEP             1u             //percent increase in the duty limit per control period (245Hz), 1 gives 80 steps = 0.33s
     
 //voltage mode specific settings    
 #define TARGET_VOLTAGE_MV_1         12000u         //target voltage in millivolts
 #define TARGET_VOLTAGE_MV_2         16000u         //option to change target voltage for step response using CL_Enable Jumper
+#if DESIGN_SPEC_ENABLED == 0
 #define VOLTAGE_MODE_CONTROL_PERIOD 79u            //79 corresponds to 100kHz
 #define VOLTAGE_MODE_KP             2u             //GAIN OF 2/(2^9) = 0.01757 tuned using ziegler nichols
 #define VOLTAGE_MODE_KP_EXPONENT    9u
 #define VOLTAGE_MODE_KI             36u            //GAIN OF 36/(2^7) = 0.2812 tuned using ziegler nichols
 #define VOLTAGE_MODE_KI_EXPONENT    7u              
+#endif
+    
+//droop - the voltage target is lowered in proportion to the filtered IL, a virtual output resistance, so converters in
+//parallel share the load rather than the one with the highest setpoint taking it all. Active sharing (Share.h) trims
+//the target on top of this
+#define DROOP_ENABLED               0
+#define DROOP_MILLIOHMS             100u           //virtual output resistance, 100mOhm drops 200mV at 2A
+#define DROOP_EXPONENT              10u
+#define DROOP_GAIN                  ((DROOP_MILLIOHMS * 1024u + 500u) / 1000u)     //mV = mA * mOhm / 1000 = (mA * gain) >> 10
+    
+//feed forward - the voltage mode PI output is added to the nominal duty Vref / Vin (InputVoltage.h) rather than the fixed
+//PID_OFFSET, so the integrator only corrects for losses and a change of input voltage is corrected by the next control period
+//without Vin sensing the nominal duty uses VIN_NOMINAL_MV, which is only right if the supply matches, so it follows VIN_SENSE_ENABLED.
+//set to 1 with Vin sensing off only after confirming VIN_NOMINAL_MV for the supply fitted
+#define VOLTAGE_FEEDFORWARD_ENABLED VIN_SENSE_ENABLED
+    
+//current balance for the interleaved converter (PWM.h) - the difference between the phase currents is integrated into a
+//duty correction for phase 2, limited to BALANCE_LIMIT counts so a failed sensor cannot move the phases far apart
+#define BALANCE_SHIFT               5u             //phase current difference in mA is divided by 2^5 before integrating
+#define BALANCE_EXPONENT            6u             //1 duty count of correction per 2^6 integrated units
+#define BALANCE_LIMIT               8              //max phase 2 correction in duty counts, approx 2.5% at PR2 = 79
+    
+//voltage mode algorithm - PI, or predictive which uses the observer model (Vout = d * Vin - losses) to calculate the duty
+//that moves the output a fixed fraction 1/2^n of the way to the reference each control period. The error decays
+//geometrically by (1 - 1/2^n) per period rather than closing in a fixed number of periods
+#define VOLTAGE_MODE_PI             0
+#define VOLTAGE_MODE_PREDICTIVE     1
+#define VOLTAGE_MODE_ALGORITHM      VOLTAGE_MODE_PI
+#define PREDICTIVE_HORIZON_SHIFT    2u             //n, 1/4 of the error is closed each control period, 3/4 remains: 32% after 4 periods
+                                                   //(16ms), 10% after 8 and 1% after 16 (64ms). Lower n is faster and less damped
+#define PREDICTIVE_CURRENT_LIMIT_MA 5000           //the target voltage is reduced so the predicted load current stays below this
+    
+#if (VOLTAGE_MODE_ALGORITHM == VOLTAGE_MODE_PREDICTIVE) && (OBSERVER_ENABLED == 0)
+#error "VOLTAGE_MODE_PREDICTIVE requires OBSERVER_ENABLED"
+#endif
+#if (VOLTAGE_MODE_ALGORITHM == VOLTAGE_MODE_PREDICTIVE) && (CONTROL_METHOD == CCCV_MODE_CONTROL)
+#error "CCCV_MODE_CONTROL uses the voltage mode PI loop, set VOLTAGE_MODE_PI"
+#endif
         
-//unused - current mode control code is not tested or prepared
-#define TARGET_CURRENT_MA_1         0u             //target current in milliamps
-#define TARGET_CURRENT_MA_2         0u             //option to change target current for step response using CL_Enable Jumper
-#define CURRENT_MODE_CONTROL_PERIOD 79u            //79 corresponds to 100kHz
-#define CURRENT_MODE_KP             10u
-#define CURRENT_MODE_KP_EXPONENT    0u
-#define CURRENT_MODE_KI             0u 
-#define CURRENT_MODE_KI_EXPONENT    10u
+//current mode settings, the current loop is also the current limit in CC/CV. The gains are starting values for a
+//resistive load, one duty count moves a 6 ohm load by approx 12mA at 24V, so tune them on the bench for the load used
+#define TARGET_CURRENT_MA_1         2000u          //target current in milliamps
+#define TARGET_CURRENT_MA_2         1000u          //option to change target current for step response using CL_Enable Jumper
+#define CURRENT_MODE_CONTROL_PERIOD 79u            //79 corresponds to 100kHz, must match VOLTAGE_MODE_CONTROL_PERIOD for CC/CV
+#define CURRENT_MODE_KP             13u            //GAIN OF 13/(2^8) = 0.0508 duty counts per mA
+#define CURRENT_MODE_KP_EXPONENT    8u
+#define CURRENT_MODE_KI             64u            //GAIN OF 64/(2^7) = 0.5 duty counts per mA second
+#define CURRENT_MODE_KI_EXPONENT    7u
+    
+//CC/CV - the voltage and current PI loops run every control period around the same feed forward duty, and the lower of
+//the two duty requests is applied, so the output regulates voltage until the current reaches its target, then current.
+//The integrator of the loop not in control tracks the applied duty, it is pulled down whenever it would take that loop
+//above it, so the loop takes over exactly as its error reaches 0 with no windup to unwind and no overshoot.
+//The state follows the loop in control: voltageModeControl (CV) or currentModeControl (CC)
+#define CCCV_STATE_DEBOUNCE         4u             //control periods a loop must be in control before the state changes, 16ms
+    
+#if (CONTROL_METHOD == CCCV_MODE_CONTROL) && (CURRENT_MODE_CONTROL_PERIOD != VOLTAGE_MODE_CONTROL_PERIOD)
+#error "CC/CV needs the same period for both loops"
+#endif
+    
+//the output voltage is oversampled, 4^n conversions are taken per sample and decimated by 2^n to give 10 + n bits
+#define VSENSOR_OVERSAMPLE_EXPONENT 2u       //n, 2 takes 16 conversions (approx 250us) per sample giving 12 bits, max 3 (MAX_OVERSAMPLE_EXPONENT)
     
 //the output voltage is scaled according to rawValue = Vout * (100k/(100k+390k)) * 1024/5 
 //to obtain milli volts from the raw value, mV = rawValue * 5/1024 * ((100k+390k)/100k) * 1000 = * 23.925 = (rawValue * 6100) >> 8, no offset required
+//the oversampled value has n extra bits so the exponent is increased by n, at 12 bits this is 5.98mV per LSB
+#if DESIGN_SPEC_ENABLED == 0
 #define VOLTAGE_SENSOR_GAIN         6100u
-#define VOLTAGE_SENSOR_EXPONENT     8u
-#define VOLTAGE_SENSOR_OFFSET       0u
+#define VOLTAGE_SENSOR_EXPONENT     (8u + VSENSOR_OVERSAMPLE_EXPONENT)
+#endif
+#define VOLTAGE_SENSOR_OFFSET       0u          //in oversampled LSBs
+    
+#if VSENSOR_OVERSAMPLE_EXPONENT > 3u
+#error "VSENSOR_OVERSAMPLE_EXPONENT above 3 overflows the 16 bit oversampling sum"
+#endif
     
 #define SIZE_OF_VSENSOR_FILTER      16u      //size of FIFO filter, must be a power of 2, also change VSENSOR_SHIFT accordingly
 #define VSENSOR_SHIFT               4u       //squareroot(SIZE_OF_VSENSOR_FILTER) = 4
     
-uint16_t filteredVout = 0;                  //filtered Vout measurements and FIFO
-uint16_t voutFIFO[SIZE_OF_VSENSOR_FILTER];
+__bank(1) uint16_t voutFIFO[SIZE_OF_VSENSOR_FILTER];      //Vout FIFO, filtered value is held in hotState
 
-typedef struct controllerVariables{         //template for control method variables       
+struct controllerVariables{                 //template for control method variables       
     int16_t error;
     int32_t integral;
     int32_t proportionalOutput;
@@ -72,16 +161,31 @@ typedef struct controllerVariables{         //template for control method variab
     int64_t integralOutputScaled;
     int32_t sumOutput;
     int16_t previousError;           
+    int16_t saturation;              //requested duty minus applied duty from the last control period, 0 when not limited
 };
 
-int64_t integratorScaledLimit = 0;          //variable for integrator limit scaled up, calculated in controller initialisation function
+uint16_t currentTargetMilliAmps = 0;        //0 follows the jumper (TARGET_CURRENT_MA_1/2), otherwise set by COMMAND_ID_SET_CURRENT
+bool cccvCurrentSelected = 0;               //the current loop gave the lower duty in the last control period
+uint8_t cccvStateCount = 0;                 //control periods the loop in control has differed from the state
+int16_t balanceIntegral = 0;                //integrated phase current difference, scaled by BALANCE_EXPONENT
+uint8_t softStartLimit = MAX_DUTY;          //present duty limit in %, ramped up from MIN_DUTY after startSoftStart()
 
 uint16_t readFilteredVout();
 int16_t convertRawToMilliVolts(uint16_t rawValue);
 void controlRoutine();
 void runCurrentModeControl();
 void runVoltageModeControl();
+int16_t runPredictiveControl();
+int16_t runConstantCurrentConstantVoltage();
+int16_t calculateVoltageTarget();
+void trackIntegrator(struct controllerVariables *loop, int16_t integralLimit, uint8_t exponent);
+void setCurrentTarget(uint16_t milliAmps);
+uint16_t calculateOffsetDuty(uint16_t milliVolts, uint8_t period);
+void runCurrentBalance();
 void initialiseController();
+void startSoftStart();
+void preloadController();
+void prefillVoutFilter();
 
 #ifdef	__cplusplus
 }
@@ -10,17 +10,22 @@
 #include "GPIO.h"
 #include "ADC.h"
 #include "StateMachine.h"
+#include "FaultManager.h"
+#include "FixedPoint.h"
+#include "Scope.h"
+#include "Controller.h"
+#include "Potentiometer.h"
 
 /*------------------------------------------------------------------------------
  Function: initialiseCurrentSensors()
  *Use: This function initialises the pins required for the current sensors
 ------------------------------------------------------------------------------*/
 void initialiseCurrentSensors(){
-    initialiseGPIO(gpioCurrentTripIL, GPIO_Input);
-    initialiseGPIO(gpioCurrentTripIDS, GPIO_Input);
-    initialiseADCPin(gpioIDSCurrent);
-    initialiseADCPin(gpioILCurrent);
-    initialiseGPIO(gpioOverCurrentClear, GPIO_Output);
+    GPIO_SET_INPUT(gpioCurrentTripIL);
+    GPIO_SET_INPUT(gpioCurrentTripIDS);
+    ADC_INIT_PIN(gpioIDSCurrent);
+    ADC_INIT_PIN(gpioILCurrent);
+    GPIO_SET_OUTPUT(gpioOverCurrentClear);
     currentTripReset();        //initially set to 0 to turn off MOSFET and clear overcurrent faults 
 }
 
@@ -29,23 +34,44 @@ void initialiseCurrentSensors(){
  *Use: This function reads the current trip digital IO to detect overcurrent
 ------------------------------------------------------------------------------*/
 bool currentTripRead(){
-    tripIDS = ~readGPIO(gpioCurrentTripIDS); //flags as 1 if there has been an IDS trip
-    tripIL = ~readGPIO(gpioCurrentTripIL);   //flags as 1 if there has been an IL trip
-    return (tripIL || tripIDS);    //if either pin drops to 0, giving a flag of 1, a fault has occurred, return 1
+    hotState.tripIDS = !GPIO_READ(gpioCurrentTripIDS); //flags as 1 if there has been an IDS trip
+    hotState.tripIL = !GPIO_READ(gpioCurrentTripIL);   //flags as 1 if there has been an IL trip
+    return (hotState.tripIL || hotState.tripIDS);    //if either pin drops to 0, giving a flag of 1, a fault has occurred, return 1
+}
+
+/*------------------------------------------------------------------------------
+ Function: prefillCurrentFilters()
+ *Use: This function fills the current FIFOs with a burst of real samples so
+ * the filtered values are valid from the first slot. The IL sample is also
+ * stored as the latest IL, which is otherwise only updated by the CCP1 sample
+------------------------------------------------------------------------------*/
+void prefillCurrentFilters(){
+    for(uint8_t i=0; i<SIZE_OF_ISENSOR_FILTER; i++){
+        hotState.latestIL = ADC_READ(gpioILCurrent);
+        hotState.filteredIL = readFilteredIL();
+#if IDS_FILTER_ENABLED
+        hotState.filteredIDS = readFilteredIDS();
+#endif
+    }
 }
 
 /*------------------------------------------------------------------------------
  Function: readFilteredIDS()
  *Use: This function obtains a new ADC sample and performs the moving average 
- * FIFO filter for the IDS sensor, returning the filtered value
+ * FIFO filter for the IDS sensor, returning the filtered value. Returns 0
+ * when nothing reads the IDS filter and its FIFO is removed
 ------------------------------------------------------------------------------*/
 uint16_t readFilteredIDS(){
+#if IDS_FILTER_ENABLED
     for(uint8_t i=0; i<SIZE_OF_ISENSOR_FILTER-1; i++) currentIDSFIFO[i] = currentIDSFIFO[i+1];   //shift all values in array to next 
-    currentIDSFIFO[SIZE_OF_ISENSOR_FILTER-1] =  readADCRaw(gpioIDSCurrent);     //take the newest sample
+    currentIDSFIFO[SIZE_OF_ISENSOR_FILTER-1] =  ADC_READ(gpioIDSCurrent);       //take the newest sample
     uint32_t sumOfSamples = 0;
     for(uint8_t i=0; i<SIZE_OF_ISENSOR_FILTER; i++) sumOfSamples += currentIDSFIFO[i];     //sum all samples 
     
     return (sumOfSamples >> ISENSOR_SHIFT); //shift bits to divide by number of samples to get mean
+#else
+    return 0;
+#endif
 }
 
 /*------------------------------------------------------------------------------
@@ -55,7 +81,7 @@ uint16_t readFilteredIDS(){
 ------------------------------------------------------------------------------*/
 uint16_t readFilteredIL(){
     for(uint8_t i=0; i<SIZE_OF_ISENSOR_FILTER-1; i++) currentILFIFO[i] = currentILFIFO[i+1];  //shift all values in array to next 
-    currentILFIFO[SIZE_OF_ISENSOR_FILTER-1] =  latestIL;   //take the newest sample from interrupt
+    currentILFIFO[SIZE_OF_ISENSOR_FILTER-1] =  hotState.latestIL;   //take the newest sample from interrupt
     uint32_t sumOfSamples = 0;     
     for(uint8_t i=0; i<SIZE_OF_ISENSOR_FILTER; i++) sumOfSamples += currentILFIFO[i];   //sum all samples
     
@@ -69,9 +95,9 @@ uint16_t readFilteredIL(){
  * before turning them back on again
 ------------------------------------------------------------------------------*/
 void currentTripReset(){
-    writeGPIO(gpioOverCurrentClear, 0);
+    GPIO_WRITE(gpioOverCurrentClear, 0);
      __delay_us(20);
-    writeGPIO(gpioOverCurrentClear, 1); 
+    GPIO_WRITE(gpioOverCurrentClear, 1); 
 }
 
 /*------------------------------------------------------------------------------
@@ -81,30 +107,47 @@ void currentTripReset(){
 ------------------------------------------------------------------------------*/
 int16_t convertRawToMilliAmps(uint16_t rawValue){
     int16_t offsetted = (int16_t)(rawValue - CURRENT_SENSOR_OFFSET); //subtract the offset to obtain a neg or pos value, include any calibration offset 
-    int16_t returnValuemA = (int32_t)(offsetted * CURRENT_SENSOR_GAIN) >> CURRENT_SENSOR_EXPONENT;
-    return returnValuemA;
+    return mulShiftSigned(offsetted, CURRENT_SENSOR_GAIN, CURRENT_SENSOR_EXPONENT);     //widened to 32 bits, offsetted * 3125 wraps 16 bits above 10 LSBs
 }
 
 /*------------------------------------------------------------------------------
  Function: currentTripMonitor()
  *Use: This function monitors for current trips and counts consecutive trip
- *  faults resets the chip for a number less than CURRENT_TRIP_LIMIT, otherwise
- *  transitions to a overcurrent fault in the state machine
+ *  faults resets the chip for a number less than CURRENT_TRIP_LIMIT and restarts
+ *  the output from 0, otherwise records the fault and transitions to a
+ *  overcurrent fault in the state machine
 ------------------------------------------------------------------------------*/
-int16_t currentTripMonitor(){
+void currentTripMonitor(){
     
         if(currentTripRead() == 1){
-        currentTripCount++;
-        if(currentTripCount == CURRENT_TRIP_LIMIT){               
+        hotState.currentTripCount++;
+        if(hotState.currentTripCount == CURRENT_TRIP_LIMIT){               
+#if INTERLEAVED_ENABLED == 1
+            if(hotState.tripIDS && !hotState.tripIL && phase2Enabled){        //phase 2 alone, shed it and carry on with phase 1
+                recordFault(faultPhase2Shed);
+                enablePhase2(0);
+                hotState.currentTripCount = 0;
+                currentTripReset();
+                return;
+            }
+#endif
+            triggerScope(scopeTriggerCurrentTrip);                                    //sampled later this tick, before the output has decayed
+            if(hotState.tripIL && hotState.tripIDS) recordFault(faultTripBoth);       //record the fault before the PWM is cleared
+            else if(hotState.tripIL) recordFault(faultTripIL);
+            else recordFault(faultTripIDS);
             transToOverCurrentFault();
         }
         else{
             currentTripReset();
+            restartOutput();                //the trip cut the output, so ramp back up rather than resume at the held duty
         }
     }
     else{
-        if(currentTripCount > 0){       //decrement the counter to 0 when no trips have occurred
-            currentTripCount--;
+        //decrement the counter to 0 when no trips have occurred, held while the output ramps back up after a restart so
+        //trips on each restart (an output short) still reach the limit rather than decaying between them
+        bool restarting = potHandover || ((currentState != potControl) && (softStartLimit < MAX_DUTY));
+        if((hotState.currentTripCount > 0) && !restarting){
+            hotState.currentTripCount--;
         }
     }
 }
\ No newline at end of file
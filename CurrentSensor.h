@@ -18,6 +18,9 @@ extern "C" {
 #include <stdbool.h>
 #include <stdint.h>   
 #include "Global.h"
+#include "PWM.h"
+#include "InputVoltage.h"
+#include "Energy.h"
 
 //the current sensor conversion formula is Vout = Voff + Iin x 400mV/A, where Voff = 2.5
 //to avoid floats, we can use gains and exponent to reduce memory consumption
@@ -27,9 +30,11 @@ extern "C" {
 //current (mA) = (ADC_value - 512) * 12.207
 //gain of 3125, exponent of 8, gives real gain of 12.20703
 //use signed ints as the calculated value can be negative   
+#if DESIGN_SPEC_ENABLED == 0
 #define CURRENT_SENSOR_GAIN         3125u 
 #define CURRENT_SENSOR_EXPONENT     8u
 #define CURRENT_SENSOR_OFFSET       512u 
+#endif
     
 #define SIZE_OF_ISENSOR_FILTER      16u     //size of FIFO filter, must be a power of 2, also change ISENSOR_SHIFT accordingly
 #define ISENSOR_SHIFT               4u      //squareroot(SIZE_OF_ISENSOR_FILTER) = 4  
@@ -37,25 +42,23 @@ extern "C" {
 #define CURRENT_TRIP_LIMIT  3u              //max number of consecutive current trips before transitioning to a fault
                                             //allow >1 as switching inductor and turn on with high duty cycle causes overcurrent due to inrush but this is OK
     
-volatile uint16_t latestIL = 0;             //variable containing latest IL1 sample, which is read once per PWM cycle if CCP1 interrupt used
-
-uint16_t filteredIDS = 0;                   //filtered current measurements and FIFO
-uint16_t filteredIL = 0;
-uint16_t currentIDSFIFO[SIZE_OF_ISENSOR_FILTER];
-uint16_t currentILFIFO[SIZE_OF_ISENSOR_FILTER];
-
-bool tripIDS = 0;
-bool tripIL = 0;
-
-//variable counting number of consecutive current trips
-uint8_t currentTripCount = 0;
+//the filtered IDS is only read for the phase 2 current or the energy meter input current, otherwise its FIFO is removed
+#define IDS_FILTER_ENABLED          ((INTERLEAVED_ENABLED == 1) || ((ENERGY_METER_ENABLED == 1) && ENERGY_INPUT_ENABLED))
+    
+//latest IL sample, filtered values, trip flags and the consecutive trip count are held in hotState (HotState.h)
+#if IDS_FILTER_ENABLED
+__bank(1) uint16_t currentIDSFIFO[SIZE_OF_ISENSOR_FILTER];      //current measurement FIFOs
+#endif
+__bank(3) uint16_t currentILFIFO[SIZE_OF_ISENSOR_FILTER];
 
 void initialiseCurrentSensors();
 bool currentTripRead();
 uint16_t readFilteredIDS();
 uint16_t readFilteredIL();
 void currentTripReset();
+void prefillCurrentFilters();
 int16_t convertRawToMilliAmps(uint16_t rawvalue);
+void currentTripMonitor();
 
 
 
@@ -0,0 +1,51 @@
+/* 
+ * File:   DesignSpec.h
+ * Author: tools/design_spec.py
+ *
+ * Generated from tools/specs/default.ini, do not edit, regenerate from the spec instead
+ */
+
+#ifndef DESIGNSPEC_H
+#define	DESIGNSPEC_H
+
+//used in place of the hand set values in the module headers when DESIGN_SPEC_ENABLED (Global.h)
+#define VOLTAGE_MODE_CONTROL_PERIOD 79u                     //100.0kHz
+#define MIN_PERIOD_FROM_POT         15u                     //500.0kHz
+#define MAX_PERIOD_FROM_POT         159u                    //50.0kHz
+#define DT_GAIN                     268u                    //0.004096s, control at 244.14Hz, -0.16%
+#define DT_EXPONENT                 16u
+#define VOLTAGE_MODE_KP             144u                    //0.01757 duty counts per mV, +0.05%
+#define VOLTAGE_MODE_KP_EXPONENT    13u
+#define VOLTAGE_MODE_KI             144u                    //0.2812 duty counts per mV second, +0.02%
+#define VOLTAGE_MODE_KI_EXPONENT    9u
+#define VOLTAGE_SENSOR_GAIN         6125u                   //23.9258mV per 10 bit LSB, +0.000%
+#define VOLTAGE_SENSOR_EXPONENT     (8u + VSENSOR_OVERSAMPLE_EXPONENT)
+#define VIN_SENSOR_GAIN             8250u                   //32.2266mV per 10 bit LSB, +0.000%
+#define VIN_SENSOR_EXPONENT         (8u + VIN_OVERSAMPLE_EXPONENT)
+#define VIN_NOMINAL_MV              24000u
+#define CURRENT_SENSOR_GAIN         3125u                   //12.2070mA per LSB, +0.000%
+#define CURRENT_SENSOR_EXPONENT     8u
+#define CURRENT_SENSOR_OFFSET       512u                    //2.500V
+#define OBSERVER_A_IL_IL            (-144)                  //-0.03508
+#define OBSERVER_A_IL_VC            (-209)                  //-0.05105
+#define OBSERVER_A_IL_LOAD          4219                    //1.02997
+#define OBSERVER_B_IL_LAST          (-995)                  //-0.24290
+#define OBSERVER_B_IL_NEW           1204                    //0.29395
+#define OBSERVER_A_VC_IL            95                      //0.02320
+#define OBSERVER_A_VC_VC            (-112)                  //-0.02742
+#define OBSERVER_A_VC_LOAD          (-516)                  //-0.12595
+#define OBSERVER_B_VC_LAST          558                     //0.13630
+#define OBSERVER_B_VC_NEW           3650                    //0.89112
+#define OBSERVER_K_IL_VOUT          (-2226)                 //-0.54353
+#define OBSERVER_K_IL_IL            630                     //0.15390
+#define OBSERVER_K_VC_VOUT          1622                    //0.39607
+#define OBSERVER_K_VC_IL            (-24)                   //-0.00584
+#define OBSERVER_K_LOAD_VOUT        (-4122)                 //-1.00631
+#define OBSERVER_K_LOAD_IL          402                     //0.09816
+#define OBSERVER_K_LOSS_VOUT        (-156)                  //-0.03816
+#define OBSERVER_K_LOSS_IL          (-13)                   //-0.00323
+#define OBSERVER_ESR_GAIN           205u                    //50mOhm
+#define OBSERVER_DCR_GAIN           410u                    //100mOhm
+#define OBSERVER_GAIN_EXPONENT      12u
+
+#endif	/* DESIGNSPEC_H */
@@ -0,0 +1,95 @@
+/* 
+ * File:   Energy.c
+ * Author: agent
+ *
+ * Created on 19 October 2026, 11:43
+ */
+
+#include "Global.h"
+#include "Energy.h"
+#include "Controller.h"
+#include "CurrentSensor.h"
+#include "InputVoltage.h"
+#include "Telemetry.h"
+
+/*------------------------------------------------------------------------------
+ Function: calculatePowerMilliWatts(milliVolts, milliAmps)
+ *Use: This function returns the power in mW, negative voltage or current
+ * (reverse current at light load) is counted as 0 so the energy only counts up
+------------------------------------------------------------------------------*/
+uint16_t calculatePowerMilliWatts(int16_t milliVolts, int16_t milliAmps){
+    if((milliVolts <= 0) || (milliAmps <= 0)) return 0;
+    uint32_t product = ((uint32_t) milliVolts * (uint16_t) milliAmps) >> POWER_PRE_SHIFT;
+    product = (product * POWER_GAIN) >> POWER_EXPONENT;
+    if(product > 0xFFFFu) return 0xFFFFu;
+    return (uint16_t) product;
+}
+
+/*------------------------------------------------------------------------------
+ Function: addEnergySample(meter, power)
+ *Use: This function adds one slot 2 sample of power to the energy count and
+ * the rolling average
+------------------------------------------------------------------------------*/
+void addEnergySample(struct energyMeter *meter, uint16_t power){
+    meter->remainder += (uint32_t) power * DT_GAIN;
+    if(meter->remainder >= ENERGY_JOULE_SCALED){         //at most 65.5W x 1/245s = 267mJ per sample, so once is enough
+        meter->remainder -= ENERGY_JOULE_SCALED;
+        meter->joules++;
+    }
+    meter->averagePower = (uint16_t) ((int32_t) meter->averagePower + (((int32_t) power - meter->averagePower) >> ENERGY_AVERAGE_SHIFT));
+}
+
+/*------------------------------------------------------------------------------
+ Function: runEnergyMeter()
+ *Use: This function is called from slot 2 after the filters, it integrates
+ * the output power, and the input power when Vin is measured
+------------------------------------------------------------------------------*/
+void runEnergyMeter(){
+#if ENERGY_METER_ENABLED == 1
+    addEnergySample(&outputEnergy, calculatePowerMilliWatts(convertRawToMilliVolts(hotState.filteredVout), convertRawToMilliAmps(hotState.filteredIL)));
+#if ENERGY_INPUT_ENABLED
+    addEnergySample(&inputEnergy, calculatePowerMilliWatts((int16_t) readInputMilliVolts(), convertRawToMilliAmps(hotState.filteredIDS)));
+#endif
+#endif
+}
+
+/*------------------------------------------------------------------------------
+ Function: sendEnergyTelemetry()
+ *Use: This function queues the energy telemetry frame, the efficiency is
+ * calculated here in the main loop as it needs a division, and is 0 without
+ * input metering or input power
+ * payload: output J (4), input J (4), average output mW (2), average input mW
+ * (2), efficiency in 0.1% (2), all big endian
+------------------------------------------------------------------------------*/
+void sendEnergyTelemetry(){
+#if ENERGY_METER_ENABLED == 1
+    uint8_t payload[14];
+    
+    INTCONbits.GIE = 0;
+    uint32_t outputJoules = outputEnergy.joules;
+    uint32_t inputJoules = inputEnergy.joules;
+    uint16_t outputPower = outputEnergy.averagePower;
+    uint16_t inputPower = inputEnergy.averagePower;
+    INTCONbits.GIE = 1;
+    
+    uint16_t efficiency = 0;
+    if(inputPower > 0) efficiency = (uint16_t) (((uint32_t) outputPower * 1000u) / inputPower);
+    
+    payload[0] = (uint8_t) (outputJoules >> 24);
+    payload[1] = (uint8_t) (outputJoules >> 16);
+    payload[2] = (uint8_t) (outputJoules >> 8);
+    payload[3] = (uint8_t) outputJoules;
+    payload[4] = (uint8_t) (inputJoules >> 24);
+    payload[5] = (uint8_t) (inputJoules >> 16);
+    payload[6] = (uint8_t) (inputJoules >> 8);
+    payload[7] = (uint8_t) inputJoules;
+    payload[8] = (uint8_t) (outputPower >> 8);
+    payload[9] = (uint8_t) outputPower;
+    payload[10] = (uint8_t) (inputPower >> 8);
+    payload[11] = (uint8_t) inputPower;
+    payload[12] = (uint8_t) (efficiency >> 8);
+    payload[13] = (uint8_t) efficiency;
+    
+    queueTelemetryFrame(TELEMETRY_ID_ENERGY, payload, sizeof(payload));
+#endif
+}
@@ -0,0 +1,56 @@
+/* 
+ * File:   Energy.h
+ * Author: agent
+ *
+ * Created on 19 October 2026, 11:43
+ */
+
+#ifndef ENERGY_H
+#define	ENERGY_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "Global.h"
+
+//energy metering - output power (Vout x IL) is integrated each slot 2 (245Hz) from the filtered values, and input power
+//(Vin x IDS) as well when Vin is measured (InputVoltage.h). IDS is the high side switch current, whose average is the
+//buck input current, so input metering is not available with the interleaved converter where IDS measures phase 2
+//energy is held in whole joules with the remainder carried, so no energy is lost to rounding, 32 bits holds 136 years at 1W
+#define ENERGY_METER_ENABLED        0       //1 enables the energy meter and its telemetry frame, 0 removes the code
+#define ENERGY_AVERAGE_SHIFT        6u      //rolling average power filter of 1/(2^6), approx 0.26s time constant
+#define ENERGY_INPUT_ENABLED        ((VIN_SENSE_ENABLED == 1) && (INTERLEAVED_ENABLED == 0))
+    
+//power in mW = mV * mA / 1000, done as ((mV * mA) >> 7) * 131 >> 10 to avoid a division, 131 / 2^17 = 0.0009995
+#define POWER_GAIN                  131u
+#define POWER_PRE_SHIFT             7u
+#define POWER_EXPONENT              10u
+//energy per sample in mJ = mW * (1/245)s, using DT_GAIN / 2^DT_EXPONENT (Controller.h), one joule is 1000 << DT_EXPONENT
+#define ENERGY_JOULE_SCALED         (1000UL << DT_EXPONENT)
+
+struct energyMeter{
+    uint32_t joules;                //energy since power on
+    uint32_t remainder;             //part of a joule, scaled by 2^DT_EXPONENT
+    uint16_t averagePower;          //rolling average power in mW
+};
+
+#if ENERGY_METER_ENABLED == 1
+struct energyMeter outputEnergy = {0, 0, 0};
+struct energyMeter inputEnergy = {0, 0, 0};
+#endif
+
+void runEnergyMeter();
+void addEnergySample(struct energyMeter *meter, uint16_t power);
+uint16_t calculatePowerMilliWatts(int16_t milliVolts, int16_t milliAmps);
+void sendEnergyTelemetry();
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* ENERGY_H */
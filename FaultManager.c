@@ -0,0 +1,189 @@
+/* 
+ * File:   FaultManager.c
+ * Author: agent
+ *
+ * Created on 19 October 2026, 11:25
+ */
+
+#include "Global.h"
+#include "FaultManager.h"
+#include "StateMachine.h"
+#include "CurrentSensor.h"
+#include "Controller.h"
+#include "Telemetry.h"
+#include "Timer0.h"
+#include "PWM.h"
+#include "Potentiometer.h"
+
+/*------------------------------------------------------------------------------
+ Function: initialiseFaultManager()
+ *Use: This function restores the trip counts and log position from EEPROM,
+ * an erased or corrupt header (head out of range) starts a fresh log
+------------------------------------------------------------------------------*/
+void initialiseFaultManager(){
+#if FAULT_LOG_ENABLED == 1
+    faultLogHead = eeprom_read(FAULT_LOG_BASE_ADDRESS);
+    if(faultLogHead >= FAULT_LOG_SIZE){             //erased EEPROM reads 0xFF
+        faultLogHead = 0;
+        faultCountIL = 0;
+        faultCountIDS = 0;
+        for(uint8_t i = 0; i < FAULT_LOG_HEADER_SIZE; i++) eeprom_write(FAULT_LOG_BASE_ADDRESS + i, 0);
+    }
+    else{
+        faultCountIL = ((uint16_t) eeprom_read(FAULT_LOG_BASE_ADDRESS + 1u) << 8) | eeprom_read(FAULT_LOG_BASE_ADDRESS + 2u);
+        faultCountIDS = ((uint16_t) eeprom_read(FAULT_LOG_BASE_ADDRESS + 3u) << 8) | eeprom_read(FAULT_LOG_BASE_ADDRESS + 4u);
+    }
+#endif
+}
+
+/*------------------------------------------------------------------------------
+ Function: recordFault(type)
+ *Use: This function is called from the interrupt when the trip limit is
+ * reached, before the PWM is cleared. It captures the fault record, updates
+ * the counts and schedules the restart backoff, the EEPROM write is left to
+ * the main loop as each byte takes several ms
+------------------------------------------------------------------------------*/
+void recordFault(enum faultType type){
+    
+    if(IS_FAULT_STATE(currentState)) return;            //already handling a fault
+    
+    lastFault.type = type;
+    lastFault.tick = hotState.tickCount;
+    lastFault.duty = hotState.setDuty;
+    lastFault.vout = hotState.filteredVout;
+    if((type == faultTripIL) || (type == faultTripBoth)) faultCountIL++;
+    if((type == faultTripIDS) || (type == faultTripBoth)) faultCountIDS++;
+    faultLogPending = 1;
+    if(type == faultPhase2Shed){
+        faultCountIDS++;
+        return;                                         //converter keeps running on phase 1, no restart needed
+    }
+    
+    faultReturnState = currentState;
+    faultClearTicks = 0;
+    
+#if FAULT_RETRY_ENABLED == 1
+    if(faultRetryCount >= FAULT_RETRY_LIMIT) faultLatched = 1;     //too many consecutive faults, stay off
+    else{
+        faultBackoffTicks = FAULT_RETRY_BASE_TICKS << faultRetryCount;     //exponential backoff
+        faultRetryCount++;
+    }
+#else
+    faultLatched = 1;
+#endif
+}
+
+/*------------------------------------------------------------------------------
+ Function: runFaultManager()
+ *Use: This function is called from the interrupt every tick. While in a fault
+ * it counts down the backoff and then resets the trip and restarts into the
+ * state active before the fault, through restartOutput(). After a restart has run
+ * fault free for FAULT_RETRY_CLEAR_TICKS the consecutive count is cleared
+------------------------------------------------------------------------------*/
+void runFaultManager(){
+    
+    if(IS_FAULT_STATE(currentState)){
+        if(faultLatched) return;
+        
+        if(faultBackoffTicks > 0) faultBackoffTicks--;
+        else{
+            hotState.currentTripCount = 0;
+            currentTripReset();
+            faultClearTicks = FAULT_RETRY_CLEAR_TICKS;
+            
+            switch(faultReturnState){
+                case potControl:         transToPotControl();         break;
+                case voltageModeControl: transToVoltageModeControl(); break;
+                case currentModeControl: transToCurrentModeControl(); break;
+                default:                 transToInitialising();       break;
+            }
+            restartOutput();
+        }
+    }
+    else if(faultClearTicks > 0){
+        faultClearTicks--;
+        if(faultClearTicks == 0) faultRetryCount = 0;      //restart was successful
+    }
+}
+
+/*------------------------------------------------------------------------------
+ Function: restartOutput()
+ *Use: This function restarts the output from a duty of 0 after it has been
+ * cut by a fault or a trip, closed loop control through soft start and pot
+ * control through the pot handover ramp, so the restart does not trip again
+ * on the inrush into a discharged output
+------------------------------------------------------------------------------*/
+void restartOutput(){
+    hotState.setDuty = 0;
+    stopSynchronousRectifier();
+    startSoftStart();
+    if(currentState == potControl) startPotHandover();
+}
+
+/*------------------------------------------------------------------------------
+ Function: runFaultLogging()
+ *Use: This function is called from the main loop and writes a pending fault
+ * record and the updated header to the circular EEPROM log
+------------------------------------------------------------------------------*/
+void runFaultLogging(){
+#if FAULT_LOG_ENABLED == 1
+    if(!faultLogPending) return;
+    
+    //take a copy with interrupts disabled so the record is not changed part way through
+    INTCONbits.GIE = 0;
+    struct faultRecord record = lastFault;
+    uint16_t countIL = faultCountIL;
+    uint16_t countIDS = faultCountIDS;
+    faultLogPending = 0;
+    INTCONbits.GIE = 1;
+    
+    uint8_t address = FAULT_LOG_BASE_ADDRESS + FAULT_LOG_HEADER_SIZE + (faultLogHead * FAULT_RECORD_SIZE);
+    eeprom_write(address++, record.type);
+    eeprom_write(address++, (uint8_t) (record.tick >> 24));
+    eeprom_write(address++, (uint8_t) (record.tick >> 16));
+    eeprom_write(address++, (uint8_t) (record.tick >> 8));
+    eeprom_write(address++, (uint8_t) record.tick);
+    eeprom_write(address++, (uint8_t) (record.duty >> 8));
+    eeprom_write(address++, (uint8_t) record.duty);
+    eeprom_write(address++, (uint8_t) (record.vout >> 8));
+    eeprom_write(address, (uint8_t) record.vout);
+    
+    faultLogHead++;
+    if(faultLogHead >= FAULT_LOG_SIZE) faultLogHead = 0;
+    
+    //header is written last so a reset mid write leaves the previous log intact
+    eeprom_write(FAULT_LOG_BASE_ADDRESS + 1u, (uint8_t) (countIL >> 8));
+    eeprom_write(FAULT_LOG_BASE_ADDRESS + 2u, (uint8_t) countIL);
+    eeprom_write(FAULT_LOG_BASE_ADDRESS + 3u, (uint8_t) (countIDS >> 8));
+    eeprom_write(FAULT_LOG_BASE_ADDRESS + 4u, (uint8_t) countIDS);
+    eeprom_write(FAULT_LOG_BASE_ADDRESS, faultLogHead);
+#endif
+}
+
+/*------------------------------------------------------------------------------
+ Function: sendFaultTelemetry()
+ *Use: This function queues the fault statistics telemetry frame
+ * payload: IL count (2), IDS count (2), retry count, latched, last fault type,
+ * last fault tick (4), all big endian
+------------------------------------------------------------------------------*/
+void sendFaultTelemetry(){
+#if TELEMETRY_ENABLED == 1
+    uint8_t payload[11];
+    
+    INTCONbits.GIE = 0;
+    payload[0] = (uint8_t) (faultCountIL >> 8);
+    payload[1] = (uint8_t) faultCountIL;
+    payload[2] = (uint8_t) (faultCountIDS >> 8);
+    payload[3] = (uint8_t) faultCountIDS;
+    payload[4] = faultRetryCount;
+    payload[5] = faultLatched;
+    payload[6] = lastFault.type;
+    payload[7] = (uint8_t) (lastFault.tick >> 24);
+    payload[8] = (uint8_t) (lastFault.tick >> 16);
+    payload[9] = (uint8_t) (lastFault.tick >> 8);
+    payload[10] = (uint8_t) lastFault.tick;
+    INTCONbits.GIE = 1;
+    
+    queueTelemetryFrame(TELEMETRY_ID_FAULTS, payload, sizeof(payload));
+#endif
+}
@@ -0,0 +1,89 @@
+/* 
+ * File:   FaultManager.h
+ * Author: agent
+ *
+ * Created on 19 October 2026, 11:25
+ */
+
+#ifndef FAULTMANAGER_H
+#define	FAULTMANAGER_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <xc.h>                                     //PIC hardware mapping
+#include "Global.h"
+#include "StateMachine.h"
+
+//auto restart settings - after an overcurrent fault the converter waits for a backoff time, resets the trip and restarts
+//through soft start. The backoff doubles for each consecutive fault, and the fault latches once FAULT_RETRY_LIMIT is reached
+#define FAULT_RETRY_ENABLED         1       //1 restarts automatically after a fault, 0 latches every fault until power cycle
+#define FAULT_RETRY_LIMIT           5u      //number of consecutive restarts before the fault is latched
+#define FAULT_RETRY_BASE_TICKS      49u     //backoff before the first restart, 49 ticks of 490Hz = 100ms, doubled for each consecutive fault
+#define FAULT_RETRY_CLEAR_TICKS     2450u   //fault free ticks after a restart before the consecutive count is cleared, 2450 = 5s
+    
+#if (FAULT_RETRY_BASE_TICKS << (FAULT_RETRY_LIMIT - 1u)) > 65535u
+#error "FAULT_RETRY_BASE_TICKS doubled FAULT_RETRY_LIMIT - 1 times must fit in 16 bits"
+#endif
+    
+//persistent fault log - circular log of fault records in data EEPROM, with a header holding the next slot and trip counts
+//EEPROM layout: [head][IL count H][IL count L][IDS count H][IDS count L][record 0]...[record FAULT_LOG_SIZE-1]
+#define FAULT_LOG_ENABLED           1       //1 writes fault records to EEPROM from the main loop, 0 removes the code
+#define FAULT_LOG_SIZE              8u      //number of records held in the circular log
+#define FAULT_LOG_BASE_ADDRESS      0x00u   //EEPROM address of the log header
+#define FAULT_LOG_HEADER_SIZE       5u
+#define FAULT_RECORD_SIZE           9u      //type (1), tick (4), duty (2), raw Vout (2)
+    
+#if (FAULT_LOG_BASE_ADDRESS + FAULT_LOG_HEADER_SIZE + (FAULT_LOG_SIZE * FAULT_RECORD_SIZE)) > 256u
+#error "fault log does not fit in the 256 bytes of data EEPROM"
+#endif
+
+//the list of fault types, a trip on both sensors in the same tick is recorded as faultTripBoth
+enum faultType{
+    faultNone,
+    faultTripIL,
+    faultTripIDS,
+    faultTripBoth,
+    faultPhase2Shed,        //interleaved phase 2 tripped alone and was disabled, logged but not a converter fault
+    faultOverVoltage,       //software protection (Protection.h)
+    faultUnderVoltage,
+    faultShortCircuit
+};
+
+struct faultRecord{
+    uint8_t type;           //enum faultType
+    uint32_t tick;          //tickCount at the time of the trip
+    uint16_t duty;          //setDuty at the time of the trip
+    uint16_t vout;          //raw filtered (oversampled) Vout at the time of the trip
+};
+
+struct faultRecord lastFault = {0, 0, 0, 0};
+uint16_t faultCountIL = 0;                  //lifetime trip counts, restored from EEPROM at start up
+uint16_t faultCountIDS = 0;
+uint8_t faultLogHead = 0;                   //next EEPROM log slot to be written
+volatile bool faultLogPending = 0;          //set in the interrupt when lastFault needs writing to EEPROM by main loop
+
+uint8_t faultRetryCount = 0;                //number of consecutive faults without a successful restart
+uint16_t faultBackoffTicks = 0;             //ticks remaining until the next restart attempt
+uint16_t faultClearTicks = 0;               //ticks remaining until a restart is considered successful
+bool faultLatched = 0;                      //set when no more restarts will be attempted
+enum stateMachine faultReturnState = 0;     //state to return to on restart
+
+void initialiseFaultManager();
+void recordFault(enum faultType type);
+void runFaultManager();
+void restartOutput();
+void runFaultLogging();
+void sendFaultTelemetry();
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* FAULTMANAGER_H */
+
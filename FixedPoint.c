@@ -0,0 +1,66 @@
+/* 
+ * File:   FixedPoint.c
+ * Author: agent
+ *
+ * Created on 19 October 2026, 11:41
+ */
+
+#include "FixedPoint.h"
+
+/*------------------------------------------------------------------------------
+ Function: saturateToInt16(value)
+ *Use: This function limits a 32 bit intermediate result to the int16 range
+------------------------------------------------------------------------------*/
+int16_t saturateToInt16(int32_t value){
+    if(value > FIXED_INT16_MAX) return FIXED_INT16_MAX;
+    if(value < FIXED_INT16_MIN) return FIXED_INT16_MIN;
+    return (int16_t) value;
+}
+
+/*------------------------------------------------------------------------------
+ Function: addSaturated(a, b)
+ *Use: This function returns a + b, limited to the int16 range
+------------------------------------------------------------------------------*/
+int16_t addSaturated(int16_t a, int16_t b){
+    return saturateToInt16((int32_t) a + b);
+}
+
+/*------------------------------------------------------------------------------
+ Function: subSaturated(a, b)
+ *Use: This function returns a - b, limited to the int16 range
+------------------------------------------------------------------------------*/
+int16_t subSaturated(int16_t a, int16_t b){
+    return saturateToInt16((int32_t) a - b);
+}
+
+/*------------------------------------------------------------------------------
+ Function: clampInt16(value, minimum, maximum)
+ *Use: This function limits value to between minimum and maximum
+------------------------------------------------------------------------------*/
+int16_t clampInt16(int16_t value, int16_t minimum, int16_t maximum){
+    if(value > maximum) return maximum;
+    if(value < minimum) return minimum;
+    return value;
+}
+
+/*------------------------------------------------------------------------------
+ Function: mulShiftSigned(value, gain, exponent)
+ *Use: This function returns (value * gain) >> exponent, the multiply is done
+ * in 32 bits, which holds any int16 times uint16 product, and the result is
+ * saturated. Negative values round towards minus infinity, as the shifts in
+ * the rest of the code do
+------------------------------------------------------------------------------*/
+int16_t mulShiftSigned(int16_t value, uint16_t gain, uint8_t exponent){
+    return saturateToInt16(((int32_t) value * gain) >> exponent);
+}
+
+/*------------------------------------------------------------------------------
+ Function: mulShiftUnsigned(value, gain, exponent)
+ *Use: This function returns (value * gain) >> exponent for unsigned values,
+ * saturated to the uint16 range
+------------------------------------------------------------------------------*/
+uint16_t mulShiftUnsigned(uint16_t value, uint16_t gain, uint8_t exponent){
+    uint32_t result = ((uint32_t) value * gain) >> exponent;
+    if(result > 0xFFFFu) return 0xFFFFu;
+    return (uint16_t) result;
+}
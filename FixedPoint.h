@@ -0,0 +1,38 @@
+/* 
+ * File:   FixedPoint.h
+ * Author: agent
+ *
+ * Created on 19 October 2026, 11:41
+ */
+
+#ifndef FIXEDPOINT_H
+#define	FIXEDPOINT_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+//fixed point helpers - int is 16 bits on this compiler, so a 16 bit value times a 16 bit gain wraps unless widened first.
+//the gain and exponent method used for all scaling (see the PIC Controller Code Guide) is done here in 32 bits, and
+//results are saturated to the 16 bit range rather than wrapping, so an out of range sensor reading or controller output
+//gives the largest value instead of a value with the wrong sign
+#define FIXED_INT16_MAX     32767
+#define FIXED_INT16_MIN     (-32767 - 1)
+
+int16_t saturateToInt16(int32_t value);
+int16_t addSaturated(int16_t a, int16_t b);
+int16_t subSaturated(int16_t a, int16_t b);
+int16_t clampInt16(int16_t value, int16_t minimum, int16_t maximum);
+int16_t mulShiftSigned(int16_t value, uint16_t gain, uint8_t exponent);
+uint16_t mulShiftUnsigned(uint16_t value, uint16_t gain, uint8_t exponent);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* FIXEDPOINT_H */
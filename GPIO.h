@@ -24,9 +24,6 @@ extern "C" {
 #define GPIO_Input  1
   
     
-#define GPIO_PORTA 0
-#define GPIO_PORTB 1
-    
 //enum containing all GPIO ports - subtract 7 from GPIO Bs to get PORT B number
 enum GPIO_PORTS{
     pinRA0,
@@ -47,9 +44,101 @@ enum GPIO_PORTS{
     pinRB7
 };
 
-void initialiseGPIO(const enum GPIO_PORTS gpioNumber, uint8_t direction);
-void writeGPIO(const enum GPIO_PORTS gpioNumber, uint8_t writeValue);
-bool readGPIO(const enum GPIO_PORTS gpioNumber);
+//compile time pin binding - the gpio defines in Global.h are pasted onto the tables below so each access compiles
+//to a fixed register bit (single BSF/BCF/BTFSC) with no runtime port decode.
+//a pin which lacks the requested function has no table entry, so using it (ie GPIO_SET_OUTPUT(pinRA5)) fails to compile
+#define PIN_CAT(a, b)               a##b
+#define PIN_XCAT(a, b)              PIN_CAT(a, b)       //second level so the Global.h define is expanded before pasting
+    
+#define GPIO_WRITE(gpio, value)     (PIN_XCAT(PIN_LAT_, gpio) = (value))
+#define GPIO_READ(gpio)             (PIN_XCAT(PIN_PORT_, gpio))
+#define GPIO_SET_OUTPUT(gpio)       (PIN_XCAT(PIN_TRIS_, gpio) = GPIO_Output)
+#define GPIO_SET_INPUT(gpio)        PIN_XCAT(PIN_DIGITAL_IN_, gpio)()     //digital input, also clears the analog select
+#define GPIO_SET_ANALOG(gpio)       PIN_XCAT(PIN_ANALOG_IN_, gpio)()      //analog input, only exists for pins with an ADC channel
+    
+//output latch bits, RA5 is input only so has no entry
+#define PIN_LAT_pinRA0              LATAbits.LATA0
+#define PIN_LAT_pinRA1              LATAbits.LATA1
+#define PIN_LAT_pinRA2              LATAbits.LATA2
+#define PIN_LAT_pinRA3              LATAbits.LATA3
+#define PIN_LAT_pinRA4              LATAbits.LATA4
+#define PIN_LAT_pinRA6              LATAbits.LATA6
+#define PIN_LAT_pinRA7              LATAbits.LATA7
+#define PIN_LAT_pinRB0              LATBbits.LATB0
+#define PIN_LAT_pinRB1              LATBbits.LATB1
+#define PIN_LAT_pinRB2              LATBbits.LATB2
+#define PIN_LAT_pinRB3              LATBbits.LATB3
+#define PIN_LAT_pinRB4              LATBbits.LATB4
+#define PIN_LAT_pinRB5              LATBbits.LATB5
+#define PIN_LAT_pinRB6              LATBbits.LATB6
+#define PIN_LAT_pinRB7              LATBbits.LATB7
+    
+//input port bits
+#define PIN_PORT_pinRA0             PORTAbits.RA0
+#define PIN_PORT_pinRA1             PORTAbits.RA1
+#define PIN_PORT_pinRA2             PORTAbits.RA2
+#define PIN_PORT_pinRA3             PORTAbits.RA3
+#define PIN_PORT_pinRA4             PORTAbits.RA4
+#define PIN_PORT_pinRA5             PORTAbits.RA5
+#define PIN_PORT_pinRA6             PORTAbits.RA6
+#define PIN_PORT_pinRA7             PORTAbits.RA7
+#define PIN_PORT_pinRB0             PORTBbits.RB0
+#define PIN_PORT_pinRB1             PORTBbits.RB1
+#define PIN_PORT_pinRB2             PORTBbits.RB2
+#define PIN_PORT_pinRB3             PORTBbits.RB3
+#define PIN_PORT_pinRB4             PORTBbits.RB4
+#define PIN_PORT_pinRB5             PORTBbits.RB5
+#define PIN_PORT_pinRB6             PORTBbits.RB6
+#define PIN_PORT_pinRB7             PORTBbits.RB7
+    
+//direction bits, RA5 is input only so has no entry
+#define PIN_TRIS_pinRA0             TRISAbits.TRISA0
+#define PIN_TRIS_pinRA1             TRISAbits.TRISA1
+#define PIN_TRIS_pinRA2             TRISAbits.TRISA2
+#define PIN_TRIS_pinRA3             TRISAbits.TRISA3
+#define PIN_TRIS_pinRA4             TRISAbits.TRISA4
+#define PIN_TRIS_pinRA6             TRISAbits.TRISA6
+#define PIN_TRIS_pinRA7             TRISAbits.TRISA7
+#define PIN_TRIS_pinRB0             TRISBbits.TRISB0
+#define PIN_TRIS_pinRB1             TRISBbits.TRISB1
+#define PIN_TRIS_pinRB2             TRISBbits.TRISB2
+#define PIN_TRIS_pinRB3             TRISBbits.TRISB3
+#define PIN_TRIS_pinRB4             TRISBbits.TRISB4
+#define PIN_TRIS_pinRB5             TRISBbits.TRISB5
+#define PIN_TRIS_pinRB6             TRISBbits.TRISB6
+#define PIN_TRIS_pinRB7             TRISBbits.TRISB7
+    
+//digital input setup, pins with an analog function also have their ANSEL bit cleared
+#define PIN_DIGITAL_IN_pinRA0()     do{ TRISAbits.TRISA0 = 1; ANSELAbits.ANSA0 = 0; }while(0)
+#define PIN_DIGITAL_IN_pinRA1()     do{ TRISAbits.TRISA1 = 1; ANSELAbits.ANSA1 = 0; }while(0)
+#define PIN_DIGITAL_IN_pinRA2()     do{ TRISAbits.TRISA2 = 1; ANSELAbits.ANSA2 = 0; }while(0)
+#define PIN_DIGITAL_IN_pinRA3()     do{ TRISAbits.TRISA3 = 1; ANSELAbits.ANSA3 = 0; }while(0)
+#define PIN_DIGITAL_IN_pinRA4()     do{ TRISAbits.TRISA4 = 1; ANSELAbits.ANSA4 = 0; }while(0)
+#define PIN_DIGITAL_IN_pinRA5()     do{ }while(0)                                   //RA5 is always a digital input
+#define PIN_DIGITAL_IN_pinRA6()     do{ TRISAbits.TRISA6 = 1; }while(0)
+#define PIN_DIGITAL_IN_pinRA7()     do{ TRISAbits.TRISA7 = 1; }while(0)
+#define PIN_DIGITAL_IN_pinRB0()     do{ TRISBbits.TRISB0 = 1; }while(0)
+#define PIN_DIGITAL_IN_pinRB1()     do{ TRISBbits.TRISB1 = 1; ANSELBbits.ANSB1 = 0; }while(0)
+#define PIN_DIGITAL_IN_pinRB2()     do{ TRISBbits.TRISB2 = 1; ANSELBbits.ANSB2 = 0; }while(0)
+#define PIN_DIGITAL_IN_pinRB3()     do{ TRISBbits.TRISB3 = 1; ANSELBbits.ANSB3 = 0; }while(0)
+#define PIN_DIGITAL_IN_pinRB4()     do{ TRISBbits.TRISB4 = 1; ANSELBbits.ANSB4 = 0; }while(0)
+#define PIN_DIGITAL_IN_pinRB5()     do{ TRISBbits.TRISB5 = 1; ANSELBbits.ANSB5 = 0; }while(0)
+#define PIN_DIGITAL_IN_pinRB6()     do{ TRISBbits.TRISB6 = 1; ANSELBbits.ANSB6 = 0; }while(0)
+#define PIN_DIGITAL_IN_pinRB7()     do{ TRISBbits.TRISB7 = 1; ANSELBbits.ANSB7 = 0; }while(0)
+    
+//analog input setup, RA5-RA7 and RB0 have no ADC so have no entry
+#define PIN_ANALOG_IN_pinRA0()      do{ TRISAbits.TRISA0 = 1; ANSELAbits.ANSA0 = 1; }while(0)
+#define PIN_ANALOG_IN_pinRA1()      do{ TRISAbits.TRISA1 = 1; ANSELAbits.ANSA1 = 1; }while(0)
+#define PIN_ANALOG_IN_pinRA2()      do{ TRISAbits.TRISA2 = 1; ANSELAbits.ANSA2 = 1; }while(0)
+#define PIN_ANALOG_IN_pinRA3()      do{ TRISAbits.TRISA3 = 1; ANSELAbits.ANSA3 = 1; }while(0)
+#define PIN_ANALOG_IN_pinRA4()      do{ TRISAbits.TRISA4 = 1; ANSELAbits.ANSA4 = 1; }while(0)
+#define PIN_ANALOG_IN_pinRB1()      do{ TRISBbits.TRISB1 = 1; ANSELBbits.ANSB1 = 1; }while(0)
+#define PIN_ANALOG_IN_pinRB2()      do{ TRISBbits.TRISB2 = 1; ANSELBbits.ANSB2 = 1; }while(0)
+#define PIN_ANALOG_IN_pinRB3()      do{ TRISBbits.TRISB3 = 1; ANSELBbits.ANSB3 = 1; }while(0)
+#define PIN_ANALOG_IN_pinRB4()      do{ TRISBbits.TRISB4 = 1; ANSELBbits.ANSB4 = 1; }while(0)
+#define PIN_ANALOG_IN_pinRB5()      do{ TRISBbits.TRISB5 = 1; ANSELBbits.ANSB5 = 1; }while(0)
+#define PIN_ANALOG_IN_pinRB6()      do{ TRISBbits.TRISB6 = 1; ANSELBbits.ANSB6 = 1; }while(0)
+#define PIN_ANALOG_IN_pinRB7()      do{ TRISBbits.TRISB7 = 1; ANSELBbits.ANSB7 = 1; }while(0)
 
 #ifdef	__cplusplus
 }
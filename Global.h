@@ -18,21 +18,41 @@ extern "C" {
 #include <stdint.h>
 #include "GPIO.h"
 #include "StateMachine.h"
+#include "HotState.h"
     
 //oscillator settings
 #define CLOCK_FREQUENCY_SELECT  freq32M           //this should be left as 32MHz - lower frequencies limit PWM freq    
-#define _XTAL_FREQ CLOCK_FREQUENCY_SELECT         //used by delay function
+#define _XTAL_FREQ 32000000UL                     //used by the delay functions, in Hz to match CLOCK_FREQUENCY_SELECT
+    
+//converter design spec - 1 takes the PWM periods, PI gains, DT and sensor conversion constants from DesignSpec.h, which is
+//generated from a spec file by tools/design_spec.py, instead of the hand set values in each module header
+#define DESIGN_SPEC_ENABLED     0
+#if DESIGN_SPEC_ENABLED == 1
+#include "DesignSpec.h"
+#endif
     
     
 //List all outputs here to keep track - gpio defines are critical, pins are for indication
     //PWM
 #define gpioPWMout                pinRA6
 #define pinPWMout                 15
-#define gpioSlotTest              pinRB4
+#define gpioPWMHighSide           pinRB0          //P1A and P1B, used instead of RA6 when SYNCHRONOUS_ENABLED (PWM.h)
+#define pinPWMHighSide            6
+#define gpioPWMLowSide            pinRB4
+#define pinPWMLowSide             10
+#define gpioPWMPhase2             pinRB6          //P2A, used when INTERLEAVED_ENABLED (PWM.h)
+#define pinPWMPhase2              12
+#define gpioSlotTest              pinRB4          //unused when SYNCHRONOUS_ENABLED, the pin is the low side output
 #define pinSlotTest               10
 #define gpioSlotTest2             pinRB5
 #define pinSlotTest2              11
     
+    //Serial
+#define gpioTelemetryTX           pinRB5          //shared with slot test 2, EUSART takes over the pin when telemetry is enabled
+#define pinTelemetryTX            11
+#define gpioCommandRX             pinRB2          //shared with the frequency pot, which is not sampled when commands are enabled
+#define pinCommandRX              8
+    
     //Digital IO
 //Current Sensors
 #define gpioCurrentTripIL         pinRA3
@@ -42,8 +62,10 @@ extern "C" {
 #define gpioOverCurrentClear      pinRB3
 #define pinOverCurrentClear       9
 //Control Select
-#define gpioControlSelect         pinRB0
+#define gpioControlSelect         pinRB0          //read through READ_CONTROL_SELECT(), the pin is the high side output when SYNCHRONOUS_ENABLED
 #define pinControlSelect          6
+#define gpioModeSelect            pinRA7          //low selects closed loop, RA7 has no weak pull up so needs an external pull up
+#define pinModeSelect             16
     
     //ADCs
 //Potentiometers
@@ -59,6 +81,13 @@ extern "C" {
 //Voltage Sensor                  
 #define gpioOutputVoltage         pinRA4
 #define pinOutputVoltage          3
+#define gpioInputVoltage          pinRB7
+#define pinInputVoltage           13
+    
+//the control select jumper and slot test pin share RB0 and RB4 with the half bridge outputs, the jumper then reads as
+//fitted (low) and slot test writes are dropped
+#define READ_CONTROL_SELECT()     ((SYNCHRONOUS_ENABLED == 0) && GPIO_READ(gpioControlSelect))
+#define SLOT_TEST_WRITE(value)    do{ if(SYNCHRONOUS_ENABLED == 0) GPIO_WRITE(gpioSlotTest, value); }while(0)
     
 //the list of clock frequency options    
 enum internalClockFreqSelec{
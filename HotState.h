@@ -0,0 +1,50 @@
+/* 
+ * File:   HotState.h
+ * Author: agent
+ *
+ * Created on 19 October 2026, 11:28
+ */
+
+#ifndef HOTSTATE_H
+#define	HOTSTATE_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <xc.h>                                     //PIC hardware mapping
+
+//control state which is read or written on every tick or control period is kept together in bank 0, alongside the
+//PORTA/PIR1/TMR2/PR2 registers the interrupt also uses, so Tick490Hz and its callees rarely need to switch bank.
+//FIFOs and other data used less often are placed in banks 1-4 (see the __bank() qualifiers in each module header).
+//requires address qualifiers to be honoured (-maddrqual=request), run tools/memory_report.py after a build to check placement.
+//RAM is 384 bytes and not every feature fits at once: tools/memory_report.py --estimate puts the committed configuration at
+//240 bytes of static data, telemetry adds approx 37, commands 9, share 22, scope 41, the energy meter with Vin 58, and all
+//features together need 474 bytes before the compiled stack. Check a configuration with it before enabling features
+struct hotControlState{
+    volatile uint32_t tickCount;          //number of 490Hz ticks since power on, used to timestamp events (wraps after ~101 days)
+    uint16_t setDuty;               //duty and period requested of the PWM, written to the registers each tick
+    uint16_t prevDuty;              //duty and period last committed to the PWM registers
+    uint16_t filteredVout;          //filtered (oversampled) Vout
+    uint16_t filteredIL;            //filtered current measurements
+    uint16_t filteredIDS;
+    volatile uint16_t latestIL;     //latest IL sample, which is read once per PWM cycle if CCP1 interrupt used
+    uint8_t setPeriod;
+    uint8_t prevPeriod;
+    uint8_t currentTripCount;       //number of consecutive current trips
+    bool tripIL;
+    bool tripIDS;
+};
+
+__bank(0) struct hotControlState hotState = {0};
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* HOTSTATE_H */
+
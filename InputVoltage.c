@@ -0,0 +1,67 @@
+/* 
+ * File:   InputVoltage.c
+ * Author: agent
+ *
+ * Created on 19 October 2026, 11:38
+ */
+
+#include "Global.h"
+#include "InputVoltage.h"
+#include "ADC.h"
+#include "FixedPoint.h"
+
+/*------------------------------------------------------------------------------
+ Function: initialiseInputVoltage()
+ *Use: This function sets up the Vin sense pin and takes a first sample so the
+ * gain is valid before the first control period
+------------------------------------------------------------------------------*/
+void initialiseInputVoltage(){
+#if VIN_SENSE_ENABLED == 1
+    ADC_INIT_PIN(gpioInputVoltage);
+    runInputVoltage();
+#endif
+}
+
+/*------------------------------------------------------------------------------
+ Function: runInputVoltage()
+ *Use: This function is called from slot 2, it takes a new Vin sample and
+ * looks up the duty gain, interpolating between the reciprocal table entries.
+ * No moving average is used so a line step is seen by the next control period
+------------------------------------------------------------------------------*/
+void runInputVoltage(){
+#if VIN_SENSE_ENABLED == 1
+    vinRaw = ADC_READ_OVERSAMPLED(gpioInputVoltage, VIN_OVERSAMPLE_EXPONENT);
+    vinMilliVolts = mulShiftUnsigned(vinRaw, VIN_SENSOR_GAIN, VIN_SENSOR_EXPONENT);
+    
+    uint8_t index = (uint8_t) (vinRaw >> VIN_TABLE_SHIFT);
+    uint8_t fraction = (uint8_t) (vinRaw & ((1u << VIN_TABLE_SHIFT) - 1u));
+    uint16_t step = vinReciprocalTable[index] - vinReciprocalTable[index + 1];      //table is decreasing, max 838 * 63 fits 16 bits
+    vinDutyGain = vinReciprocalTable[index] - (uint16_t) (((uint16_t) step * fraction) >> VIN_TABLE_SHIFT);
+#endif
+}
+
+/*------------------------------------------------------------------------------
+ Function: readInputMilliVolts()
+ *Use: This function returns the latest Vin in mV, or VIN_NOMINAL_MV when Vin
+ * is not measured
+------------------------------------------------------------------------------*/
+uint16_t readInputMilliVolts(){
+#if VIN_SENSE_ENABLED == 1
+    return vinMilliVolts;
+#else
+    return VIN_NOMINAL_MV;
+#endif
+}
+
+/*------------------------------------------------------------------------------
+ Function: readDutyGain()
+ *Use: This function returns the gain converting mV of output to duty counts
+ * at the present Vin, see DUTY_GAIN_EXPONENT
+------------------------------------------------------------------------------*/
+uint16_t readDutyGain(){
+#if VIN_SENSE_ENABLED == 1
+    return vinDutyGain;
+#else
+    return DUTY_GAIN(VIN_NOMINAL_MV);
+#endif
+}
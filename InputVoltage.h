@@ -0,0 +1,70 @@
+/* 
+ * File:   InputVoltage.h
+ * Author: agent
+ *
+ * Created on 19 October 2026, 11:38
+ */
+
+#ifndef INPUTVOLTAGE_H
+#define	INPUTVOLTAGE_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+#include "GPIO.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>   
+#include "Global.h" 
+
+//input voltage sensing - Vin is measured on RB7 (AN6) through a 560k/100k divider each slot 2, and converted to the duty
+//gain used by the feed-forward, predictive control and the observer. For a buck duty = Vout / Vin, and 100% duty is
+//4*period, so duty = (mV * period * gain) >> DUTY_GAIN_EXPONENT where gain = 4 * 2^DUTY_GAIN_EXPONENT / Vin
+//the gain is looked up from a reciprocal table calculated at build time, avoiding a division in the interrupt
+#define VIN_SENSE_ENABLED           0       //1 measures Vin, 0 assumes VIN_NOMINAL_MV and removes the code
+#if DESIGN_SPEC_ENABLED == 0
+#define VIN_NOMINAL_MV              24000u  //supply voltage used when Vin is not measured, in millivolts
+#endif
+#define VIN_FEEDFORWARD_MIN_MV      6000u   //the gain is held below this input voltage, the duty limits then apply
+#define DUTY_GAIN_EXPONENT          20u
+#define DUTY_GAIN(milliVolts)       (((4UL << DUTY_GAIN_EXPONENT) + ((milliVolts) / 2u)) / (milliVolts))   //175 at 24V
+    
+//Vin is scaled according to rawValue = Vin * (100k/(100k+560k)) * 1024/5, 33V full scale
+//mV = rawValue * 5/1024 * ((100k+560k)/100k) * 1000 = * 32.227 = (rawValue * 8250) >> 8, with n extra bits from oversampling
+#define VIN_OVERSAMPLE_EXPONENT     1u      //4 conversions per sample giving 11 bits
+#if DESIGN_SPEC_ENABLED == 0
+#define VIN_SENSOR_GAIN             8250u
+#define VIN_SENSOR_EXPONENT         (8u + VIN_OVERSAMPLE_EXPONENT)
+#endif
+    
+//the reciprocal table has an entry every 32 10 bit LSBs (1.03V) and is linearly interpolated between entries
+#define VIN_TABLE_SHIFT             (5u + VIN_OVERSAMPLE_EXPONENT)
+#define SIZE_OF_VIN_TABLE           33u
+#define VIN_TABLE_MV(index)         (((index) * 32UL * VIN_SENSOR_GAIN) >> (VIN_SENSOR_EXPONENT - VIN_OVERSAMPLE_EXPONENT))
+#define VIN_RECIPROCAL(index)       DUTY_GAIN((VIN_TABLE_MV(index) < VIN_FEEDFORWARD_MIN_MV) ? VIN_FEEDFORWARD_MIN_MV : VIN_TABLE_MV(index))
+
+#if VIN_SENSE_ENABLED == 1
+const uint16_t vinReciprocalTable[SIZE_OF_VIN_TABLE] = {
+    VIN_RECIPROCAL(0u), VIN_RECIPROCAL(1u), VIN_RECIPROCAL(2u), VIN_RECIPROCAL(3u), VIN_RECIPROCAL(4u), VIN_RECIPROCAL(5u), VIN_RECIPROCAL(6u), VIN_RECIPROCAL(7u),
+    VIN_RECIPROCAL(8u), VIN_RECIPROCAL(9u), VIN_RECIPROCAL(10u), VIN_RECIPROCAL(11u), VIN_RECIPROCAL(12u), VIN_RECIPROCAL(13u), VIN_RECIPROCAL(14u), VIN_RECIPROCAL(15u),
+    VIN_RECIPROCAL(16u), VIN_RECIPROCAL(17u), VIN_RECIPROCAL(18u), VIN_RECIPROCAL(19u), VIN_RECIPROCAL(20u), VIN_RECIPROCAL(21u), VIN_RECIPROCAL(22u), VIN_RECIPROCAL(23u),
+    VIN_RECIPROCAL(24u), VIN_RECIPROCAL(25u), VIN_RECIPROCAL(26u), VIN_RECIPROCAL(27u), VIN_RECIPROCAL(28u), VIN_RECIPROCAL(29u), VIN_RECIPROCAL(30u), VIN_RECIPROCAL(31u),
+    VIN_RECIPROCAL(32u)
+};
+uint16_t vinRaw = 0;                            //latest oversampled Vin sample
+uint16_t vinMilliVolts = VIN_NOMINAL_MV;
+uint16_t vinDutyGain = DUTY_GAIN(VIN_NOMINAL_MV);
+#endif
+
+void initialiseInputVoltage();
+void runInputVoltage();
+uint16_t readInputMilliVolts();
+uint16_t readDutyGain();
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* INPUTVOLTAGE_H */
@@ -0,0 +1,116 @@
+/* 
+ * File:   Observer.c
+ * Author: agent
+ *
+ * Created on 19 October 2026, 11:36
+ */
+
+#include "Global.h"
+#include "Observer.h"
+#include "Controller.h"
+#include "CurrentSensor.h"
+#include "InputVoltage.h"
+#include "FixedPoint.h"
+
+#if OBSERVER_ENABLED == 1
+/*------------------------------------------------------------------------------
+ Function: readSwitchNodeMilliVolts()
+ *Use: This function returns the average switch node voltage d * Vin in mV for
+ * the duty committed to the PWM, 100% duty corresponds to 4*period
+------------------------------------------------------------------------------*/
+int16_t readSwitchNodeMilliVolts(){
+    if(hotState.prevPeriod == 0) return 0;
+    return saturateToInt16(((uint32_t) hotState.prevDuty * readInputMilliVolts()) / ((uint16_t) hotState.prevPeriod << 2));
+}
+
+/*------------------------------------------------------------------------------
+ Function: applyObserverGain(sum, innovationVout, innovationIL, gainVout, gainIL)
+ *Use: This function returns sum, a state scaled up by the gain exponent, plus
+ * the correction from the innovations, shifted back down and saturated
+------------------------------------------------------------------------------*/
+int16_t applyObserverGain(int32_t sum, int16_t innovationVout, int16_t innovationIL, int16_t gainVout, int16_t gainIL){
+    sum += (int32_t) innovationVout * gainVout;
+    sum += (int32_t) innovationIL * gainIL;
+    return saturateToInt16(sum >> OBSERVER_GAIN_EXPONENT);
+}
+#endif
+
+/*------------------------------------------------------------------------------
+ Function: initialiseObserver(voutSample, ilSample)
+ *Use: This function starts the estimates from the measured values, so the
+ * observer is valid from its first period, and sets the losses to zero
+------------------------------------------------------------------------------*/
+void initialiseObserver(uint16_t voutSample, uint16_t ilSample){
+#if OBSERVER_ENABLED == 1
+    observer.vout = convertRawToMilliVolts(voutSample);
+    observer.capacitorVoltage = observer.vout;
+    observer.inductorCurrent = convertRawToMilliAmps(ilSample);
+    observer.loadCurrent = observer.inductorCurrent;
+    observer.loss = 0;
+    observer.innovation = 0;
+    observer.input = readSwitchNodeMilliVolts();
+    observerReady = 1;
+#endif
+}
+
+/*------------------------------------------------------------------------------
+ Function: runObserver(voutSample, ilSample)
+ *Use: This function is called from slot 2 with the latest unfiltered samples,
+ * it predicts IL and Vc from the model with the inputs applied over the last
+ * period, then corrects all four states from the measured less predicted Vout
+ * and IL. While the PWM has been off for the whole period the diode blocks and
+ * the model does not apply, so the estimates track the measurements
+------------------------------------------------------------------------------*/
+void runObserver(uint16_t voutSample, uint16_t ilSample){
+#if OBSERVER_ENABLED == 1
+    int16_t measuredVout = convertRawToMilliVolts(voutSample);
+    int16_t measuredIL = convertRawToMilliAmps(ilSample);
+    int16_t input = readSwitchNodeMilliVolts();
+    
+    if((input == 0) && (observer.input == 0)){
+        observer.vout = measuredVout;
+        observer.capacitorVoltage = measuredVout;
+        observer.inductorCurrent = measuredIL;
+        observer.loadCurrent = measuredIL;
+        observer.innovation = 0;
+        return;
+    }
+    
+    //prediction, the loss acts against the input over both halves
+    int16_t lastDrive = subSaturated(observer.input, observer.loss);
+    int16_t newDrive = subSaturated(input, observer.loss);
+    int32_t predictedIL = (int32_t) OBSERVER_A_IL_IL * observer.inductorCurrent + (int32_t) OBSERVER_A_IL_VC * observer.capacitorVoltage
+            + (int32_t) OBSERVER_A_IL_LOAD * observer.loadCurrent + (int32_t) OBSERVER_B_IL_LAST * lastDrive + (int32_t) OBSERVER_B_IL_NEW * newDrive;
+    int32_t predictedVC = (int32_t) OBSERVER_A_VC_IL * observer.inductorCurrent + (int32_t) OBSERVER_A_VC_VC * observer.capacitorVoltage
+            + (int32_t) OBSERVER_A_VC_LOAD * observer.loadCurrent + (int32_t) OBSERVER_B_VC_LAST * lastDrive + (int32_t) OBSERVER_B_VC_NEW * newDrive;
+    int16_t predictedCurrent = saturateToInt16(predictedIL >> OBSERVER_GAIN_EXPONENT);
+    int16_t predictedVout = addSaturated(saturateToInt16(predictedVC >> OBSERVER_GAIN_EXPONENT),
+            mulShiftSigned(subSaturated(predictedCurrent, observer.loadCurrent), OBSERVER_ESR_GAIN, OBSERVER_GAIN_EXPONENT));
+    
+    //correction, the load current and loss are constant in the model so only the gain moves them
+    observer.innovation = subSaturated(measuredVout, predictedVout);
+    int16_t innovationIL = subSaturated(measuredIL, predictedCurrent);
+    observer.inductorCurrent = applyObserverGain(predictedIL, observer.innovation, innovationIL, OBSERVER_K_IL_VOUT, OBSERVER_K_IL_IL);
+    observer.capacitorVoltage = applyObserverGain(predictedVC, observer.innovation, innovationIL, OBSERVER_K_VC_VOUT, OBSERVER_K_VC_IL);
+    observer.loadCurrent = applyObserverGain((int32_t) observer.loadCurrent << OBSERVER_GAIN_EXPONENT, observer.innovation, innovationIL,
+            OBSERVER_K_LOAD_VOUT, OBSERVER_K_LOAD_IL);
+    observer.loss = clampInt16(applyObserverGain((int32_t) observer.loss << OBSERVER_GAIN_EXPONENT, observer.innovation, innovationIL,
+            OBSERVER_K_LOSS_VOUT, OBSERVER_K_LOSS_IL), -OBSERVER_LOSS_LIMIT_MV, OBSERVER_LOSS_LIMIT_MV);
+    observer.vout = addSaturated(observer.capacitorVoltage,
+            mulShiftSigned(subSaturated(observer.inductorCurrent, observer.loadCurrent), OBSERVER_ESR_GAIN, OBSERVER_GAIN_EXPONENT));
+    observer.input = input;
+#endif
+}
+
+/*------------------------------------------------------------------------------
+ Function: readObservedVout()
+ *Use: This function returns the estimated output voltage in mV for the
+ * controller and protection, or the moving average when the observer is
+ * disabled or not yet started
+------------------------------------------------------------------------------*/
+int16_t readObservedVout(){
+#if OBSERVER_ENABLED == 1
+    if(observerReady) return observer.vout;
+#endif
+    return convertRawToMilliVolts(hotState.filteredVout);
+}
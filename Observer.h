@@ -0,0 +1,86 @@
+/* 
+ * File:   Observer.h
+ * Author: agent
+ *
+ * Created on 19 October 2026, 11:36
+ */
+
+#ifndef OBSERVER_H
+#define	OBSERVER_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "Global.h"
+
+//state observer - estimates the output voltage, inductor current and load current each slot 2 (245Hz) from the latest
+//unfiltered Vout and IL samples and the duty command, without the group delay of the 16 sample moving averages (~33ms)
+//the model is the LC filter discretised over the 4ms observer period, states IL, Vc, the load current and a loss voltage
+//(switch, diode and dead time drops), with the input the average switch node voltage d * Vin, Vin measured or
+//VIN_NOMINAL_MV (InputVoltage.h). The duty changes in slot 1 half way between observer runs, so the input over each half
+//has its own coefficients. Each run predicts the states from the model then corrects them from the measured Vout and IL
+//through the gain K. The load current and loss are modelled as constant, the correction moves them, so the estimates
+//are unbiased without a load model. The coefficients are generated by tools/design_spec.py from L, C, ESR, the inductor
+//resistance and the noise of the samples (tools/specs/default.ini [observer]), each is a signed gain with exponent
+//OBSERVER_GAIN_EXPONENT, approx 20 16 bit multiplies per run
+#define OBSERVER_ENABLED            0       //1 runs the observer, 0 removes the code to reduce memory consumption
+#define OBSERVER_LOSS_LIMIT_MV      4000    //limit on the loss state, a larger mismatch means the model does not apply (eg. current limit)
+#if DESIGN_SPEC_ENABLED == 0
+//model of IL (mA) and Vc (mV) at the next run from the present states, the load current and the input less the loss
+//over the first (LAST) and second (NEW) half of the period, for 100uH, 220uF, 50mOhm ESR and 100mOhm DCR
+#define OBSERVER_A_IL_IL            (-144)
+#define OBSERVER_A_IL_VC            (-209)
+#define OBSERVER_A_IL_LOAD          4219
+#define OBSERVER_B_IL_LAST          (-995)
+#define OBSERVER_B_IL_NEW           1204
+#define OBSERVER_A_VC_IL            95
+#define OBSERVER_A_VC_VC            (-112)
+#define OBSERVER_A_VC_LOAD          (-516)
+#define OBSERVER_B_VC_LAST          558
+#define OBSERVER_B_VC_NEW           3650
+//gain K from the Vout (mV) and IL (mA) innovations to each state
+#define OBSERVER_K_IL_VOUT          (-2226)
+#define OBSERVER_K_IL_IL            630
+#define OBSERVER_K_VC_VOUT          1622
+#define OBSERVER_K_VC_IL            (-24)
+#define OBSERVER_K_LOAD_VOUT        (-4122)
+#define OBSERVER_K_LOAD_IL          402
+#define OBSERVER_K_LOSS_VOUT        (-156)
+#define OBSERVER_K_LOSS_IL          (-13)
+#define OBSERVER_ESR_GAIN           205u    //output capacitor ESR, 50mOhm
+#define OBSERVER_DCR_GAIN           410u    //inductor resistance, 100mOhm
+#define OBSERVER_GAIN_EXPONENT      12u
+#endif
+    
+//observer estimates, valid once observerReady is set
+struct observerState{
+    int16_t vout;                   //estimated output voltage in mV, Vc plus the ESR drop
+    int16_t capacitorVoltage;       //estimated capacitor voltage in mV
+    int16_t inductorCurrent;        //estimated average inductor current in mA
+    int16_t loadCurrent;            //estimated load current in mA
+    int16_t loss;                   //estimated loss voltage in mV, switch node less inductor resistance drop less output
+    int16_t innovation;             //latest measured less predicted output in mV, large values show a model mismatch
+    int16_t input;                  //switch node voltage d * Vin in mV applied over the second half of the last period
+};
+
+#if OBSERVER_ENABLED == 1
+struct observerState observer = {0, 0, 0, 0, 0, 0, 0};
+bool observerReady = 0;
+#endif
+
+int16_t readSwitchNodeMilliVolts();
+int16_t applyObserverGain(int32_t sum, int16_t innovationVout, int16_t innovationIL, int16_t gainVout, int16_t gainIL);
+void initialiseObserver(uint16_t voutSample, uint16_t ilSample);
+void runObserver(uint16_t voutSample, uint16_t ilSample);
+int16_t readObservedVout();
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* OBSERVER_H */
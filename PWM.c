@@ -20,9 +20,29 @@ void setupPWM(){
     PR2 = 0;                       //Period setting for timer 2, initialise as 0     
     CCPR1L = 0;                    //duty setting for timer 2, initialise as 0
 
+#if INTERLEAVED_ENABLED == 1
+    CCP2CON = 0b00001100;          //phase 2 PWM, P2A on RB6 (CCP2SEL = 0)
+    APFCON0bits.CCP2SEL = 0;
+    CCPTMRSbits.C2TSEL = 0b01;     //CCP2 uses Timer4
+    PR4 = 0;
+    CCPR2L = 0;
+    T4CONbits.T4CKPS = 0b00;       //1:1 prescaler, matching timer 2
+    T4CONbits.TMR4ON = 1;
+    GPIO_SET_OUTPUT(gpioPWMPhase2);
+#endif
+#if SYNCHRONOUS_ENABLED == 1
+    APFCON0bits.CCP1SEL = 1;       //P1A on RB0, P1B is fixed on RB4
+    PWM1CONbits.P1DC = SYNC_DEAD_BAND;     //dead band applied at each edge in half bridge mode
+    PSTR1CONbits.STR1A = 1;        //in single output mode (diode emulation) steer the PWM to P1A only
+    PSTR1CONbits.STR1D = 0;
+    GPIO_WRITE(gpioPWMLowSide, 0); //low side held off until the load current is high enough
+    GPIO_SET_OUTPUT(gpioPWMHighSide);
+    GPIO_SET_OUTPUT(gpioPWMLowSide);
+#else
     APFCON0bits.P1DSEL = 1;        //setup Alternate Pin Function Register bit for PWM output P1D on RA6
     PSTR1CONbits.STR1D = 1;        //Steer P1D from CCP1
     PSTR1CONbits.STR1A = 0;        //Assign P1A to port pin - to prevent PWM appearing here
+#endif
     
     T2CONbits.T2CKPS = 0b00;       //1:1 prescaler on timer 2
     PIE1bits.TMR2IE = 0;           //disable period interrupt
@@ -33,7 +53,7 @@ void setupPWM(){
     
     //PIE1bits.TMR2IE = 1; //enable interrupt on PWM cycle finish to trigger ADC read in interrupt routine 
     
-    initialiseGPIO(gpioPWMout, GPIO_Output);    //set the corresponding RA6 gpio as a digital output
+    GPIO_SET_OUTPUT(gpioPWMout);                //set the corresponding RA6 gpio as a digital output
 }
 
 /*------------------------------------------------------------------------------
@@ -45,12 +65,62 @@ void setupPWM(){
  * Duty cycle is given by the below formula
  * DutyCycle = (CCPR1L:CCP1CON<5:4> / (4*PR2+1) * 100
  * CCPR1L:CCP1CON<5:4> = (4*PR2 * (DutyCycle(%)) / 100) - 1
+ * The registers are shadowed by prevDuty and prevPeriod, unchanged values are
+ * skipped and changes are committed synchronised to the Timer2 period match
 ------------------------------------------------------------------------------*/
 void setPWMDutyandPeriod(uint16_t dutyCycle, uint8_t period){
-    PR2 = period;
+#if SPREAD_SPECTRUM_ENABLED == 1
+    runSpreadSpectrum(&dutyCycle, &period);
+#endif
+    
+#if INTERLEAVED_ENABLED == 1
+    uint16_t phase2Duty = 0;
+    if(phase2Enabled && (dutyCycle != 0)){
+        phase2Duty = (uint16_t) ((int16_t) dutyCycle + phaseBalance);
+        if(phase2Duty > ((uint16_t) period << 2)) phase2Duty = dutyCycle;      //balance cannot take the duty out of range
+    }
+    
+    //only touch the registers when something has changed
+    if((dutyCycle == hotState.prevDuty) && (period == hotState.prevPeriod) && (phase2Duty == prevPhase2Duty)){
+        pwmUpdatesSkipped++;
+        return;
+    }
+#else
+    //only touch the registers when something has changed
+    if((dutyCycle == hotState.prevDuty) && (period == hotState.prevPeriod)){
+        pwmUpdatesSkipped++;
+        return;
+    }
+#endif
+    
+    //the duty is split over CCPR1L and DC1B and latched into the PWM at each period match, so write both just
+    //after a match to guarantee they are latched together. TMR2IE is disabled so this is only a flag poll
+    PIR1bits.TMR2IF = 0;
+    while(!PIR1bits.TMR2IF);
     CCPR1L = dutyCycle >> 2;
-    CCP1CONbits.DC1B0 = dutyCycle & 1;
-    CCP1CONbits.DC1B1 = (dutyCycle & 2) > 1;
+    CCP1CONbits.DC1B = dutyCycle & 3;
+#if INTERLEAVED_ENABLED == 1
+    CCPR2L = phase2Duty >> 2;           //latched at the next Timer4 match, half a period later
+    CCP2CONbits.DC2B = phase2Duty & 3;
+    prevPhase2Duty = phase2Duty;
+#endif
+    
+    //PR2 is not buffered and writing it below the current TMR2 count stretches the pulse. Write it straight after
+    //the next match, when TMR2 is small and the duty above has just been latched, so both apply to the same period
+    if(period != hotState.prevPeriod){
+        PIR1bits.TMR2IF = 0;
+        while(!PIR1bits.TMR2IF);
+        PR2 = period;
+#if INTERLEAVED_ENABLED == 1
+        //a period change moves the Timer4 match relative to Timer2, so restart Timer4 half a period ahead of Timer2
+        PR4 = period;
+        TMR4 = TMR2 + ((period + 1u) >> 1) + INTERLEAVE_PHASE_TRIM;
+#endif
+    }
+    
+    hotState.prevDuty = dutyCycle;
+    hotState.prevPeriod = period;
+    pwmUpdatesCommitted++;
 }
 
 /*------------------------------------------------------------------------------
@@ -63,4 +133,85 @@ void setPWMDutyandPeriod(uint16_t dutyCycle, uint8_t period){
 ------------------------------------------------------------------------------*/
 void setPWMPeriod(uint8_t period){
     PR2 = period;
-}
\ No newline at end of file
+}
+
+/*------------------------------------------------------------------------------
+ Function: runSpreadSpectrum(dutyCycle, period)
+ *Use: This function steps the spread spectrum modulation and applies the
+ * current offset to the passed period, following a triangle or pseudo random
+ * profile. The duty cycle is rescaled by the same ratio so the percentage duty
+ * seen by the converter, and therefore regulation, is unaffected
+ * duty' = duty * period' / period, as duty is calculated as % * 4 * period
+------------------------------------------------------------------------------*/
+void runSpreadSpectrum(uint16_t *dutyCycle, uint8_t *period){
+#if SPREAD_SPECTRUM_ENABLED == 1
+    
+    //leave the PWM untouched when off, or if the modulation would take PR2 out of range
+    if((*period <= SPREAD_SPECTRUM_DEPTH) || (*period > (255u - SPREAD_SPECTRUM_DEPTH))) return;
+    
+    spreadTickCount++;
+    if(spreadTickCount >= SPREAD_SPECTRUM_RATE){
+        spreadTickCount = 0;
+#if SPREAD_SPECTRUM_PROFILE == SPREAD_SPECTRUM_TRIANGLE
+        spreadOffset += spreadDirection;        //sweep one count per step and reverse at the depth limits
+        if(spreadOffset >= (int8_t) SPREAD_SPECTRUM_DEPTH) spreadDirection = -1;
+        if(spreadOffset <= -((int8_t) SPREAD_SPECTRUM_DEPTH)) spreadDirection = 1;
+#elif SPREAD_SPECTRUM_PROFILE == SPREAD_SPECTRUM_RANDOM
+        //8 bit galois LFSR (taps 0xB8) gives a 255 step sequence which is mapped onto -DEPTH to +DEPTH
+        if(spreadLFSR & 1u) spreadLFSR = (spreadLFSR >> 1) ^ 0xB8u;
+        else spreadLFSR = spreadLFSR >> 1;
+        spreadOffset = (int8_t) (spreadLFSR % ((2u * SPREAD_SPECTRUM_DEPTH) + 1u)) - (int8_t) SPREAD_SPECTRUM_DEPTH;
+#endif
+    }
+    
+    uint8_t modulatedPeriod = (uint8_t) ((int16_t) *period + spreadOffset);
+    *dutyCycle = (uint16_t) (((uint32_t) *dutyCycle * modulatedPeriod) / *period);
+    *period = modulatedPeriod;
+    
+#endif
+}
+
+/*------------------------------------------------------------------------------
+ Function: runSynchronousRectifier(filteredILMilliAmps)
+ *Use: This function is called from slot 2 with the filtered inductor current,
+ * it switches the ECCP to half bridge mode when the current is high enough
+ * for the low side to conduct for the whole off time, and back to single
+ * output (diode emulation) at light load or when the PWM is stopped
+------------------------------------------------------------------------------*/
+void runSynchronousRectifier(int16_t filteredILMilliAmps){
+#if SYNCHRONOUS_ENABLED == 1
+    if((hotState.setDuty == 0) || (filteredILMilliAmps < SYNC_EXIT_MA)){
+        if(synchronousActive) stopSynchronousRectifier();
+    }
+    else if(!synchronousActive && (filteredILMilliAmps > SYNC_ENTER_MA)){
+        CCP1CONbits.P1M = 0b10;                 //half bridge, P1B is the complement of P1A with dead band
+        synchronousActive = 1;
+    }
+#endif
+}
+
+/*------------------------------------------------------------------------------
+ Function: stopSynchronousRectifier()
+ *Use: This function returns the ECCP to single output mode with the low side
+ * held off. In half bridge mode a duty of 0 would hold the low side on, so
+ * this is also called on entry to a fault
+------------------------------------------------------------------------------*/
+void stopSynchronousRectifier(){
+#if SYNCHRONOUS_ENABLED == 1
+    CCP1CONbits.P1M = 0b00;                     //single output, P1B returns to the port latch
+    GPIO_WRITE(gpioPWMLowSide, 0);
+    synchronousActive = 0;
+#endif
+}
+
+/*------------------------------------------------------------------------------
+ Function: enablePhase2(enable)
+ *Use: This function sheds or restores phase 2 of the interleaved converter,
+ * the duty is applied or cleared by the next setPWMDutyandPeriod()
+------------------------------------------------------------------------------*/
+void enablePhase2(bool enable){
+#if INTERLEAVED_ENABLED == 1
+    phase2Enabled = enable;
+    if(!enable) phaseBalance = 0;
+#endif
+}
@@ -13,19 +13,73 @@ extern "C" {
 #endif
 
 #include <xc.h>                                     //PIC hardware mapping
+#include "HotState.h"
      
 #define MIN_DUTY               10
 #define MAX_DUTY               90    
     
-//variables for setting duty and period
-uint8_t setPeriod = 0;
-uint16_t setDuty = 0;
-uint8_t prevPeriod = 0; 
-uint16_t prevDuty = 0;
+//spread spectrum settings - modulates PR2 around the requested period so the switching energy is spread over a band
+//of frequencies rather than one frequency and its harmonics, reducing the size of input filter required
+#define SPREAD_SPECTRUM_ENABLED     0       //1 enables period modulation, 0 removes the code to reduce memory consumption
+#define SPREAD_SPECTRUM_TRIANGLE    0       //period is swept up and down linearly between the depth limits
+#define SPREAD_SPECTRUM_RANDOM      1       //period is hopped to a pseudo random offset within the depth limits
+#define SPREAD_SPECTRUM_PROFILE     SPREAD_SPECTRUM_TRIANGLE
+#define SPREAD_SPECTRUM_DEPTH       4u      //max deviation of PR2 either side of the nominal period, 4 counts at PR2 = 79 is approx +-5% of 100kHz
+#define SPREAD_SPECTRUM_RATE        1u      //number of 490Hz ticks between each modulation step, 1 steps every tick
+    
+//synchronous rectifier - the ECCP runs as a half bridge, P1A (RB0) drives the high side and the complementary P1B (RB4)
+//drives the low side, with a dead band between them. At light load the low side is held off (diode emulation) so the
+//inductor current cannot reverse, only P1A is then driven in single output mode. Requires the gate drive wired to RB0
+//and RB4 rather than RA6, which takes over the control select jumper (reads as fitted) and the slot test pin
+#define SYNCHRONOUS_ENABLED         0       //1 enables the half bridge output, 0 uses the single P1D output on RA6
+#define SYNC_DEAD_TIME_NS           250u    //delay between one switch turning off and the other turning on
+#define SYNC_DEAD_BAND              ((SYNC_DEAD_TIME_NS * 8u + 999u) / 1000u)    //in Fosc/4 cycles of 125ns at 32MHz, rounded up
+#define SYNC_ENTER_MA               800     //filtered IL above which the low side is switched
+#define SYNC_EXIT_MA                500     //filtered IL below which diode emulation is used, lower than enter for hysteresis
+    
+#if SYNC_DEAD_BAND > 127u
+#error "SYNC_DEAD_TIME_NS is longer than the 7 bit dead band counter"
+#endif
+    
+//two phase interleaved - CCP2 drives a second buck phase from P2A (RB6) using Timer4, which runs at the same period as
+//Timer2 but half a period ahead so the phases switch 180 degrees apart and their ripple currents cancel. Phase 1 current
+//is measured by the IL sensor and trip, phase 2 by the IDS sensor and trip. Phase 2 duty is trimmed by the current
+//balance (Controller.c), and a trip of phase 2 alone sheds phase 2 so the converter continues on phase 1
+#define INTERLEAVED_ENABLED         0       //1 enables the second phase, 0 removes the code
+#define INTERLEAVE_PHASE_TRIM       4u      //Timer2 counts between reading TMR2 and writing TMR4 when re-phasing, trim on the scope
+    
+#if (INTERLEAVED_ENABLED == 1) && (SYNCHRONOUS_ENABLED == 1)
+#error "INTERLEAVED_ENABLED and SYNCHRONOUS_ENABLED cannot be used together"
+#endif
+    
+//variables for setting duty and period are held in hotState (HotState.h)
+uint16_t pwmUpdatesCommitted = 0;       //number of duty/period changes written to the registers
+uint16_t pwmUpdatesSkipped = 0;         //number of ticks where the duty and period were unchanged so no write was needed
+
+#if SYNCHRONOUS_ENABLED == 1
+bool synchronousActive = 0;             //1 when the low side is being switched
+#endif
+
+#if INTERLEAVED_ENABLED == 1
+bool phase2Enabled = 1;                 //cleared when phase 2 trips on its own, set again on restart
+int8_t phaseBalance = 0;                //duty correction added to phase 2 to share the current equally
+uint16_t prevPhase2Duty = 0;            //phase 2 duty last committed to CCPR2L/DC2B
+#endif
+
+#if SPREAD_SPECTRUM_ENABLED == 1
+int8_t spreadOffset = 0;                //current deviation of PR2 from the requested period
+int8_t spreadDirection = 1;             //direction of the triangle sweep, +1 or -1
+uint8_t spreadTickCount = 0;            //counts ticks to reduce the modulation rate according to SPREAD_SPECTRUM_RATE
+uint8_t spreadLFSR = 0xE1;              //pseudo random sequence register, must be non zero
+#endif
 
 void setupPWM();
 void setPWMDutyandPeriod(uint16_t dutyCycle, uint8_t period);
 void setPWMPeriod(uint8_t period);
+void runSpreadSpectrum(uint16_t *dutyCycle, uint8_t *period);
+void runSynchronousRectifier(int16_t filteredILMilliAmps);
+void stopSynchronousRectifier();
+void enablePhase2(bool enable);
 
 
         
@@ -13,8 +13,10 @@
  *Use: This function sets up the required ADC gpio pins for the potentiometers
 ------------------------------------------------------------------------------*/
 void initialisePotentiometers(){
-    initialiseADCPin(gpioPotentiometerDuty);
-    initialiseADCPin(gpioPotentiometerFreq);
+    ADC_INIT_PIN(gpioPotentiometerDuty);
+#if COMMAND_ENABLED == 0
+    ADC_INIT_PIN(gpioPotentiometerFreq);        //pin is the command RX input when commands are enabled
+#endif
 }
 
 /*------------------------------------------------------------------------------
@@ -24,7 +26,7 @@ void initialisePotentiometers(){
 ------------------------------------------------------------------------------*/
 uint16_t readFilteredDutyPot(){
     for(uint8_t i=0; i<SIZE_OF_POT_FILTER-1; i++) dutyPotFIFO[i] = dutyPotFIFO[i+1];       //shift all values in array to next 
-    dutyPotFIFO[SIZE_OF_POT_FILTER-1] =  readADCRaw(gpioPotentiometerDuty);                //take the newest sample
+    dutyPotFIFO[SIZE_OF_POT_FILTER-1] =  ADC_READ(gpioPotentiometerDuty);                  //take the newest sample
     uint32_t sumOfSamples = 0;
     for(uint8_t i=0; i<SIZE_OF_POT_FILTER; i++) sumOfSamples += dutyPotFIFO[i];    //sum all samples
     
@@ -37,8 +39,11 @@ uint16_t readFilteredDutyPot(){
  * FIFO filter for the frequency control pot, returning the filtered value
 ------------------------------------------------------------------------------*/
 uint16_t readFilteredFreqPot(){
+#if COMMAND_ENABLED == 1
+    return 0;                                   //pin is the command RX input, the period is fixed in runPotScaling()
+#endif
     for(uint8_t i=0; i<SIZE_OF_POT_FILTER-1; i++) freqPotFIFO[i] = freqPotFIFO[i+1];       //shift all values in array to next 
-    freqPotFIFO[SIZE_OF_POT_FILTER-1] =  readADCRaw(gpioPotentiometerFreq);                //take the newest sample
+    freqPotFIFO[SIZE_OF_POT_FILTER-1] =  ADC_READ(gpioPotentiometerFreq);                  //take the newest sample
     uint32_t sumOfSamples = 0;
     for(uint8_t i=0; i<SIZE_OF_POT_FILTER; i++) sumOfSamples += freqPotFIFO[i];    //sum all samples
     
@@ -57,27 +62,71 @@ void runPotScaling(){
     if(currentState == potControl){
         potSetCount++;
         //use potSetCount and POT_SET_DIVIDER to reduce the frequency of pot reads to: Slot 4 Freq / POT_SET_DIVIDER, this reduces jitter in signal
-        if(potSetCount == POT_SET_DIVIDER){
+        //during a handover from closed loop the settings are updated every call so the ramp completes quickly
+        if((potSetCount >= POT_SET_DIVIDER) || potHandover){
+            uint8_t heldPeriod = hotState.setPeriod;
+            uint16_t heldDuty = hotState.setDuty;
             //for the pot readings, we scale according to minimum and max values experienced on the ADC first
             //to calculate the required period we scale according to the min and max periods, shift by 10 bits to perform ADC scaling (1024 max ADC value)
+#if COMMAND_ENABLED == 1
+            uint32_t potScaled = 0;
+            hotState.setPeriod = COMMAND_POT_PERIOD;    //frequency pot pin is the command RX input
+#else
             uint32_t potScaled = (uint32_t) ((uint32_t)((uint32_t)(filteredFreqPot - POT_OFFSET) * POT_GAIN) >> POT_EXPONENT);
-            setPeriod = (uint32_t) ((potScaled) * (uint32_t)(MAX_PERIOD_FROM_POT-MIN_PERIOD_FROM_POT) >> (10)) + MIN_PERIOD_FROM_POT;
+            hotState.setPeriod = (uint32_t) ((potScaled) * (uint32_t)(MAX_PERIOD_FROM_POT-MIN_PERIOD_FROM_POT) >> (10)) + MIN_PERIOD_FROM_POT;
+#endif
+            uint8_t potPeriod = hotState.setPeriod;
+            if(potHandover && (heldPeriod != 0)){               //move the period one step from the closed loop period, a stopped output takes the pot period
+                if(heldPeriod < potPeriod) hotState.setPeriod = heldPeriod + 1;
+                else if(heldPeriod > potPeriod) hotState.setPeriod = heldPeriod - 1;
+            }
             
             //calculate duty cycle limits based on specified min and max values (in percent). Divide by 25 as MAX_DUTY is in %, and 100% duty corresponds to 4*period
-            uint16_t maxDuty = (uint16_t) (((uint32_t)(((uint16_t) MAX_DUTY) * setPeriod)) /  25);
-            uint16_t minDuty = (uint16_t) (((uint32_t)(((uint16_t) MIN_DUTY) * setPeriod)) /  25);
+            uint16_t maxDuty = (uint16_t) (((uint32_t)(((uint16_t) MAX_DUTY) * hotState.setPeriod)) /  25);
+            uint16_t minDuty = (uint16_t) (((uint32_t)(((uint16_t) MIN_DUTY) * hotState.setPeriod)) /  25);
             
             //for the pot readings, we scale according to minimum and max values experienced on the ADC first
             //then scale duty according to min and max values to calculate duty cycle
             potScaled = (uint32_t) ((uint32_t)((uint32_t)(filteredDutyPot - POT_OFFSET) * POT_GAIN) >> POT_EXPONENT);
-            setDuty = ((uint32_t)((potScaled) * (uint32_t)(maxDuty-minDuty)) >> (10)) + minDuty;
-            setDuty = (maxDuty) - (setDuty - minDuty);  //reverse direction of Duty Pot to match that of Frequency Pot - clockwise turn increases duty
+            hotState.setDuty = ((uint32_t)((potScaled) * (uint32_t)(maxDuty-minDuty)) >> (10)) + minDuty;
+            hotState.setDuty = (maxDuty) - (hotState.setDuty - minDuty);  //reverse direction of Duty Pot to match that of Frequency Pot - clockwise turn increases duty
 
             //just in case calculation error, limit duty
-            if(setDuty > maxDuty) setDuty = maxDuty;
-            if(setDuty < minDuty) setDuty = minDuty;
+            if(hotState.setDuty > maxDuty) hotState.setDuty = maxDuty;
+            if(hotState.setDuty < minDuty) hotState.setDuty = minDuty;
+            
+            if(potHandover){                                    //limit the duty change, finish once both settings match the pot
+                uint16_t potDuty = hotState.setDuty;
+                if(potDuty > heldDuty + POT_HANDOVER_STEP) hotState.setDuty = heldDuty + POT_HANDOVER_STEP;
+                else if(heldDuty > potDuty + POT_HANDOVER_STEP) hotState.setDuty = heldDuty - POT_HANDOVER_STEP;
+                if((hotState.setDuty == potDuty) && (hotState.setPeriod == potPeriod)) potHandover = 0;
+            }
 
             potSetCount = 0;        //reset, begin counting again for next pot calculation
         }
     }  
 }
+
+/*------------------------------------------------------------------------------
+ Function: startPotHandover()
+ *Use: This function is called when moving from closed loop to pot control,
+ * runPotScaling() then ramps from the present duty and period to the pot
+ * settings rather than stepping to them. Also used as the pot control soft
+ * start on power on and restart, where the duty ramps up from 0
+------------------------------------------------------------------------------*/
+void startPotHandover(){
+    potHandover = 1;
+    potSetCount = 0;
+}
+
+/*------------------------------------------------------------------------------
+ Function: prefillPotFilters()
+ *Use: This function fills the pot FIFOs with a burst of real samples, so pot
+ * control does not start from the 0 value, which scales to max duty
+------------------------------------------------------------------------------*/
+void prefillPotFilters(){
+    for(uint8_t i=0; i<SIZE_OF_POT_FILTER; i++){
+        filteredDutyPot = readFilteredDutyPot();
+        filteredFreqPot = readFilteredFreqPot();
+    }
+}
@@ -16,10 +16,13 @@ extern "C" {
 #include "GPIO.h"
 #include "ADC.h"
 #include <stdbool.h>
+#include "Command.h"
 
 //potentiometer generator settings
+#if DESIGN_SPEC_ENABLED == 0
 #define MIN_PERIOD_FROM_POT    15u                //PR2 = (clockFrequency / (4*freq)) - 1 corresponds to 500,000 Hz
 #define MAX_PERIOD_FROM_POT    180u               //corresponds to 50kHz with some added extra for contingency (so 50kHz can definitely be achieved)
+#endif
     
 #define SIZE_OF_POT_FILTER  16      //size of FIFO filter, must be a power of 2, also change POT_SENSOR_SHIFT accordingly
 #define POT_SENSOR_SHIFT    4u      //squareroot(SIZE_OF_POT_FILTER) = 4  
@@ -31,19 +34,23 @@ extern "C" {
                                     //this results in a low update rate 
 #define POT_GAIN            270     //correct the pot according to min and max
 #define POT_EXPONENT        8       // gain = 1024 / (1019 - 51)) = 1.05567, gain 270, exponent 8, 270 / 256 = 1.054
+#define POT_HANDOVER_STEP   2u      //max duty change per slot 3 (122.5Hz) when handing over from closed loop, period moves 1 per slot 3
 
     
 uint8_t potSetCount = 0;            
+bool potHandover = 0;               //ramping from the closed loop duty and period to the pot settings
 
 void initialisePotentiometers();
 uint16_t readFilteredDutyPot();
 uint16_t readFilteredFreqPot();
 void runPotScaling();
+void startPotHandover();
+void prefillPotFilters();
 
 uint16_t filteredFreqPot = 0;
 uint16_t filteredDutyPot = 0;
-uint16_t freqPotFIFO[SIZE_OF_POT_FILTER];
-uint16_t dutyPotFIFO[SIZE_OF_POT_FILTER];
+__bank(2) uint16_t freqPotFIFO[SIZE_OF_POT_FILTER];
+__bank(2) uint16_t dutyPotFIFO[SIZE_OF_POT_FILTER];
 
 
 #ifdef	__cplusplus
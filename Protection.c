@@ -0,0 +1,78 @@
+/* 
+ * File:   Protection.c
+ * Author: agent
+ *
+ * Created on 19 October 2026, 11:42
+ */
+
+#include "Global.h"
+#include "Protection.h"
+#include "ADC.h"
+#include "FaultManager.h"
+#include "Observer.h"
+#include "Reference.h"
+#include "StateMachine.h"
+
+/*------------------------------------------------------------------------------
+ Function: runProtection()
+ *Use: This function is called from the interrupt every tick while the
+ * converter is running, it takes a single Vout and IL conversion and checks
+ * them against the over voltage and output short limits
+------------------------------------------------------------------------------*/
+void runProtection(){
+#if PROTECTION_ENABLED == 1
+    if((currentState == initialising) || IS_FAULT_STATE(currentState)){
+        ovpCount = 0;
+        shortCount = 0;
+        return;
+    }
+    
+    uint16_t voutRaw = ADC_READ(gpioOutputVoltage);
+    uint16_t ilRaw = ADC_READ(gpioILCurrent);
+    
+    if(voutRaw > OVP_RAW){
+        if(++ovpCount >= OVP_DEBOUNCE){
+            ovpCount = 0;
+            recordFault(faultOverVoltage);
+            transToOverVoltageFault();
+            return;
+        }
+    }
+    else ovpCount = 0;
+    
+    if((ilRaw > SHORT_IL_RAW) && (voutRaw < SHORT_VOUT_RAW)){
+        if(++shortCount >= SHORT_DEBOUNCE){
+            shortCount = 0;
+            recordFault(faultShortCircuit);
+            transToShortCircuitFault();
+        }
+    }
+    else shortCount = 0;
+#endif
+}
+
+/*------------------------------------------------------------------------------
+ Function: runUnderVoltageProtection()
+ *Use: This function is called from slot 2 and checks the output against the
+ * reference in closed loop. It only counts once soft start has finished and
+ * the reference has reached its target, so a ramp or a restart into a heavy
+ * load is not mistaken for under voltage
+------------------------------------------------------------------------------*/
+void runUnderVoltageProtection(){
+#if PROTECTION_ENABLED == 1
+    bool settled = (softStartLimit == MAX_DUTY) && (referenceMilliVolts == referenceTargetMilliVolts);
+    if((currentState != voltageModeControl) || !settled){
+        uvpCount = 0;
+        return;
+    }
+    
+    if(readObservedVout() < ((int16_t) referenceMilliVolts - UVP_MARGIN_MV)){
+        if(++uvpCount >= UVP_DEBOUNCE){
+            uvpCount = 0;
+            recordFault(faultUnderVoltage);
+            transToUnderVoltageFault();
+        }
+    }
+    else uvpCount = 0;
+#endif
+}
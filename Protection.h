@@ -0,0 +1,58 @@
+/* 
+ * File:   Protection.h
+ * Author: agent
+ *
+ * Created on 19 October 2026, 11:42
+ */
+
+#ifndef PROTECTION_H
+#define	PROTECTION_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "Global.h"
+#include "Controller.h"
+#include "CurrentSensor.h"
+
+//software protection - over voltage and output short are checked every tick (490Hz) on a single unfiltered Vout and IL
+//conversion, compared in raw ADC units so no scaling is needed in the interrupt. Under voltage is checked each slot 2
+//against the reference, once soft start and the reference ramp have finished. Each check must fail for its debounce
+//count of consecutive samples, then the fault is recorded and the state machine enters the matching fault state, from
+//where the fault manager restarts as for an overcurrent trip
+#define PROTECTION_ENABLED          1       //1 enables the software protection, 0 removes the code
+#define OVP_MV                      20000   //output over voltage limit in millivolts
+#define OVP_DEBOUNCE                2u      //consecutive ticks over the limit before a fault, 4ms
+#define UVP_MARGIN_MV               2000    //under voltage when the output is this far below the settled reference
+#define UVP_DEBOUNCE                25u     //consecutive slot 2 samples under the limit before a fault, 100ms
+#define SHORT_IL_MA                 5000    //output short when IL is above this while Vout is below SHORT_VOUT_MV
+#define SHORT_VOUT_MV               2000
+#define SHORT_DEBOUNCE              2u      //consecutive ticks before a fault, 4ms
+
+//limits converted to single 10 bit conversions at build time, Vout raw = mV * 2^8 / VOLTAGE_SENSOR_GAIN (without
+//oversampling), IL raw = mA * 2^8 / CURRENT_SENSOR_GAIN + offset
+#define VOUT_MV_TO_RAW(milliVolts)  ((uint16_t) ((((uint32_t) (milliVolts)) << (VOLTAGE_SENSOR_EXPONENT - VSENSOR_OVERSAMPLE_EXPONENT)) / VOLTAGE_SENSOR_GAIN))
+#define IL_MA_TO_RAW(milliAmps)     ((uint16_t) (((((uint32_t) (milliAmps)) << CURRENT_SENSOR_EXPONENT) / CURRENT_SENSOR_GAIN) + CURRENT_SENSOR_OFFSET))
+#define OVP_RAW                     VOUT_MV_TO_RAW(OVP_MV)
+#define SHORT_VOUT_RAW              VOUT_MV_TO_RAW(SHORT_VOUT_MV)
+#define SHORT_IL_RAW                IL_MA_TO_RAW(SHORT_IL_MA)
+    
+#if PROTECTION_ENABLED == 1
+uint8_t ovpCount = 0;                       //consecutive samples failing each check
+uint8_t uvpCount = 0;
+uint8_t shortCount = 0;
+#endif
+
+void runProtection();
+void runUnderVoltageProtection();
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* PROTECTION_H */
@@ -0,0 +1,127 @@
+/* 
+ * File:   Reference.c
+ * Author: agent
+ *
+ * Created on 19 October 2026, 11:29
+ */
+
+#include "Global.h"
+#include "Reference.h"
+#include "Controller.h"
+
+//profile table, held in program memory. Each profile is a run of steps finished by REFERENCE_PROFILE_END
+//target (100mV), slew (mV per control period), hold (16 control periods)
+const struct referenceStep referenceProfileTable[] = {
+    //profile 0: step response test between the two jumper targets, 1s holds
+    {120, 255, 15}, {160, 255, 15}, {120, 255, 15}, {REFERENCE_PROFILE_END, 0, 0},
+    //profile 1: slow ramp up to 12V over 5s and hold
+    {120, 10, 0}, {REFERENCE_PROFILE_END, 0, 0},
+    //profile 2: load test staircase 8V, 10V, 12V with 2s holds at the default slew
+    {80, REFERENCE_SLEW_MV, 30}, {100, REFERENCE_SLEW_MV, 30}, {120, REFERENCE_SLEW_MV, 30}, {REFERENCE_PROFILE_END, 0, 0}
+};
+const uint8_t referenceProfileStart[] = {0, 4, 6};     //index of the first step of each profile
+#define NUMBER_OF_PROFILES (sizeof(referenceProfileStart) / sizeof(referenceProfileStart[0]))
+
+/*------------------------------------------------------------------------------
+ Function: runReferenceGenerator()
+ *Use: This function is called once per control period. It picks the target
+ * from the active source, steps through the profile table when a profile is
+ * running, and moves referenceMilliVolts towards the target by at most the
+ * slew rate
+------------------------------------------------------------------------------*/
+void runReferenceGenerator(){
+    
+    if(referenceMode == referenceJumper){
+        //use the second target voltage value if jumper has been removed
+        if(READ_CONTROL_SELECT()) referenceTargetMilliVolts = TARGET_VOLTAGE_MV_2;
+        else referenceTargetMilliVolts = TARGET_VOLTAGE_MV_1;
+        referenceSlew = REFERENCE_SLEW_MV;
+    }
+    
+    else if(referenceMode == referenceProfile){
+        const struct referenceStep *step = &referenceProfileTable[referenceStepIndex];
+        if(step->target == REFERENCE_PROFILE_END){
+            referenceMode = referenceFixed;         //profile finished, hold the last target
+        }
+        else{
+            referenceTargetMilliVolts = (uint16_t) step->target * 100u;
+            referenceSlew = step->slew;
+            if(referenceMilliVolts == referenceTargetMilliVolts){       //target reached, count the hold time
+                referenceHoldCount++;
+                if(referenceHoldCount >= ((uint16_t) step->hold << REFERENCE_HOLD_SHIFT)){
+                    referenceHoldCount = 0;
+                    referenceStepIndex++;
+                }
+            }
+        }
+    }
+    
+    //a profile step can ask for up to 25.5V, so limit every target here
+    if(referenceTargetMilliVolts > REFERENCE_MAX_MV) referenceTargetMilliVolts = REFERENCE_MAX_MV;
+    
+    //slew limit the reference towards the target, faster on a soft start ramp
+    uint8_t slew = referenceSlew;
+    if(referenceStartUp && (slew < REFERENCE_STARTUP_SLEW_MV)) slew = REFERENCE_STARTUP_SLEW_MV;
+    if(referenceMilliVolts < referenceTargetMilliVolts){
+        if((referenceTargetMilliVolts - referenceMilliVolts) > slew) referenceMilliVolts += slew;
+        else referenceMilliVolts = referenceTargetMilliVolts;
+    }
+    else if(referenceMilliVolts > referenceTargetMilliVolts){
+        if((referenceMilliVolts - referenceTargetMilliVolts) > slew) referenceMilliVolts -= slew;
+        else referenceMilliVolts = referenceTargetMilliVolts;
+    }
+    if(referenceMilliVolts == referenceTargetMilliVolts) referenceStartUp = 0;      //later target changes use the normal slew
+}
+
+/*------------------------------------------------------------------------------
+ Function: resetReference(startMilliVolts, startUp)
+ *Use: This function forces the reference to the given value, from where it 
+ * slews to the target, used to ramp up from the measured output on start up
+ * or restart. With startUp set the ramp uses REFERENCE_STARTUP_SLEW_MV, the
+ * soft start duty limit already bounds the inrush, so the ramp does not need
+ * to be as slow as a setpoint change on a running output
+------------------------------------------------------------------------------*/
+void resetReference(uint16_t startMilliVolts, bool startUp){
+    referenceMilliVolts = startMilliVolts;
+    referenceStartUp = startUp;
+}
+
+/*------------------------------------------------------------------------------
+ Function: startReferenceProfile(profileNumber)
+ *Use: This function starts the requested profile from its first step,
+ * returns 0 if the profile does not exist
+------------------------------------------------------------------------------*/
+bool startReferenceProfile(uint8_t profileNumber){
+    if(profileNumber >= NUMBER_OF_PROFILES) return 0;
+    
+    INTCONbits.GIE = 0;         //called from main loop, so prevent the control period seeing a half set up profile
+    referenceStepIndex = referenceProfileStart[profileNumber];
+    referenceHoldCount = 0;
+    referenceMode = referenceProfile;
+    INTCONbits.GIE = 1;
+    return 1;
+}
+
+/*------------------------------------------------------------------------------
+ Function: setReferenceTarget(targetMilliVolts)
+ *Use: This function sets a fixed target, which is approached at the default 
+ * slew rate, overriding the jumper and any running profile. Targets above
+ * REFERENCE_MAX_MV are limited to it
+------------------------------------------------------------------------------*/
+void setReferenceTarget(uint16_t targetMilliVolts){
+    if(targetMilliVolts > REFERENCE_MAX_MV) targetMilliVolts = REFERENCE_MAX_MV;
+    INTCONbits.GIE = 0;
+    referenceTargetMilliVolts = targetMilliVolts;
+    referenceSlew = REFERENCE_SLEW_MV;
+    referenceMode = referenceFixed;
+    INTCONbits.GIE = 1;
+}
+
+/*------------------------------------------------------------------------------
+ Function: releaseReference()
+ *Use: This function stops any profile or fixed target and returns control of
+ * the target to the jumper
+------------------------------------------------------------------------------*/
+void releaseReference(){
+    referenceMode = referenceJumper;
+}
@@ -0,0 +1,70 @@
+/* 
+ * File:   Reference.h
+ * Author: agent
+ *
+ * Created on 19 October 2026, 11:29
+ */
+
+#ifndef REFERENCE_H
+#define	REFERENCE_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "Global.h"
+#include "Protection.h"
+
+//reference generator settings - the voltage reference fed to the controller is moved towards its target at a limited
+//slew rate each control period (245Hz), rather than stepping, to bound overshoot on setpoint changes
+#define REFERENCE_SLEW_MV           20u         //default max reference change per control period, 20mV gives 4.9V/s
+#define REFERENCE_STARTUP_SLEW_MV   80u         //max change per control period on a soft start ramp, 19.6V/s reaches 16V in 0.8s
+#define REFERENCE_PROFILE_END       0xFFu       //target value marking the end of a profile in the table
+#define REFERENCE_HOLD_SHIFT        4u          //hold times in the table are in units of 2^4 = 16 control periods (65ms)
+#define REFERENCE_MAX_MV            18000u      //highest target accepted from any source, kept below OVP_MV so a reference change cannot trip OVP
+    
+#if REFERENCE_MAX_MV >= OVP_MV
+#error "REFERENCE_MAX_MV must be below OVP_MV"
+#endif
+#if (TARGET_VOLTAGE_MV_1 > REFERENCE_MAX_MV) || (TARGET_VOLTAGE_MV_2 > REFERENCE_MAX_MV)
+#error "the jumper target voltages must not be above REFERENCE_MAX_MV"
+#endif
+    
+//the source of the reference target
+enum referenceSource{
+    referenceJumper,            //TARGET_VOLTAGE_MV_1 or TARGET_VOLTAGE_MV_2 according to the control select jumper
+    referenceFixed,             //a target set by command
+    referenceProfile            //stepping through a profile from the table
+};
+
+//a profile is a list of steps, each ramps to the target at the given slew then holds for the given time
+struct referenceStep{
+    uint8_t target;             //target in units of 100mV, REFERENCE_PROFILE_END ends the profile
+    uint8_t slew;               //max change in mV per control period
+    uint8_t hold;               //hold time after reaching the target, in units of 16 control periods
+};
+
+uint16_t referenceMilliVolts = 0;                   //the slew limited reference used by the controller
+uint16_t referenceTargetMilliVolts = 0;             //the value the reference is moving towards
+uint8_t referenceSlew = REFERENCE_SLEW_MV;
+enum referenceSource referenceMode = referenceJumper;
+uint8_t referenceStepIndex = 0;                     //position in referenceProfileTable when running a profile
+uint16_t referenceHoldCount = 0;
+bool referenceStartUp = 0;                          //ramping up on a soft start, uses REFERENCE_STARTUP_SLEW_MV until the target is reached
+
+void runReferenceGenerator();
+void resetReference(uint16_t startMilliVolts, bool startUp);
+bool startReferenceProfile(uint8_t profileNumber);
+void setReferenceTarget(uint16_t targetMilliVolts);
+void releaseReference();
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* REFERENCE_H */
+
@@ -0,0 +1,146 @@
+/* 
+ * File:   Scope.c
+ * Author: agent
+ *
+ * Created on 19 October 2026, 11:45
+ */
+
+#include "Global.h"
+#include "Scope.h"
+#include "StateMachine.h"
+#include "Telemetry.h"
+
+#if (SCOPE_ENABLED == 1) && (TELEMETRY_ENABLED == 0)
+#error "scope mode dumps the capture as telemetry, set TELEMETRY_ENABLED"
+#endif
+
+/*------------------------------------------------------------------------------
+ Function: initialiseScope()
+ *Use: This function arms the default capture so the samples leading up to the
+ * first current trip are recorded without a command
+------------------------------------------------------------------------------*/
+void initialiseScope(){
+#if SCOPE_ENABLED == 1
+    armScope(SCOPE_DEFAULT_CHANNEL, SCOPE_DEFAULT_TRIGGER, 0);
+#endif
+}
+
+/*------------------------------------------------------------------------------
+ Function: armScope(channel, trigger, threshold)
+ *Use: This function starts a new capture, the channel is the ADC channel
+ * number with SCOPE_BURST_FLAG for a burst after the trigger, and the
+ * threshold is a raw 10 bit value for the level triggers. A capture still
+ * being dumped is abandoned. Also called from initialiseScope() before the
+ * interrupts are started, so the interrupt enable is restored rather than set
+------------------------------------------------------------------------------*/
+void armScope(uint8_t channel, enum scopeTrigger trigger, uint16_t threshold){
+#if SCOPE_ENABLED == 1
+    bool interruptsEnabled = INTCONbits.GIE;
+    INTCONbits.GIE = 0;                                 //called from the main loop, scopeTick() must not see a part set up capture
+    scopeChannel = channel;
+    scopeTriggerSource = trigger;
+    scopeThreshold = (uint8_t) (threshold >> 2);
+    scopeHead = 0;
+    scopeCount = 0;
+    scopeFire = 0;
+    scopeLastState = currentState;
+    scopeDumpIndex = 0;
+    scopeState = scopeArmed;
+    INTCONbits.GIE = interruptsEnabled;
+#endif
+}
+
+/*------------------------------------------------------------------------------
+ Function: triggerScope(source)
+ *Use: This function fires an armed capture from an event, the trigger is only
+ * taken if it matches the armed trigger
+------------------------------------------------------------------------------*/
+void triggerScope(enum scopeTrigger source){
+#if SCOPE_ENABLED == 1
+    if((scopeState == scopeArmed) && (source == scopeTriggerSource)) scopeFire = 1;
+#endif
+}
+
+/*------------------------------------------------------------------------------
+ Function: scopeTick()
+ *Use: This function is called from the interrupt each tick, it takes one
+ * sample while armed or triggered and checks the trigger. Triggers are not
+ * taken until SCOPE_PRE_TRIGGER samples of history have been recorded
+------------------------------------------------------------------------------*/
+void scopeTick(){
+#if SCOPE_ENABLED == 1
+    if((scopeState != scopeArmed) && (scopeState != scopeTriggered)) return;
+    
+    uint8_t channelSelect = (uint8_t) ((scopeChannel & ~SCOPE_BURST_FLAG) << 2);
+    uint8_t sample = (uint8_t) (readADCChannelRaw(channelSelect) >> 2);
+    scopeBuffer[scopeHead] = sample;
+    scopeHead = (scopeHead + 1) & (SIZE_OF_SCOPE_BUFFER - 1);
+    
+    if(scopeState == scopeArmed){
+        bool fired = scopeFire;
+        switch(scopeTriggerSource){
+            case scopeTriggerAbove:
+                fired = (sample > scopeThreshold);
+                break;
+            case scopeTriggerBelow:
+                fired = (sample < scopeThreshold);
+                break;
+            case scopeTriggerStateChange:
+                fired = (currentState != scopeLastState);
+                scopeLastState = currentState;
+                break;
+            default:
+                break;
+        }
+        if(scopeCount < SCOPE_PRE_TRIGGER){             //history not full yet
+            scopeCount++;
+            scopeFire = 0;
+            return;
+        }
+        if(!fired) return;
+        
+        scopeState = scopeTriggered;                    //this sample is the trigger point
+        scopeCount = SIZE_OF_SCOPE_BUFFER - SCOPE_PRE_TRIGGER - 1u;
+        if(scopeChannel & SCOPE_BURST_FLAG){            //take the rest back to back, in up to two parts as the buffer wraps
+            uint8_t toEnd = SIZE_OF_SCOPE_BUFFER - scopeHead;
+            if(toEnd > scopeCount) toEnd = scopeCount;
+            readADCChannelBurst(channelSelect, &scopeBuffer[scopeHead], toEnd);
+            readADCChannelBurst(channelSelect, scopeBuffer, scopeCount - toEnd);
+            scopeHead = (scopeHead + scopeCount) & (SIZE_OF_SCOPE_BUFFER - 1);
+            scopeCount = 0;
+        }
+    }
+    else{
+        scopeCount--;
+    }
+    
+    if(scopeCount == 0) scopeState = scopeCaptured;     //scopeHead is now the oldest sample
+#endif
+}
+
+/*------------------------------------------------------------------------------
+ Function: sendScopeTelemetry()
+ *Use: This function is called from the main loop and queues the next frame of
+ * a completed capture, the capture returns to idle once all are sent
+ * payload: channel with SCOPE_BURST_FLAG (1), trigger (1), index of the first
+ * sample in the frame (1), then SCOPE_SAMPLES_PER_FRAME samples, oldest first.
+ * The trigger sample is index SCOPE_PRE_TRIGGER
+------------------------------------------------------------------------------*/
+void sendScopeTelemetry(){
+#if SCOPE_ENABLED == 1
+    if(scopeState != scopeCaptured) return;
+    
+    uint8_t payload[SCOPE_SAMPLES_PER_FRAME + 3];
+    payload[0] = scopeChannel;
+    payload[1] = (uint8_t) scopeTriggerSource;
+    payload[2] = scopeDumpIndex;
+    for(uint8_t i = 0; i < SCOPE_SAMPLES_PER_FRAME; i++){
+        payload[i + 3] = scopeBuffer[(scopeHead + scopeDumpIndex + i) & (SIZE_OF_SCOPE_BUFFER - 1)];
+    }
+    
+    if(queueTelemetryFrame(TELEMETRY_ID_SCOPE, payload, sizeof(payload))){
+        scopeDumpIndex += SCOPE_SAMPLES_PER_FRAME;
+        if(scopeDumpIndex >= SIZE_OF_SCOPE_BUFFER) scopeState = scopeIdle;
+    }
+#endif
+}
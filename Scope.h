@@ -0,0 +1,76 @@
+/* 
+ * File:   Scope.h
+ * Author: agent
+ *
+ * Created on 19 October 2026, 11:45
+ */
+
+#ifndef SCOPE_H
+#define	SCOPE_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <xc.h>                                     //PIC hardware mapping
+#include "Global.h"
+#include "ADC.h"
+
+//scope mode - raw samples of one ADC channel are recorded into a circular buffer so the history before a trigger is kept,
+//then the samples after the trigger fill the rest of the buffer and the capture is dumped as telemetry frames
+//history is sampled once per 490Hz tick, as the ADC is only free inside the interrupt. After the trigger the samples can
+//be taken at the tick rate or as one back to back burst (approx 4us per sample at Fosc/8) to show the switching ripple
+//samples are the top 8 bits of the 10 bit result to fit the buffer in RAM alongside the IL FIFO in bank 3
+#define SCOPE_ENABLED               0       //1 enables capture and the scope telemetry frames (needs TELEMETRY_ENABLED), 0 removes the code
+#define SIZE_OF_SCOPE_BUFFER        32u     //number of samples, must be a power of 2
+#define SCOPE_PRE_TRIGGER           8u      //samples kept from before the trigger, the trigger sample is the first one after these
+#define SCOPE_SAMPLES_PER_FRAME     8u      //samples in each dump frame
+#define SCOPE_BURST_FLAG            0x80u   //set in the channel byte of the arm command for a burst capture after the trigger
+    
+//capture armed at start up, IL at the tick rate on a current trip so the lead up to the first trip is always available
+#define SCOPE_DEFAULT_CHANNEL       ADC_CHANNEL(gpioILCurrent)
+#define SCOPE_DEFAULT_TRIGGER       scopeTriggerCurrentTrip
+    
+enum scopeTrigger{
+    scopeTriggerCurrentTrip,                //current trip limit reached in currentTripMonitor()
+    scopeTriggerAbove,                      //sample rises above the threshold, use the Vout channel for a Vout threshold
+    scopeTriggerBelow,                      //sample falls below the threshold
+    scopeTriggerStateChange,                //state machine changes state
+    scopeTriggerCommand                     //COMMAND_ID_SCOPE_TRIGGER received
+};
+
+enum scopeState{
+    scopeIdle,                              //no capture, waiting for the arm command
+    scopeArmed,                             //recording history, waiting for the trigger
+    scopeTriggered,                         //recording the samples after the trigger
+    scopeCaptured                           //capture complete, being dumped from the main loop
+};
+
+#if SCOPE_ENABLED == 1
+__bank(3) uint8_t scopeBuffer[SIZE_OF_SCOPE_BUFFER];
+volatile enum scopeState scopeState = scopeIdle;
+uint8_t scopeChannel = 0;                           //ADC channel number and SCOPE_BURST_FLAG
+enum scopeTrigger scopeTriggerSource = scopeTriggerCurrentTrip;
+uint8_t scopeThreshold = 0;                         //level trigger threshold, in the same 8 bit units as the samples
+uint8_t scopeHead = 0;                              //next sample to write, the oldest sample once captured
+uint8_t scopeCount = 0;                             //history samples recorded while armed, samples still to take once triggered
+volatile bool scopeFire = 0;                        //set by triggerScope() and taken at the next sample
+uint8_t scopeLastState = 0;                         //state machine state at the previous sample
+uint8_t scopeDumpIndex = 0;
+#endif
+
+void initialiseScope();
+void armScope(uint8_t channel, enum scopeTrigger trigger, uint16_t threshold);
+void triggerScope(enum scopeTrigger source);
+void scopeTick();
+void sendScopeTelemetry();
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* SCOPE_H */
@@ -0,0 +1,147 @@
+/* 
+ * File:   Share.c
+ * Author: agent
+ *
+ * Created on 19 October 2026, 11:52
+ */
+
+#include "Global.h"
+#include "Share.h"
+#include "CurrentSensor.h"
+#include "StateMachine.h"
+#include "Telemetry.h"
+#include "Command.h"
+#include "FixedPoint.h"
+
+#if (SHARE_ENABLED == 1) && ((TELEMETRY_ENABLED == 0) || (COMMAND_ENABLED == 0))
+#error "current sharing sends and receives on the EUSART, set TELEMETRY_ENABLED and COMMAND_ENABLED"
+#endif
+
+/*------------------------------------------------------------------------------
+ Function: initialiseShare()
+ *Use: This function marks every other node as not heard, so the trim stays at
+ * 0 until frames arrive
+------------------------------------------------------------------------------*/
+void initialiseShare(){
+#if SHARE_ENABLED == 1
+    for(uint8_t node = 0; node < SHARE_MAX_NODES; node++){
+        shareCurrent[node] = 0;
+        shareAge[node] = SHARE_TIMEOUT;
+    }
+#endif
+}
+
+/*------------------------------------------------------------------------------
+ Function: shareTick()
+ *Use: This function is called from the interrupt each tick, it flags this
+ * node's slot to the main loop and updates the trim once per SHARE_PERIOD.
+ * If the frame sent in the last slot was not heard back the slots are moved
+ * and the frame is sent from the new slot
+------------------------------------------------------------------------------*/
+void shareTick(){
+#if SHARE_ENABLED == 1
+    if(shareTickCount == (SHARE_NODE_ID * SHARE_SLOT_TICKS)){
+        if(shareSent && !shareEchoed){
+            if(shareCollisionCount < 0xFFFFu) shareCollisionCount++;
+            shareTickCount += SHARE_NODE_ID + 1u;
+            shareSent = 0;
+        }
+        else{
+            shareDue = 1;
+            shareSent = 1;
+            shareEchoed = 0;
+        }
+    }
+    if(++shareTickCount >= SHARE_PERIOD){
+        shareTickCount = 0;
+        runShareTrim();
+    }
+#endif
+}
+
+/*------------------------------------------------------------------------------
+ Function: runShareTrim()
+ *Use: This function moves the trim by a fraction of the difference between the
+ * average current of the nodes heard and this node's current. The trim is only
+ * integrated while regulating voltage, and decays to 0 otherwise so a node
+ * that stops or faults rejoins from its own target
+------------------------------------------------------------------------------*/
+void runShareTrim(){
+#if SHARE_ENABLED == 1
+    shareOwnCurrent = convertRawToMilliAmps(hotState.filteredIL);
+    
+    int32_t sum = shareOwnCurrent;
+    uint8_t count = 1;
+    for(uint8_t node = 0; node < SHARE_MAX_NODES; node++){
+        if(shareAge[node] < SHARE_TIMEOUT){
+            sum += shareCurrent[node];
+            count++;
+            shareAge[node]++;
+        }
+    }
+    
+    if((currentState != voltageModeControl) || (count == 1)){
+        shareTrim -= shareTrim >> 2;
+        return;
+    }
+    int16_t average = (int16_t) (sum / count);
+    int16_t difference = subSaturated(average, shareOwnCurrent);
+    shareTrim = clampInt16(shareTrim + (difference >> SHARE_SHIFT), -SHARE_TRIM_LIMIT_MV, SHARE_TRIM_LIMIT_MV);
+#endif
+}
+
+/*------------------------------------------------------------------------------
+ Function: recordShareCurrent(node, milliAmps)
+ *Use: This function is called by the command parser for each share frame
+ * received. This node's own frame heard back on the bus shows it did not
+ * collide, a frame from a lower node sets the slot counter to that node's,
+ * and frames from an unknown node are ignored
+------------------------------------------------------------------------------*/
+void recordShareCurrent(uint8_t node, int16_t milliAmps){
+#if SHARE_ENABLED == 1
+    if(node == SHARE_NODE_ID){
+        shareEchoed = 1;
+        return;
+    }
+    if(node >= SHARE_MAX_NODES) return;
+    INTCONbits.GIE = 0;         //called from main loop, so prevent runShareTrim() seeing half of the new current
+    shareCurrent[node] = milliAmps;
+    shareAge[node] = 0;
+    if(node < SHARE_NODE_ID) shareTickCount = (uint8_t) (node * SHARE_SLOT_TICKS + SHARE_RESYNC_TICKS);
+    INTCONbits.GIE = 1;
+#endif
+}
+
+/*------------------------------------------------------------------------------
+ Function: readShareTrim()
+ *Use: This function returns the trim in mV added to the voltage target, 0
+ * when sharing is disabled
+------------------------------------------------------------------------------*/
+int16_t readShareTrim(){
+#if SHARE_ENABLED == 1
+    return shareTrim;
+#else
+    return 0;
+#endif
+}
+
+/*------------------------------------------------------------------------------
+ Function: sendShareTelemetry()
+ *Use: This function queues this node's share frame when its slot is due
+ * payload: node ID (1), filtered IL in mA (2), big endian
+------------------------------------------------------------------------------*/
+void sendShareTelemetry(){
+#if SHARE_ENABLED == 1
+    uint8_t payload[3];
+    
+    INTCONbits.GIE = 0;
+    shareDue = 0;
+    int16_t ownCurrent = shareOwnCurrent;
+    INTCONbits.GIE = 1;
+    
+    payload[0] = SHARE_NODE_ID;
+    payload[1] = (uint8_t) ((uint16_t) ownCurrent >> 8);
+    payload[2] = (uint8_t) ownCurrent;
+    queueTelemetryFrame(TELEMETRY_ID_SHARE, payload, sizeof(payload));
+#endif
+}
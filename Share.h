@@ -0,0 +1,73 @@
+/* 
+ * File:   Share.h
+ * Author: agent
+ *
+ * Created on 19 October 2026, 11:52
+ */
+
+#ifndef SHARE_H
+#define	SHARE_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <xc.h>                                     //PIC hardware mapping
+#include "Global.h"
+
+//active current sharing between converters in parallel - each node sends its filtered IL on a shared serial bus and
+//trims its voltage target towards the average current of the nodes it hears, on top of the droop (Controller.h).
+//The bus is the EUSART: every TX drives one line through an open drain (diode to the line, pull up on the line) and every
+//RX listens to it. Nodes take turns in fixed slots from SHARE_NODE_ID so frames do not collide, and for the same reason
+//the periodic telemetry frames are not sent while sharing. Frames use the telemetry format with TELEMETRY_ID_SHARE
+//each node's tick clock drifts from the others and they power up at different times, so the slot counter is set from
+//each frame heard from a lower node, which puts every node in step with node 0 (or the lowest node present). A node
+//also hears its own frame back on the bus, a frame not heard back intact by its next slot collided with another node's,
+//so the node moves its slots SHARE_NODE_ID + 1 ticks later, a different amount for each node, and the colliding nodes
+//separate until they can hear and synchronise to each other
+#define SHARE_ENABLED               0       //1 enables current sharing (needs TELEMETRY_ENABLED and COMMAND_ENABLED), 0 removes the code
+#define SHARE_NODE_ID               0u      //unique for each board on the bus, 0 to SHARE_MAX_NODES-1
+#define SHARE_MAX_NODES             4u
+#define SHARE_PERIOD                49u     //ticks between frames from each node and trim updates, 10Hz
+#define SHARE_SLOT_TICKS            8u      //ticks between the slots of each node, 16ms, a frame takes 0.6ms
+#define SHARE_TIMEOUT               5u      //share periods without a frame before a node is left out of the average
+#define SHARE_SHIFT                 4u      //trim change each period in mV = (average - own current in mA) >> 4
+#define SHARE_TRIM_LIMIT_MV         500     //max trim either way, a failed node cannot pull the others far from the target
+#define SHARE_RESYNC_TICKS          1u      //ticks from a node's slot to its frame being received here, the frame is sent and
+                                            //heard within the tick after the slot
+    
+#if (SHARE_MAX_NODES * SHARE_SLOT_TICKS) > SHARE_PERIOD
+#error "all share slots must fit in SHARE_PERIOD"
+#endif
+#if SHARE_NODE_ID >= SHARE_MAX_NODES
+#error "SHARE_NODE_ID must be below SHARE_MAX_NODES"
+#endif
+
+#if SHARE_ENABLED == 1
+int16_t shareCurrent[SHARE_MAX_NODES];              //latest current from each node in mA
+uint8_t shareAge[SHARE_MAX_NODES];                  //share periods since each node was heard, SHARE_TIMEOUT when not heard
+uint8_t shareTickCount = 0;
+volatile bool shareDue = 0;                         //set in the interrupt in this node's slot to send the frame from main loop
+int16_t shareOwnCurrent = 0;                        //own current at the last trim update, sent in the frame
+int16_t shareTrim = 0;                              //voltage target trim in mV
+bool shareSent = 0;                                 //own frame due since the last slot
+volatile bool shareEchoed = 0;                      //own frame heard back on the bus since the last slot
+uint16_t shareCollisionCount = 0;                   //own frames not heard back, the bus collided
+#endif
+
+void initialiseShare();
+void shareTick();
+void runShareTrim();
+void recordShareCurrent(uint8_t node, int16_t milliAmps);
+int16_t readShareTrim();
+void sendShareTelemetry();
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* SHARE_H */
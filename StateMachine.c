@@ -10,6 +10,8 @@
 #include "GPIO.h"
 #include "GPIO.h"
 #include "ADC.h"
+#include "Controller.h"
+#include "Potentiometer.h"
 
 /*------------------------------------------------------------------------------
  Function: transToInitialising(state)
@@ -51,7 +53,133 @@ void transToCurrentModeControl(){
  * outputs
 ------------------------------------------------------------------------------*/
 void transToOverCurrentFault(){
-    setDuty = 0;    //turn off PWM
-    setPeriod = 0;    
+    stopOutputForFault();
     currentState = overCurrentFault;
-}
\ No newline at end of file
+}
+
+/*------------------------------------------------------------------------------
+ Function: transToOverVoltageFault(state)
+ *Use: This function sets the state to over voltage fault and clears the PWM
+ * outputs
+------------------------------------------------------------------------------*/
+void transToOverVoltageFault(){
+    stopOutputForFault();
+    currentState = overVoltageFault;
+}
+
+/*------------------------------------------------------------------------------
+ Function: transToUnderVoltageFault(state)
+ *Use: This function sets the state to under voltage fault and clears the PWM
+ * outputs
+------------------------------------------------------------------------------*/
+void transToUnderVoltageFault(){
+    stopOutputForFault();
+    currentState = underVoltageFault;
+}
+
+/*------------------------------------------------------------------------------
+ Function: transToShortCircuitFault(state)
+ *Use: This function sets the state to short circuit fault and clears the PWM
+ * outputs
+------------------------------------------------------------------------------*/
+void transToShortCircuitFault(){
+    stopOutputForFault();
+    currentState = shortCircuitFault;
+}
+
+/*------------------------------------------------------------------------------
+ Function: stopOutputForFault()
+ *Use: This function clears the PWM outputs on entry to any fault state
+------------------------------------------------------------------------------*/
+void stopOutputForFault(){
+    hotState.setDuty = 0;    //turn off PWM
+    stopSynchronousRectifier();     //a duty of 0 would hold the low side on in half bridge mode
+    hotState.setPeriod = 0;    
+}
+
+/*------------------------------------------------------------------------------
+ Function: initialiseModeSelect()
+ *Use: This function sets up the mode input and takes its level at start up as
+ * the accepted level, so only later changes cause a mode switch
+------------------------------------------------------------------------------*/
+void initialiseModeSelect(){
+#if MODE_INPUT_ENABLED == 1
+    GPIO_SET_INPUT(gpioModeSelect);
+    
+    //debounce the start up level before the mode decision, the input must read the same for MODE_DEBOUNCE_COUNT reads
+    //spaced MODE_STARTUP_READ_MS apart, so contact bounce and a slowly settling input are both covered
+    uint8_t stableCount = 0;
+    modeInputLevel = GPIO_READ(gpioModeSelect);
+    while(stableCount < MODE_DEBOUNCE_COUNT){
+        __delay_ms(MODE_STARTUP_READ_MS);
+        bool level = GPIO_READ(gpioModeSelect);
+        if(level == modeInputLevel) stableCount++;
+        else{
+            modeInputLevel = level;
+            stableCount = 0;
+        }
+    }
+#endif
+}
+
+/*------------------------------------------------------------------------------
+ Function: readClosedLoopSelect()
+ *Use: This function returns true if closed loop control is selected at start
+ * up, from the mode input or from the control select jumper when the mode
+ * input is disabled
+------------------------------------------------------------------------------*/
+bool readClosedLoopSelect(){
+#if MODE_INPUT_ENABLED == 1
+    return !modeInputLevel;
+#else
+    return !READ_CONTROL_SELECT();
+#endif
+}
+
+/*------------------------------------------------------------------------------
+ Function: requestControlMode(closedLoop)
+ *Use: This function requests a switch to closed loop or pot control, the
+ * switch is made by runModeSelect() in the next slot 4
+------------------------------------------------------------------------------*/
+void requestControlMode(bool closedLoop){
+    if(closedLoop) pendingModeRequest = modeRequestClosedLoop;
+    else pendingModeRequest = modeRequestPot;
+}
+
+/*------------------------------------------------------------------------------
+ Function: runModeSelect()
+ *Use: This function is called from slot 4, it debounces the mode input when
+ * enabled and carries out any pending mode request. Moving to closed loop preloads the
+ * controller from the present duty and output, moving to pot control ramps
+ * from the present duty and period to the pot settings, so neither direction
+ * causes a duty step. Requests are held while initialising or in a fault and
+ * carried out once running again
+------------------------------------------------------------------------------*/
+void runModeSelect(){
+#if MODE_INPUT_ENABLED == 1
+    bool level = GPIO_READ(gpioModeSelect);
+    if(level == modeInputLevel) modeDebounceCount = 0;
+    else if(++modeDebounceCount >= MODE_DEBOUNCE_COUNT){
+        modeDebounceCount = 0;
+        modeInputLevel = level;
+        requestControlMode(!level);             //low selects closed loop
+    }
+#endif
+    
+    if(pendingModeRequest == modeRequestNone) return;
+    if((currentState == initialising) || IS_FAULT_STATE(currentState)) return;
+    
+    if(pendingModeRequest == modeRequestClosedLoop){
+        if(currentState == potControl){
+            preloadController();
+            if(CONTROL_METHOD == VOLTAGE_MODE_CONTROL) transToVoltageModeControl();
+            else if(CONTROL_METHOD == CURRENT_MODE_CONTROL) transToCurrentModeControl();
+            else if(CONTROL_METHOD == CCCV_MODE_CONTROL) transToVoltageModeControl();
+        }
+    }
+    else if(currentState != potControl){
+        startPotHandover();
+        transToPotControl();
+    }
+    pendingModeRequest = modeRequestNone;
+}
@@ -18,7 +18,7 @@ extern "C" {
 #include <stdbool.h>
 #include <stdint.h>   
 #include "Global.h"  
-#include "PWM.h""
+#include "PWM.h"
 
 //the list of states in state machine
 enum stateMachine{
@@ -26,16 +26,50 @@ enum stateMachine{
     potControl,
     voltageModeControl,
     currentModeControl,
-    overCurrentFault
+    overCurrentFault,               //fault states must stay last, see IS_FAULT_STATE()
+    overVoltageFault,
+    underVoltageFault,
+    shortCircuitFault
 };
 
-enum stateMachine currentState = 0;  //initialising by default
+#define IS_FAULT_STATE(state)       ((state) >= overCurrentFault)
+
+__bank(0) enum stateMachine currentState = 0;  //initialising by default, read every tick so kept in bank 0 with hotState
+
+//runtime mode switching - a mode request by command (COMMAND_ID_SET_MODE) moves between pot control and closed loop
+//control with a bumpless handover. With the mode input enabled its level is also debounced in slot 4 and a change is a
+//request, the most recent of the two wins. With the input disabled the start up mode is read once from the control
+//select jumper. RA7 has no weak pull up, so only enable the input on boards with an external pull up or a driven input
+#define MODE_INPUT_ENABLED          0
+#define MODE_DEBOUNCE_COUNT         16u     //consecutive slot 4 reads (122.5Hz) the input must hold before a change is accepted, 130ms
+#define MODE_STARTUP_READ_MS        2u      //time between the start up reads, the level must hold for MODE_DEBOUNCE_COUNT reads, 32ms
+    
+//pending mode change, actioned from the interrupt so the handover cannot be split by a control period
+enum modeRequest{
+    modeRequestNone,
+    modeRequestPot,
+    modeRequestClosedLoop
+};
+
+volatile enum modeRequest pendingModeRequest = modeRequestNone;
+#if MODE_INPUT_ENABLED == 1
+bool modeInputLevel = 1;                        //last accepted level of the mode input
+uint8_t modeDebounceCount = 0;
+#endif
 
 void transToInitialising();
 void transToPotControl();
 void transToVoltageModeControl();
 void transToCurrentModeControl();
 void transToOverCurrentFault();
+void transToOverVoltageFault();
+void transToUnderVoltageFault();
+void transToShortCircuitFault();
+void stopOutputForFault();
+void initialiseModeSelect();
+bool readClosedLoopSelect();
+void runModeSelect();
+void requestControlMode(bool closedLoop);
 
 #ifdef	__cplusplus
 }
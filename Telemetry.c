@@ -0,0 +1,127 @@
+/* 
+ * File:   Telemetry.c
+ * Author: agent
+ *
+ * Created on 19 October 2026, 11:25
+ */
+
+#include "Global.h"
+#include "Telemetry.h"
+#include "FaultManager.h"
+#include "Benchmark.h"
+#include "Energy.h"
+#include "Scope.h"
+#include "Share.h"
+
+/*------------------------------------------------------------------------------
+ Function: initialiseTelemetry()
+ *Use: This function sets up the EUSART as an asynchronous transmitter at
+ * 115200 baud, with TX steered onto RB5
+------------------------------------------------------------------------------*/
+void initialiseTelemetry(){
+#if TELEMETRY_ENABLED == 1
+    APFCON1bits.TXCKSEL = 1;        //steer TX onto RB5
+    GPIO_SET_OUTPUT(gpioTelemetryTX);
+    
+    BAUDCONbits.BRG16 = 1;          //16 bit baud rate generator
+    TXSTAbits.BRGH = 1;             //high speed baud rate
+    SPBRGH = 0;
+    SPBRGL = TELEMETRY_BAUD_DIVIDER;
+    
+    TXSTAbits.SYNC = 0;             //asynchronous mode
+    RCSTAbits.SPEN = 1;             //enable the serial port
+    TXSTAbits.TXEN = 1;             //enable transmitter, TXIE is left off as the buffer is emptied by polling from main loop
+#endif
+}
+
+/*------------------------------------------------------------------------------
+ Function: telemetryTick()
+ *Use: This function is called from the interrupt each tick and flags to the
+ * main loop when the next set of telemetry frames is due
+------------------------------------------------------------------------------*/
+void telemetryTick(){
+#if TELEMETRY_ENABLED == 1
+    telemetryTickCount++;
+    if(telemetryTickCount >= TELEMETRY_PERIOD){
+        telemetryTickCount = 0;
+        telemetryDue = 1;
+    }
+#endif
+}
+
+/*------------------------------------------------------------------------------
+ Function: runTelemetry()
+ *Use: This function is called repeatedly from the main loop, it builds the
+ * telemetry frames when due and moves one byte at a time from the ring buffer
+ * into the EUSART whenever the transmit register is empty, so it never blocks
+ * Frames are built one at a time once the ring buffer has emptied so the
+ * buffer only needs to hold the largest frame, a scope capture is dumped in
+ * the time left between the periodic frames. With current sharing only the
+ * share frame is sent, in this node's slot
+------------------------------------------------------------------------------*/
+void runTelemetry(){
+#if TELEMETRY_ENABLED == 1
+    if(telemetryHead == telemetryTail){
+#if SHARE_ENABLED == 1
+        if(shareDue) sendShareTelemetry();
+#else
+        if(telemetryDue){
+            switch(telemetryNextFrame++){
+                case 0:
+                    sendFaultTelemetry();
+                    break;
+                case 1:
+                    sendBenchmarkTelemetry();
+                    break;
+                case 2:
+                    sendEnergyTelemetry();
+                    break;
+                default:
+                    telemetryNextFrame = 0;
+                    telemetryDue = 0;
+                    break;
+            }
+        }
+        else{
+            sendScopeTelemetry();
+        }
+#endif
+    }
+    
+    if((telemetryHead != telemetryTail) && PIR1bits.TXIF){
+        TXREG = telemetryBuffer[telemetryTail];
+        telemetryTail = (telemetryTail + 1) & (SIZE_OF_TELEMETRY_BUFFER - 1);
+    }
+#endif
+}
+
+/*------------------------------------------------------------------------------
+ Function: queueTelemetryFrame(frameID, payload, length)
+ *Use: This function wraps the payload in a frame and adds it to the transmit
+ * ring buffer, the whole frame is dropped if there is not enough space so
+ * partial frames are never sent. Returns 1 if the frame was queued
+------------------------------------------------------------------------------*/
+bool queueTelemetryFrame(uint8_t frameID, const uint8_t *payload, uint8_t length){
+#if TELEMETRY_ENABLED == 1
+    uint8_t used = (telemetryHead - telemetryTail) & (SIZE_OF_TELEMETRY_BUFFER - 1);
+    if((uint8_t)(length + 4u) >= (SIZE_OF_TELEMETRY_BUFFER - used)) return 0;     //sync, ID, length and checksum add 4 bytes
+    
+    uint8_t checksum = frameID + length;
+    telemetryBuffer[telemetryHead] = TELEMETRY_SYNC;
+    telemetryHead = (telemetryHead + 1) & (SIZE_OF_TELEMETRY_BUFFER - 1);
+    telemetryBuffer[telemetryHead] = frameID;
+    telemetryHead = (telemetryHead + 1) & (SIZE_OF_TELEMETRY_BUFFER - 1);
+    telemetryBuffer[telemetryHead] = length;
+    telemetryHead = (telemetryHead + 1) & (SIZE_OF_TELEMETRY_BUFFER - 1);
+    for(uint8_t i = 0; i < length; i++){
+        telemetryBuffer[telemetryHead] = payload[i];
+        checksum += payload[i];
+        telemetryHead = (telemetryHead + 1) & (SIZE_OF_TELEMETRY_BUFFER - 1);
+    }
+    telemetryBuffer[telemetryHead] = checksum;
+    telemetryHead = (telemetryHead + 1) & (SIZE_OF_TELEMETRY_BUFFER - 1);
+    return 1;
+#else
+    return 0;
+#endif
+}
@@ -0,0 +1,56 @@
+/* 
+ * File:   Telemetry.h
+ * Author: agent
+ *
+ * Created on 19 October 2026, 11:25
+ */
+
+#ifndef TELEMETRY_H
+#define	TELEMETRY_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <xc.h>                                     //PIC hardware mapping
+#include "Global.h"
+
+//telemetry is sent from the main loop over the EUSART TX, which is steered onto RB5 (shared with the slot 2 test pin)
+//frames are binary: TELEMETRY_SYNC, frame ID, payload length, payload, then a checksum of the ID, length and payload bytes
+#define TELEMETRY_ENABLED           0       //1 enables the EUSART and telemetry frames, 0 removes the code to reduce memory consumption
+#define TELEMETRY_BAUD_DIVIDER      68u     //SPBRG for 16 bit BRG with BRGH, baud = 32MHz / (4 * (68 + 1)) = 115942 (0.6% from 115200)
+#define TELEMETRY_PERIOD            49u     //number of 490Hz ticks between telemetry frames, 49 gives 10Hz
+#define TELEMETRY_SYNC              0xA5u   //start of frame marker
+#define SIZE_OF_TELEMETRY_BUFFER    32u     //size of transmit ring buffer, must be a power of 2, holds the largest frame (bank 4 has 48 bytes)
+    
+//frame IDs
+#define TELEMETRY_ID_FAULTS         0x01u
+#define TELEMETRY_ID_BENCHMARK      0x02u
+#define TELEMETRY_ID_ENERGY         0x03u
+#define TELEMETRY_ID_SCOPE          0x04u
+#define TELEMETRY_ID_SHARE          0x05u   //also received, see Share.h
+
+#if TELEMETRY_ENABLED == 1
+__bank(4) uint8_t telemetryBuffer[SIZE_OF_TELEMETRY_BUFFER];    //transmit ring buffer, only accessed from the main loop
+uint8_t telemetryHead = 0;
+uint8_t telemetryTail = 0;
+volatile bool telemetryDue = 0;                       //set in the interrupt each TELEMETRY_PERIOD to request frames from main loop
+uint8_t telemetryNextFrame = 0;                     //frame of the due set to build next, frames are built one at a time
+uint8_t telemetryTickCount = 0;
+#endif
+
+void initialiseTelemetry();
+void telemetryTick();
+void runTelemetry();
+bool queueTelemetryFrame(uint8_t frameID, const uint8_t *payload, uint8_t length);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* TELEMETRY_H */
+
@@ -24,12 +24,24 @@
 #include "ADC.h"
 #include "Potentiometer.h"
 #include "StateMachine.h"
+#include "FaultManager.h"
+#include "Telemetry.h"
+#include "Command.h"
+#include "Benchmark.h"
+#include "Observer.h"
+#include "InputVoltage.h"
+#include "Protection.h"
+#include "Energy.h"
+#include "Scope.h"
+#include "Share.h"
 
 volatile bool timerSlotHalf = 0;
 volatile bool timerSlotQuarter = 0;
 volatile bool slotTest = 0;
 
 void setupInternalOscillator(const enum internalClockFreqSelec selectedFreq);
+void initialiseFirmware();
+void runBackgroundTasks();
 
 /*------------------------------------------------------------------------------
  Function: Tick490Hz()
@@ -44,55 +56,78 @@ void __interrupt() Tick490Hz(void){      //This function is called on each inter
     if (TMR0IF_bit) {   //Check if Timer0 has caused the interrupt. Timer 0 interrupt operates at 490Hz or every 2ms
     
     //Timer Interrupt Slots:     Timing Graph:                        Functions:
-    //490Hz interrupt            |------|------|------|------|        currentTripMonitor() setPWMDutyandPeriod()
+    //490Hz interrupt            |------|------|------|------|        currentTripMonitor() runProtection() runFaultManager() shareTick() setPWMDutyandPeriod() scopeTick()
     //245Hz Slot 1:              1-------------1-------------1        controlRoutine()
-    //245Hz Slot 2:              -------2-------------2-------        readFilteredVout() readFilteredIL()
+    //245Hz Slot 2:              -------2-------------2-------        runInputVoltage() readFilteredVout() readFilteredIL() runSynchronousRectifier() runObserver() runUnderVoltageProtection() runEnergyMeter()
     //122.5Hz Slot 3:            -------3---------------------        runPotScaling()
-    //122.5Hz Slot 4:            ---------------------4-------        readFilteredDutyPot() readFilteredFreqPot()
+    //122.5Hz Slot 4:            ---------------------4-------        readFilteredDutyPot() readFilteredFreqPot() runModeSelect()
     
-        writeGPIO(gpioSlotTest, 1);     //to test slot utilisation - set GPIO pin RB4 high at start
+        SLOT_TEST_WRITE(1);    //to test slot utilisation - set GPIO pin RB4 high at start
+        hotState.tickCount++;
         currentTripMonitor();
-        setPWMDutyandPeriod(setDuty, setPeriod);
+        runProtection();
+        runFaultManager();
+        telemetryTick();
+        shareTick();
+        setPWMDutyandPeriod(hotState.setDuty, hotState.setPeriod);
+        scopeTick();
+        BENCHMARK_SLOT_END(benchmarkCommon);
         
        //each half slot occurs at 245Hz or every 4ms
         if(timerSlotHalf == false){
             //slot 1------------------------------------------------------------
             controlRoutine();
-            writeGPIO(gpioSlotTest, 0); //clear after slot 1 to measure slot 1 utilisation
+            BENCHMARK_SLOT_END(benchmarkSlot1);
+            SLOT_TEST_WRITE(0); //clear after slot 1 to measure slot 1 utilisation
         }
 
         if(timerSlotHalf == true){
             //slot 2------------------------------------------------------------
-            writeGPIO(gpioSlotTest2, 1);   //set GPIO pin RB5 to show slot 2 on scope - compare with RB4
-            filteredIL = readFilteredIL();
-            //filteredIDS = readFilteredIDS();     
-            filteredVout = readFilteredVout();
+            GPIO_WRITE(gpioSlotTest2, 1);  //set GPIO pin RB5 to show slot 2 on scope - compare with RB4
+            runInputVoltage();
+            hotState.latestIL = ADC_READ(gpioILCurrent);    //IL sample for the filter and observer, unless taken on CCP1 below
+            hotState.filteredIL = readFilteredIL();
+            runSynchronousRectifier(convertRawToMilliAmps(hotState.filteredIL));
+#if INTERLEAVED_ENABLED == 1
+            hotState.filteredIDS = readFilteredIDS();       //phase 2 current
+            runCurrentBalance();
+#elif (ENERGY_METER_ENABLED == 1) && ENERGY_INPUT_ENABLED
+            hotState.filteredIDS = readFilteredIDS();       //input current for the energy meter
+#endif
+            //hotState.filteredIDS = readFilteredIDS();     
+            hotState.filteredVout = readFilteredVout();
+            runObserver(voutFIFO[SIZE_OF_VSENSOR_FILTER-1], hotState.latestIL);    //newest unfiltered samples
+            runUnderVoltageProtection();
+            runEnergyMeter();
             
             //each quarter slot occurs at 122.5Hz or every 8ms
             if(timerSlotQuarter == false){
                 //slot 3--------------------------------------------------------
                 runPotScaling();
+                BENCHMARK_SLOT_END(benchmarkSlot3);
             }
             
             if(timerSlotQuarter == true){
                 //slot 4--------------------------------------------------------
                 filteredDutyPot = readFilteredDutyPot();
                 filteredFreqPot = readFilteredFreqPot();               
+                runModeSelect();
+                BENCHMARK_SLOT_END(benchmarkSlot4);
             }           
           
-            timerSlotQuarter = ~timerSlotQuarter;
-            writeGPIO(gpioSlotTest, 0);    //clear after slot 2 to measure slot 2 utilisation
-            writeGPIO(gpioSlotTest2, 0);   //clear GPIO pin RB5 to show slot 2 on scope - compare with RB4
+            timerSlotQuarter = !timerSlotQuarter;
+            SLOT_TEST_WRITE(0);   //clear after slot 2 to measure slot 2 utilisation
+            GPIO_WRITE(gpioSlotTest2, 0);  //clear GPIO pin RB5 to show slot 2 on scope - compare with RB4
         }
 
-        timerSlotHalf = ~timerSlotHalf;
+        timerSlotHalf = !timerSlotHalf;
         INTCONbits.TMR0IF = 0;         // clear interrupt flag
 
     }
     
     //option to take a current sample on overflow of the CPP1 (at falling edge of PWM) - untested
     /*if(CCP1IF_bit){
-        latestIL = readILCurrentADCRaw();   //fast function for reading the IL current
+        hotState.latestIL = readILCurrentADCRaw();   //fast function for reading the IL current
         PIR1bits.CCP1IF = 0;               //clear the interrupt flag
     }*/
 
@@ -106,30 +141,70 @@ void __interrupt() Tick490Hz(void){      //This function is called on each inter
 ------------------------------------------------------------------------------*/
 int main(int argc, char** argv) {
     
+    initialiseFirmware();
+
+    while(1){           //infinite loop to hold uC in operation, background tasks which are too slow for the interrupt run here
+        runBackgroundTasks();
+    }
+    return (EXIT_SUCCESS);
+}
+
+/*------------------------------------------------------------------------------
+ Function: initialiseFirmware()
+ *Use: This function performs the initialisation functions in order and starts
+ * the control slots, split from main() so the host simulation in tools/host
+ * can run the same start up and then step the interrupt and background loop
+------------------------------------------------------------------------------*/
+void initialiseFirmware(){
+    
     transToInitialising();
     setupInternalOscillator(CLOCK_FREQUENCY_SELECT);
     setupPWM();
-    setupTimer0Interrupt();  
     initialiseADCModule();
     initialiseCurrentSensors();
     initialisePotentiometers();
     initialiseController();
+    initialiseFaultManager();
+    initialiseTelemetry();
+    initialiseCommands();
+    initialiseScope();
+    initialiseShare();
+    initialiseModeSelect();
     
-    initialiseGPIO(gpioSlotTest, GPIO_Output);
-    initialiseGPIO(gpioSlotTest2, GPIO_Output);
+    if(SYNCHRONOUS_ENABLED == 0) GPIO_SET_OUTPUT(gpioSlotTest);
+    GPIO_SET_OUTPUT(gpioSlotTest2);
     
-    __delay_ms(100);
+    //fill the filters with real samples before the interrupt starts, so the first control period sees the true output
+    //rather than filters rising from 0 (replaces the previous fixed 100ms delay), approx 5ms in total
+    prefillVoutFilter();
+    prefillCurrentFilters();
+    prefillPotFilters();
+    initialiseInputVoltage();
+    initialiseObserver(voutFIFO[SIZE_OF_VSENSOR_FILTER-1], hotState.latestIL);
     
-    if(~readGPIO(gpioControlSelect)){                        //read pin which selects closed loop or open loop pot controlled
+    if(readClosedLoopSelect()){                              //read pin which selects closed loop or open loop pot controlled, later changes are handled by runModeSelect()
+        startSoftStart();                                    //ramp duty limit and reference up from the measured output
         if(CONTROL_METHOD == VOLTAGE_MODE_CONTROL)  transToVoltageModeControl();
         else if(CONTROL_METHOD == CURRENT_MODE_CONTROL)  transToCurrentModeControl(); //option here to hard code voltage mode or current mode 
+        else if(CONTROL_METHOD == CCCV_MODE_CONTROL)  transToVoltageModeControl();    //CC/CV starts in CV, controlRoutine() moves to CC at the current limit
     }
-    else transToPotControl();
-
-    while(1){           //infinite loop to hold uC in operation
-        
+    else{
+        startPotHandover();                                  //ramp the duty up from 0 to the pot setting
+        transToPotControl();
     }
-    return (EXIT_SUCCESS);
+    
+    setupTimer0Interrupt();                                  //start the control slots now the filters and state are ready
+}
+
+/*------------------------------------------------------------------------------
+ Function: runBackgroundTasks()
+ *Use: This function runs one pass of the background tasks, which are too slow
+ * for the interrupt, called continuously from main()
+------------------------------------------------------------------------------*/
+void runBackgroundTasks(){
+    runFaultLogging();
+    runTelemetry();
+    runCommands();
 }
 
 /*------------------------------------------------------------------------------
@@ -154,4 +229,8 @@ void setupInternalOscillator(const enum internalClockFreqSelec selectedFreq){
         case freq16M:  OSCCONbits.IRCF = 0b1111; OSCCONbits.SPLLEN = 0; clockFrequency = 16000000; break;
         case freq32M:  OSCCONbits.IRCF = 0b1110; OSCCONbits.SPLLEN = 1; clockFrequency = 32000000; break;
     }
+    
+    //wait until the oscillator is ready rather than relying on a fixed delay, the PLL takes up to 2ms to lock
+    if(OSCCONbits.SPLLEN) while(!OSCSTATbits.PLLR);
+    else if(clockFrequency > 500000) while(!OSCSTATbits.HFIOFR);
 }
\ No newline at end of file
@@ -0,0 +1,405 @@
+#!/usr/bin/env python3
+"""
+File:   benchmark.py
+
+Runs the firmware through a set of benchmark scenarios on the host simulation (tools/host),
+writes the results as JSON and checks them against a tolerance file, so a change which
+slows the loop or makes it overshoot fails the build:
+
+    python tools/benchmark.py [--tolerance tools/specs/benchmark_tolerance.ini]
+                              [--json results.json] [--set NAME=VALUE ...] [--scenario NAME ...]
+
+The scenarios are a soft start to TARGET_VOLTAGE_MV_1, a +50% and a -50% load step, the
+reference step to TARGET_VOLTAGE_MV_2 from the control select jumper, an input dip which holds
+the duty at MAX_DUTY to test the anti windup, a sweep of the duty pot in pot control, an output
+short with recovery in closed loop and in pot control, a forced trip comparator, the load steps
+again with the observer (Observer.h) built in, to check its estimates, and the conversion
+efficiency at the default and a light load with the freewheel diode and again with the
+synchronous rectifier (SYNCHRONOUS_ENABLED). Each runs the real firmware sources built with gcc
+against the averaged plant of tools/host/plant.c, with the power stage and sensors of
+tools/specs/default.ini.
+
+For each scenario the output (the plant, not the firmware's measurement) gives:
+    overshoot_mv            largest excursion past the final value after the event
+    settling_ms             time after the event until the output stays in the settle band
+    steady_state_error_mv   mean output over the tail less the reference
+    ripple_mv               peak to peak switching ripple over the tail
+    lf_ripple_mv            peak to peak of the tick sampled output over the tail
+    slotN_periph_cycles     largest peripheral access and wait time of the ticks running each
+                            slot, in instruction cycles (tools/host/hal.h). The ADC conversions
+                            and PWM update waits are counted, the computation between them is
+                            not, so this tracks changes to the peripheral use of a slot and is
+                            not the interrupt's execution time against the 16384 cycle tick
+and scenario specific values described with each scenario below.
+
+Every max_<name> and min_<name> in the scenario's section of the tolerance file is checked
+against the result <name>; the exit status is 1 if any check fails. --set overrides firmware
+defines for the build (see hostbuild.py), the tolerances are for the project as committed.
+"""
+
+import argparse
+import configparser
+import json
+import math
+import os
+import sys
+
+import hostbuild
+
+PROJECT_DIR = hostbuild.PROJECT_DIR
+DEFAULT_TOLERANCE = os.path.join(PROJECT_DIR, "tools", "specs", "benchmark_tolerance.ini")
+DEFAULT_JSON = os.path.join(hostbuild.BUILD_ROOT, "benchmark.json")
+
+STATE_POT = 1                   #enum stateMachine
+STATE_VOLTAGE_MODE = 2
+FAULT_STATES = (4, 5, 6, 7)
+SETTLE_S = 1.5                  #soft start and settling before a step
+INPUT_DIP_SCALE = 0.52         #12.5V at the default input, 90% duty gives approx 11.1V
+LIGHT_LOAD_SCALE = 0.2          #light load of the efficiency scenarios, below SYNC_EXIT_MA at the default load
+
+
+def at(rows, t):
+    """rows from time t on"""
+    return [row for row in rows if row["t_s"] >= t]
+
+
+def output_metrics(rows, event_s, band_pct, tail_s, direction=0):
+    """response of the output to an event at event_s, settled to the mean of the tail"""
+    after = at(rows, event_s)
+    tail = at(after, after[-1]["t_s"] - tail_s)
+    final = sum(row["plant_vout_mv"] for row in tail) / len(tail)
+    band = final * band_pct / 100.0
+    if direction > 0:
+        overshoot = max(row["plant_vout_mv"] - final for row in after)
+    elif direction < 0:
+        overshoot = max(final - row["plant_vout_mv"] for row in after)
+    else:
+        overshoot = max(abs(row["plant_vout_mv"] - final) for row in after)
+    settled = event_s
+    for row in after:
+        if abs(row["plant_vout_mv"] - final) > band:
+            settled = row["t_s"]
+    return {
+        "final_mv": round(final, 1),
+        "overshoot_mv": round(max(overshoot, 0.0), 1),
+        "settling_ms": round((settled - event_s) * 1000.0, 1),
+        "steady_state_error_mv": round(final - tail[-1]["ref_mv"], 1),
+        "ripple_mv": round(max(row["ripple_mv"] for row in tail), 1),
+        "lf_ripple_mv": round(max(row["plant_vout_mv"] for row in tail) - min(row["plant_vout_mv"] for row in tail), 1),
+    }
+
+
+def cycle_metrics(rows):
+    """largest peripheral access and wait time of the ticks running each slot"""
+    metrics = {}
+    for slot in (1, 3, 4):
+        cycles = [row["periph_cycles"] for row in rows if row["slot"] == slot]
+        metrics["slot%d_periph_cycles" % slot] = int(max(cycles)) if cycles else 0
+    return metrics
+
+
+def rms_error(rows, estimate, actual):
+    return math.sqrt(sum((row[estimate] - row[actual]) ** 2 for row in rows) / len(rows))
+
+
+def tracking_time(rows, event_s, estimate, actual, band):
+    """time after the event until the estimate first comes within band of the actual value, the lag of the estimate,
+    -1 if it never does"""
+    for row in at(rows, event_s):
+        if abs(row[estimate] - row[actual]) <= band:
+            return round((row["t_s"] - event_s) * 1000.0, 1)
+    return -1
+
+
+def observer(sim, settings):
+    """built with OBSERVER_ENABLED, so the loop runs on the observer, the load stepped +50% then -50%
+    vout_rms_error_mv, il_rms_error_ma, load_rms_error_ma: of the estimates from the plant output,
+    average inductor current and load current before the steps
+    step_vout_error_mv: largest error of the Vout estimate in the 0.1s after each step,
+    filtered_step_vout_error_mv the same for the moving average the loop uses without it
+    load_tracking_ms: longest time after a step until the load estimate first comes within
+    load_band_ma of the load, filtered_tracking_ms the same for the moving average of IL
+    settling_ms and the rest of the output results are for the step down"""
+    hold_s = 0.5
+    rows = hostbuild.run(sim, "run %g\nset load_ohm %g\nrun %g\nset load_ohm %g\nrun %g\n"
+                         % (SETTLE_S, settings["load_ohm"] / 1.5, hold_s, settings["load_ohm"] / 0.5, hold_s))
+    steady = [row for row in at(rows, SETTLE_S - hold_s) if row["t_s"] < SETTLE_S]
+    steps = (SETTLE_S, SETTLE_S + hold_s)
+    band = settings["load_band_ma"]
+    windows = [row for row in rows for step in steps if step <= row["t_s"] < step + 0.1]
+    metrics = output_metrics(rows, steps[1], settings["band_pct"], settings["tail_s"])
+    metrics.update({
+        "vout_rms_error_mv": round(rms_error(steady, "obs_vout_mv", "plant_vout_mv"), 1),
+        "il_rms_error_ma": round(rms_error(steady, "obs_il_ma", "plant_il_ma"), 1),
+        "load_rms_error_ma": round(rms_error(steady, "obs_load_ma", "load_ma"), 1),
+        "step_vout_error_mv": round(max(abs(row["obs_vout_mv"] - row["plant_vout_mv"]) for row in windows), 1),
+        "filtered_step_vout_error_mv": round(max(abs(row["vout_mv"] - row["plant_vout_mv"]) for row in windows), 1),
+        "load_tracking_ms": max(tracking_time([row for row in rows if row["t_s"] < step + hold_s], step,
+                                              "obs_load_ma", "load_ma", band) for step in steps),
+        "filtered_tracking_ms": max(tracking_time([row for row in rows if row["t_s"] < step + hold_s], step,
+                                                  "il_ma", "load_ma", band) for step in steps),
+    })
+    return rows, metrics
+
+
+def startup(sim, settings):
+    """power on into closed loop, the soft start and reference ramp to TARGET_VOLTAGE_MV_1"""
+    rows = hostbuild.run(sim, "run %g\n" % (SETTLE_S + 1.0))
+    return rows, output_metrics(rows, 0.0, settings["band_pct"], settings["tail_s"], direction=1)
+
+
+def load_step(scale):
+    """load current stepped by scale from the settled output at the default load"""
+    def scenario(sim, settings):
+        rows = hostbuild.run(sim, "run %g\nset load_ohm %g\nrun 1\n" % (SETTLE_S, settings["load_ohm"] / scale))
+        return rows, output_metrics(rows, SETTLE_S, settings["band_pct"], settings["tail_s"])
+    return scenario
+
+
+def reference_step(sim, settings):
+    """the control select jumper moved from TARGET_VOLTAGE_MV_1 to TARGET_VOLTAGE_MV_2"""
+    rows = hostbuild.run(sim, "run %g\npin control_select 1\nrun 1.5\n" % SETTLE_S)
+    return rows, output_metrics(rows, SETTLE_S, settings["band_pct"], settings["tail_s"], direction=1)
+
+
+def input_dip(sim, settings):
+    """the input ramped down over 1s from the settled output to INPUT_DIP_SCALE, below the input MAX_DUTY can
+    regulate from, held for 0.5s and ramped back up over 1s. The duty is held at the limit while the output
+    sags by approx 1V, short of the under voltage fault, so the overshoot on the way back up is the
+    integrator windup. The ramps are slow enough for the loop to follow, without Vin feed forward it
+    corrects approx 4 duty counts per control period
+    saturated_pct: time the duty was at the limit from the start of the ramp down to the ramp up
+    output results from the start of the ramp up"""
+    ramp_s, hold_s, steps = 1.0, 0.5, 20
+    low = settings["vin_mv"] * INPUT_DIP_SCALE
+    script = "run %g\n" % SETTLE_S
+    for i in range(1, steps + 1):
+        script += "set vin_mv %g\nrun %g\n" % (settings["vin_mv"] + (low - settings["vin_mv"]) * i / steps, ramp_s / steps)
+    script += "run %g\n" % hold_s
+    for i in range(1, steps + 1):
+        script += "set vin_mv %g\nrun %g\n" % (low + (settings["vin_mv"] - low) * i / steps, ramp_s / steps)
+    rows = hostbuild.run(sim, script + "run 1\n")
+    recovery_s = SETTLE_S + ramp_s + hold_s
+    dip = [row for row in at(rows, SETTLE_S) if row["t_s"] < recovery_s]
+    limit = max(row["duty"] for row in dip)
+    metrics = output_metrics(rows, recovery_s, settings["band_pct"], settings["tail_s"], direction=1)
+    metrics["saturated_pct"] = round(sum(1 for row in dip if row["duty"] == limit) / len(dip) * 100.0, 1)
+    return rows, metrics
+
+
+def pot_sweep(sim, settings):
+    """pot control, the duty pot stepped from 4.5V to 1.5V with the frequency pot central, the
+    rest of the range takes the output over OVP_MV at the default input
+    duty_span_pct: range of duty covered by the sweep, as a percentage of the period
+    monotonic: 1 if each step moved the duty the right way (clockwise, lower volts, more duty)
+    update_ms: longest time from a pot step to the duty reaching its new value, the pot filter
+    and POT_SET_DIVIDER
+    steady_state_error_mv: of the last step, from duty x Vin
+    vout_error_pct: largest error of the settled output from duty x Vin at each step"""
+    steps = [4.5 - 0.25 * i for i in range(13)]     #small steps, as a pot is turned, a large step trips on the inrush
+    hold_s = 0.75
+    script = "pin control_select 1\nset pot_duty_v %g\nrun %g\n" % (steps[0], hold_s)
+    for volts in steps[1:]:
+        script += "set pot_duty_v %g\nrun %g\n" % (volts, hold_s)
+    rows = hostbuild.run(sim, script)
+    duties, update, error = [], 0.0, 0.0
+    for index in range(len(steps)):
+        start = index * hold_s
+        window = [row for row in rows if start <= row["t_s"] < start + hold_s]
+        final = window[-1]
+        fraction = final["duty"] / (4.0 * (final["period"] + 1))
+        duties.append(fraction)
+        reached = [row["t_s"] for row in window if abs(row["duty"] - final["duty"]) <= 1]     #1 count of pot noise
+        if index > 0:
+            update = max(update, reached[0] - start)
+        expected = fraction * settings["vin_mv"]
+        if expected > 0:
+            error = max(error, abs(final["plant_vout_mv"] - expected) / expected * 100.0)
+    metrics = {
+        "duty_span_pct": round((max(duties) - min(duties)) * 100.0, 1),
+        "monotonic": int(all(b > a for a, b in zip(duties, duties[1:]))),
+        "update_ms": round(update * 1000.0, 1),
+        "vout_error_pct": round(error, 2),
+    }
+    metrics.update(output_metrics(rows, (len(steps) - 1) * hold_s, settings["band_pct"], settings["tail_s"]))
+    metrics["steady_state_error_mv"] = round(metrics["final_mv"] - expected, 1)     #from duty x Vin, there is no reference
+    return rows, metrics
+
+
+def short_circuit(sim, settings):
+    """an output short for 0.3s from the settled output, then the load restored
+    fault_ms: time from the short to a fault state
+    peak_il_ma: largest averaged inductor current
+    recovered: 1 if the output is back in voltage mode control at the end
+    settling_ms: from the short being removed"""
+    rows = hostbuild.run(sim, "run %g\nset load_ohm 0.2\nrun 0.3\nset load_ohm %g\nrun 2.5\n"
+                         % (SETTLE_S, settings["load_ohm"]))
+    after = at(rows, SETTLE_S)
+    faulted = [row["t_s"] for row in after if row["state"] in FAULT_STATES]
+    metrics = output_metrics(rows, SETTLE_S + 0.3, settings["band_pct"], settings["tail_s"], direction=1)
+    metrics.update({
+        "fault_ms": round((faulted[0] - SETTLE_S) * 1000.0, 1) if faulted else -1,
+        "peak_il_ma": round(max(row["plant_il_ma"] for row in after), 1),
+        "recovered": int(rows[-1]["state"] == STATE_VOLTAGE_MODE),
+    })
+    return rows, metrics
+
+
+def pot_restart(sim, settings):
+    """power on into pot control with the duty pot at 3V, then an output short for 0.3s and the load
+    restored, so pot control restarts after the fault
+    ramp_ms: time from power on until the duty first reaches its final value, the duty ramps from 0
+    peak_il_ma: largest averaged inductor current outside the short, on the power on and restart ramps
+    faults: number of times a fault state was entered, 1 for the short
+    recovered: 1 if the output is back in pot control at the end
+    settling_ms: from the short being removed, steady_state_error_mv from duty x Vin"""
+    rows = hostbuild.run(sim, "pin control_select 1\nset pot_duty_v 3\nrun %g\nset load_ohm 0.2\nrun 0.3\n"
+                         "set load_ohm %g\nrun 2.5\n" % (SETTLE_S, settings["load_ohm"]))
+    start = [row for row in rows if row["t_s"] < SETTLE_S]
+    reached = [row["t_s"] for row in start if row["duty"] >= start[-1]["duty"]]
+    states = [row["state"] for row in rows]
+    metrics = output_metrics(rows, SETTLE_S + 0.3, settings["band_pct"], settings["tail_s"], direction=1)
+    metrics.update({
+        "ramp_ms": round(reached[0] * 1000.0, 1),
+        "peak_il_ma": round(max(row["plant_il_ma"] for row in rows
+                                if not SETTLE_S <= row["t_s"] < SETTLE_S + 0.3), 1),
+        "faults": sum(1 for a, b in zip(states, states[1:]) if b in FAULT_STATES and a not in FAULT_STATES),
+        "recovered": int(rows[-1]["state"] == STATE_POT),
+    })
+    final = rows[-1]
+    expected = final["duty"] / (4.0 * (final["period"] + 1)) * settings["vin_mv"]
+    metrics["steady_state_error_mv"] = round(metrics["final_mv"] - expected, 1)     #from duty x Vin, there is no reference
+    return rows, metrics
+
+
+def efficiency(sim, settings):
+    """the settled output at the default load, then at LIGHT_LOAD_SCALE of it, with the diode drop and low
+    side resistance of the benchmark settings in the plant. The averaged plant has conduction losses only,
+    no switching or gate drive losses, so the results compare the rectifiers rather than predict the board
+    efficiency_pct, light_efficiency_pct: energy delivered to the load over the energy drawn from Vin
+    over the tail at each load
+    low_side_pct, light_low_side_pct: time the low side was switched over the tail at each load
+    the output results are for the light load step"""
+    rows = hostbuild.run(sim, "set diode_mv %g\nset low_side_mohm %g\nrun %g\nset load_ohm %g\nrun 1\n"
+                         % (settings["diode_mv"], settings["low_side_mohm"], SETTLE_S,
+                            settings["load_ohm"] / LIGHT_LOAD_SCALE))
+    metrics = output_metrics(rows, SETTLE_S, settings["band_pct"], settings["tail_s"])
+    tails = ([row for row in at(rows, SETTLE_S - settings["tail_s"]) if row["t_s"] < SETTLE_S],
+             at(rows, rows[-1]["t_s"] - settings["tail_s"]))
+    for prefix, tail in zip(("", "light_"), tails):
+        drawn = tail[-1]["input_mj"] - tail[0]["input_mj"]
+        metrics[prefix + "efficiency_pct"] = round((tail[-1]["output_mj"] - tail[0]["output_mj"]) / drawn * 100.0, 2)
+        metrics[prefix + "low_side_pct"] = round(sum(row["low_side"] for row in tail) / len(tail) * 100.0, 1)
+    return rows, metrics
+
+
+def forced_trip(sim, settings):
+    """both trip comparators latched once from the settled output, as noise on the trip line would
+    faulted: 1 if a single trip caused a fault state"""
+    rows = hostbuild.run(sim, "run %g\ntrip both\nrun 1\n" % SETTLE_S)
+    metrics = output_metrics(rows, SETTLE_S, settings["band_pct"], settings["tail_s"], direction=-1)
+    metrics["faulted"] = int(any(row["state"] in FAULT_STATES for row in at(rows, SETTLE_S)))
+    return rows, metrics
+
+
+#name, function and the firmware defines the scenario is built with, on top of any --set
+SCENARIOS = [
+    ("startup", startup, {}),
+    ("load_step_up", load_step(1.5), {}),
+    ("load_step_down", load_step(0.5), {}),
+    ("reference_step", reference_step, {}),
+    ("input_dip", input_dip, {}),
+    ("pot_sweep", pot_sweep, {}),
+    ("short_circuit", short_circuit, {}),
+    ("pot_restart", pot_restart, {}),
+    ("forced_trip", forced_trip, {}),
+    ("observer", observer, {"OBSERVER_ENABLED": "1"}),
+    ("efficiency_diode", efficiency, {}),
+    ("efficiency_synchronous", efficiency, {"SYNCHRONOUS_ENABLED": "1"}),
+]
+
+
+def check(results, tolerance):
+    """failures of the max_ and min_ limits, as strings"""
+    failures = []
+    for scenario, metrics in results.items():
+        if not tolerance.has_section(scenario):
+            continue
+        for key, limit in tolerance.items(scenario):
+            if key in tolerance.defaults():
+                continue
+            kind, _, name = key.partition("_")
+            if kind not in ("max", "min") or not name:
+                failures.append("%s: %s is not a max_ or min_ limit" % (scenario, key))
+                continue
+            if name not in metrics:
+                failures.append("%s: no result %s" % (scenario, name))
+                continue
+            value, limit = metrics[name], float(limit)
+            if (kind == "max" and value > limit) or (kind == "min" and value < limit):
+                failures.append("%s: %s = %g, %s %g" % (scenario, name, value, kind, limit))
+    return failures
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n\n")[1].strip())
+    parser.add_argument("--tolerance", default=DEFAULT_TOLERANCE, help="limits file, default %(default)s")
+    parser.add_argument("--json", default=DEFAULT_JSON, help="results file, - for stdout, default %(default)s")
+    parser.add_argument("--set", action="append", metavar="NAME=VALUE", help="override a firmware #define")
+    parser.add_argument("--scenario", action="append", choices=[name for name, _, _ in SCENARIOS],
+                        help="run only this scenario, may be repeated")
+    args = parser.parse_args()
+
+    tolerance = configparser.ConfigParser(inline_comment_prefixes=(";",))
+    if not tolerance.read(args.tolerance):
+        sys.exit("benchmark: cannot read %s" % args.tolerance)
+    general = tolerance["benchmark"] if tolerance.has_section("benchmark") else {}
+    settings = {
+        "band_pct": float(general.get("settle_band_pct", 1)),
+        "tail_s": float(general.get("tail_s", 0.25)),
+        "load_ohm": float(general.get("load_ohm", 12)),
+        "vin_mv": float(general.get("vin_mv", 24000)),
+        "load_band_ma": float(general.get("load_band_ma", 150)),
+        "diode_mv": float(general.get("diode_mv", 450)),
+        "low_side_mohm": float(general.get("low_side_mohm", 30)),
+    }
+
+    results = {}
+    sims = {}
+    for name, scenario, defines in SCENARIOS:
+        if args.scenario and name not in args.scenario:
+            continue
+        try:
+            overrides = dict(defines, **hostbuild.parse_overrides(args.set))
+            key = tuple(sorted(overrides.items()))
+            if key not in sims:
+                sims[key] = hostbuild.build(overrides)
+        except (ValueError, RuntimeError) as error:
+            sys.exit("benchmark: %s" % error)
+        rows, metrics = scenario(sims[key], settings)
+        metrics.update(cycle_metrics(rows))
+        results[name] = metrics
+
+    text = json.dumps(results, indent=2, sort_keys=True)
+    if args.json == "-":
+        print(text)
+    else:
+        os.makedirs(os.path.dirname(os.path.abspath(args.json)), exist_ok=True)
+        with open(args.json, "w") as f:
+            f.write(text + "\n")
+
+    for name, metrics in results.items():
+        print("%-22s overshoot %7.1fmV  settling %7.1fms  error %6.1fmV  ripple %5.1fmV  periph cycles %d/%d/%d" % (
+            name, metrics["overshoot_mv"], metrics["settling_ms"], metrics["steady_state_error_mv"],
+            metrics["ripple_mv"], metrics["slot1_periph_cycles"], metrics["slot3_periph_cycles"],
+            metrics["slot4_periph_cycles"]))
+    failures = check(results, tolerance)
+    for failure in failures:
+        print("FAIL " + failure)
+    if failures:
+        sys.exit(1)
+    print("benchmark: all limits met")
+
+
+if __name__ == "__main__":
+    main()
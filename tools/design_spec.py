@@ -0,0 +1,416 @@
+#!/usr/bin/env python3
+"""
+File:   design_spec.py
+
+Generates the controller, sensor, PWM period and observer constants from a converter design
+spec, and reports the predicted loop crossover, phase and gain margins, the observer poles
+and the quantisation limits of the chosen gains:
+
+    python tools/design_spec.py tools/specs/default.ini [DesignSpec.h]
+
+The spec file gives the input voltage range, L, C and ESR, the load range, the switching
+and clock frequencies, the sensor dividers and sensitivity, and the real PI gains (see
+tools/specs/default.ini). Each real value is quantised to the gain and exponent form the
+firmware uses. The header is written to the path given, or DesignSpec.h in the project
+directory, and is used in place of the hand set values when DESIGN_SPEC_ENABLED is set in
+Global.h. The report also lists where the hand set values in the module headers differ.
+
+The loop is analysed in discrete time at the control rate, as the controller sees it: the
+PI controller, the buck LC filter discretised with a zero order hold over the control
+period (which includes the one period delay before a new duty is measured), and the moving
+average on the Vout measurement. It is evaluated at the nominal input and both ends of the
+load range.
+
+The observer (Observer.h) is the LC filter with the inductor and capacitor resistances, a
+load current and a loss voltage as constant states, discretised over the observer period in
+two halves as the duty changes between them. Its gain is the steady state Kalman gain for
+the model and measurement noise given in the [observer] section of the spec.
+"""
+
+import cmath
+import configparser
+import math
+import os
+import re
+import sys
+
+PROJECT_DIR = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+#module headers holding the hand set values the generated constants replace
+HAND_SET_HEADERS = ["Controller.h", "CurrentSensor.h", "InputVoltage.h", "Observer.h", "Potentiometer.h"]
+
+SENSOR_EXPONENT = 8         #base exponent of the sensor conversions, the oversampling bits are added to it
+DT_EXPONENT = 16
+MIN_GAIN_MANTISSA = 128     #PI gains are given at least 8 significant bits
+OBSERVER_GAIN_EXPONENT = 12 #observer model and gain coefficients, signed 16 bit so each must be below 8
+
+
+def quantise(value, exponent):
+    gain = int(round(value * (1 << exponent)))
+    return gain, (gain / float(1 << exponent) - value) / value * 100.0
+
+
+def quantise_gain(value, max_exponent=15):
+    """smallest exponent giving at least MIN_GAIN_MANTISSA, so the error * gain product stays small"""
+    for exponent in range(max_exponent + 1):
+        if value * (1 << exponent) >= MIN_GAIN_MANTISSA:
+            break
+    gain, error = quantise(value, exponent)
+    return gain, exponent, error
+
+
+def matrix_multiply(a, b):
+    return [[sum(a[i][k] * b[k][j] for k in range(len(b))) for j in range(len(b[0]))] for i in range(len(a))]
+
+
+def matrix_add(a, b):
+    return [[x + y for x, y in zip(row_a, row_b)] for row_a, row_b in zip(a, b)]
+
+
+def matrix_transpose(a):
+    return [list(row) for row in zip(*a)]
+
+
+def matrix_inverse_2x2(m):
+    det = m[0][0] * m[1][1] - m[0][1] * m[1][0]
+    return [[m[1][1] / det, -m[0][1] / det], [-m[1][0] / det, m[0][0] / det]]
+
+
+def matrix_exponential(a):
+    """scaling and squaring with a Taylor series, ample for the small matrices here"""
+    n = len(a)
+    norm = max(sum(abs(x) for x in row) for row in a)
+    squarings = max(0, int(math.ceil(math.log(norm, 2))) + 1) if norm > 0 else 0
+    scaled = [[x / (1 << squarings) for x in row] for row in a]
+    result = [[float(i == j) for j in range(n)] for i in range(n)]
+    term = [row[:] for row in result]
+    for k in range(1, 20):
+        term = [[x / k for x in row] for row in matrix_multiply(term, scaled)]
+        result = [[result[i][j] + term[i][j] for j in range(n)] for i in range(n)]
+    for _ in range(squarings):
+        result = matrix_multiply(result, result)
+    return result
+
+
+def discretise_buck(inductance, capacitance, esr, load, period):
+    """zero order hold model of the LC filter from the switch node voltage to Vout, states are IL and Vc"""
+    k = 1.0 / (1.0 + esr / load)
+    a = [[-k * esr / inductance, -k / inductance],
+         [(1.0 - k * esr / load) / capacitance, -k / (load * capacitance)]]
+    b = [1.0 / inductance, 0.0]
+    c = [k * esr, k]
+    augmented = [[a[0][0] * period, a[0][1] * period, b[0] * period],
+                 [a[1][0] * period, a[1][1] * period, b[1] * period],
+                 [0.0, 0.0, 0.0]]
+    e = matrix_exponential(augmented)
+    ad = [[e[0][0], e[0][1]], [e[1][0], e[1][1]]]
+    bd = [e[0][2], e[1][2]]
+    return ad, bd, c
+
+
+def observer_model(spec, period):
+    """zero order hold model of the observer, states IL (mA), Vc (mV), load current (mA) and loss (mV), input the switch
+    node voltage (mV). The input changes half way through the period (the control slot runs between observer slots), so
+    the model is returned as ad, the input over the first half and the input over the second half"""
+    inductance, capacitance, esr, dcr = spec["inductance"], spec["capacitance"], spec["esr"], spec["dcr"]
+    a = [[-(dcr + esr) / inductance, -1.0 / inductance, esr / inductance, -1.0 / inductance],
+         [1.0 / capacitance, 0.0, -1.0 / capacitance, 0.0],
+         [0.0, 0.0, 0.0, 0.0],
+         [0.0, 0.0, 0.0, 0.0]]
+    b = [1.0 / inductance, 0.0, 0.0, 0.0]
+    half = period / 2.0
+    augmented = [[x * half for x in row] + [b[i] * half] for i, row in enumerate(a)] + [[0.0] * 5]
+    e = matrix_exponential(augmented)
+    phi = [row[:4] for row in e[:4]]
+    gamma = [[e[i][4]] for i in range(4)]
+    ad = matrix_multiply(phi, phi)
+    b_last = [x[0] for x in matrix_multiply(phi, gamma)]
+    b_new = [x[0] for x in gamma]
+    return ad, b_last, b_new
+
+
+def observer_gain(spec, ad):
+    """steady state Kalman gain for the measured output voltage and inductor current, found by iterating the Riccati
+    equation, and the poles of the estimate error (I - KC)Ad"""
+    c = [[spec["esr"], 1.0, -spec["esr"], 0.0], [1.0, 0.0, 0.0, 0.0]]
+    q = [[0.0] * 4 for _ in range(4)]
+    for i, key in enumerate(("model_il_ma", "model_vc_mv", "load_step_ma", "loss_drift_mv")):
+        q[i][i] = spec[key] ** 2
+    r = [[spec["vout_noise_mv"] ** 2, 0.0], [0.0, spec["il_noise_ma"] ** 2]]
+    identity = [[float(i == j) for j in range(4)] for i in range(4)]
+    p = [row[:] for row in q]
+    k = None
+    for _ in range(5000):
+        predicted = matrix_add(matrix_multiply(matrix_multiply(ad, p), matrix_transpose(ad)), q)
+        innovation = matrix_add(matrix_multiply(matrix_multiply(c, predicted), matrix_transpose(c)), r)
+        previous = k
+        k = matrix_multiply(matrix_multiply(predicted, matrix_transpose(c)), matrix_inverse_2x2(innovation))
+        p = matrix_multiply(matrix_add(identity, [[-x for x in row] for row in matrix_multiply(k, c)]), predicted)
+        if previous and max(abs(x - y) for row, old in zip(k, previous) for x, y in zip(row, old)) < 1e-9:
+            break
+    error = matrix_multiply(matrix_add(identity, [[-x for x in row] for row in matrix_multiply(k, c)]), ad)
+    return k, matrix_eigenvalues(error)
+
+
+def matrix_eigenvalues(a):
+    """roots of the characteristic polynomial, from the Faddeev-LeVerrier coefficients and Durand-Kerner iteration"""
+    n = len(a)
+    identity = [[float(i == j) for j in range(n)] for i in range(n)]
+    coefficients = [1.0]
+    m = [[0.0] * n for _ in range(n)]
+    for k in range(1, n + 1):
+        m = matrix_add(matrix_multiply(a, m), [[coefficients[-1] * x for x in row] for row in identity])
+        coefficients.append(-sum(matrix_multiply(a, m)[i][i] for i in range(n)) / k)
+    roots = [complex(0.4, 0.9) ** i for i in range(n)]
+    for _ in range(500):
+        for i in range(n):
+            value = sum(c * roots[i] ** (n - j) for j, c in enumerate(coefficients))
+            others = 1.0
+            for j in range(n):
+                if j != i:
+                    others *= roots[i] - roots[j]
+            roots[i] -= value / others if others != 0 else 0
+    return roots
+
+
+def plant_response(model, z):
+    ad, bd, c = model
+    m = [[z - ad[0][0], -ad[0][1]], [-ad[1][0], z - ad[1][1]]]
+    det = m[0][0] * m[1][1] - m[0][1] * m[1][0]
+    x0 = (m[1][1] * bd[0] - m[0][1] * bd[1]) / det
+    x1 = (-m[1][0] * bd[0] + m[0][0] * bd[1]) / det
+    return c[0] * x0 + c[1] * x1
+
+
+def loop_margins(spec, derived, load, vin_mv=None, measurement_gain=1.0):
+    """crossover frequency, phase margin and gain margin of the voltage loop at one load, at the nominal input unless
+    vin_mv is given. measurement_gain is the measured over the true Vout, from divider tolerances"""
+    period = derived["control_period_s"]
+    model = discretise_buck(spec["inductance"], spec["capacitance"], spec["esr"], load, period)
+    vin_mv = spec["vin_nominal_mv"] if vin_mv is None else vin_mv
+    plant_gain = vin_mv / derived["duty_full_scale"] * measurement_gain    #measured mV at the switch node per duty count
+    kp = derived["kp_real"]
+    ki_dt = derived["ki_real"] * derived["dt_real"]
+    n = spec["filter_length"]
+
+    crossover = phase_margin = gain_margin = None
+    previous_phase = None
+    unwrapped = 0.0
+    steps = 4000
+    for i in range(1, steps + 1):
+        w = math.pi / period * 10 ** (-3.0 + 3.0 * i / steps)          #1/1000 of Nyquist up to Nyquist
+        z = cmath.exp(1j * w * period)
+        controller = kp + ki_dt * z / (z - 1.0)
+        average = sum(z ** -k for k in range(n)) / n
+        loop = controller * plant_gain * plant_response(model, z) * average
+        phase = math.degrees(cmath.phase(loop))
+        if previous_phase is not None:
+            step = phase - previous_phase
+            step -= 360.0 * round(step / 360.0)
+            unwrapped += step
+        else:
+            unwrapped = phase
+        previous_phase = phase
+        if crossover is None and abs(loop) < 1.0:
+            crossover = w / (2 * math.pi)
+            phase_margin = 180.0 + unwrapped
+        if gain_margin is None and unwrapped <= -180.0:
+            gain_margin = -20.0 * math.log10(abs(loop))
+    return crossover, phase_margin, gain_margin
+
+
+def read_spec(path):
+    ini = configparser.ConfigParser(inline_comment_prefixes=(";",))
+    ini.read(path)
+    g = lambda section, key, fallback=None: ini.getfloat(section, key, fallback=fallback) if fallback is not None \
+        else ini.getfloat(section, key)
+    return {
+        "vin_min_mv": g("supply", "vin_min_v") * 1000, "vin_nominal_mv": g("supply", "vin_nominal_v") * 1000,
+        "vin_max_mv": g("supply", "vin_max_v") * 1000,
+        "inductance": g("power_stage", "inductance_uh") * 1e-6, "capacitance": g("power_stage", "capacitance_uf") * 1e-6,
+        "esr": g("power_stage", "esr_mohm") * 1e-3, "dcr": g("power_stage", "dcr_mohm", 0.0) * 1e-3,
+        "r_min": g("load", "r_min_ohm"), "r_max": g("load", "r_max_ohm"),
+        "clock_hz": g("switching", "clock_hz"), "switching_hz": g("switching", "switching_khz") * 1000,
+        "pot_min_hz": g("switching", "pot_min_khz") * 1000, "pot_max_hz": g("switching", "pot_max_khz") * 1000,
+        "timer0_prescaler": g("switching", "timer0_prescaler"),
+        "vref": g("sensors", "adc_vref_v"), "adc_counts": 2 ** ini.getint("sensors", "adc_bits"),
+        "vout_divider": (g("sensors", "vout_divider_top_kohm") + g("sensors", "vout_divider_bottom_kohm")) / g("sensors", "vout_divider_bottom_kohm"),
+        "vin_divider": (g("sensors", "vin_divider_top_kohm") + g("sensors", "vin_divider_bottom_kohm")) / g("sensors", "vin_divider_bottom_kohm"),
+        "current_sensitivity": g("sensors", "current_sensitivity_mv_per_a") / 1000.0,
+        "current_offset": g("sensors", "current_offset_v"),
+        "filter_length": ini.getint("sensors", "vout_filter_length"),
+        "target_mv": g("control", "target_mv"), "kp": g("control", "kp"), "ki": g("control", "ki"),
+        "vout_noise_mv": g("observer", "vout_noise_mv", 15.0), "il_noise_ma": g("observer", "il_noise_ma", 200.0),
+        "model_il_ma": g("observer", "model_il_ma", 50.0), "model_vc_mv": g("observer", "model_vc_mv", 10.0),
+        "load_step_ma": g("observer", "load_step_ma", 30.0), "loss_drift_mv": g("observer", "loss_drift_mv", 1.0),
+    }
+
+
+def derive(spec):
+    """the firmware constants, each as (value, comment), and the real values they give"""
+    c = {}
+    lsb_mv = spec["vref"] / spec["adc_counts"] * 1000.0
+
+    period = int(round(spec["clock_hz"] / (4 * spec["switching_hz"]))) - 1
+    c["VOLTAGE_MODE_CONTROL_PERIOD"] = ("%du" % period, "%.1fkHz" % (spec["clock_hz"] / (4 * (period + 1)) / 1000))
+    pot_min = int(math.floor(spec["clock_hz"] / (4 * spec["pot_max_hz"]))) - 1
+    pot_max = int(math.ceil(spec["clock_hz"] / (4 * spec["pot_min_hz"]))) - 1
+    c["MIN_PERIOD_FROM_POT"] = ("%du" % pot_min, "%.1fkHz" % (spec["clock_hz"] / (4 * (pot_min + 1)) / 1000))
+    c["MAX_PERIOD_FROM_POT"] = ("%du" % pot_max, "%.1fkHz" % (spec["clock_hz"] / (4 * (pot_max + 1)) / 1000))
+
+    tick_hz = spec["clock_hz"] / (4 * spec["timer0_prescaler"] * 256)
+    dt_real = 2.0 / tick_hz
+    dt_gain, dt_error = quantise(dt_real, DT_EXPONENT)
+    c["DT_GAIN"] = ("%du" % dt_gain, "%.6fs, control at %.2fHz, %+.2f%%" % (dt_real, 1 / dt_real, dt_error))
+    c["DT_EXPONENT"] = ("%du" % DT_EXPONENT, "")
+
+    kp_gain, kp_exponent, kp_error = quantise_gain(spec["kp"])
+    ki_gain, ki_exponent, ki_error = quantise_gain(spec["ki"])
+    c["VOLTAGE_MODE_KP"] = ("%du" % kp_gain, "%g duty counts per mV, %+.2f%%" % (spec["kp"], kp_error))
+    c["VOLTAGE_MODE_KP_EXPONENT"] = ("%du" % kp_exponent, "")
+    c["VOLTAGE_MODE_KI"] = ("%du" % ki_gain, "%g duty counts per mV second, %+.2f%%" % (spec["ki"], ki_error))
+    c["VOLTAGE_MODE_KI_EXPONENT"] = ("%du" % ki_exponent, "")
+
+    vout_gain, vout_error = quantise(lsb_mv * spec["vout_divider"], SENSOR_EXPONENT)
+    c["VOLTAGE_SENSOR_GAIN"] = ("%du" % vout_gain, "%.4fmV per 10 bit LSB, %+.3f%%" % (lsb_mv * spec["vout_divider"], vout_error))
+    c["VOLTAGE_SENSOR_EXPONENT"] = ("(%du + VSENSOR_OVERSAMPLE_EXPONENT)" % SENSOR_EXPONENT, "")
+    vin_gain, vin_error = quantise(lsb_mv * spec["vin_divider"], SENSOR_EXPONENT)
+    c["VIN_SENSOR_GAIN"] = ("%du" % vin_gain, "%.4fmV per 10 bit LSB, %+.3f%%" % (lsb_mv * spec["vin_divider"], vin_error))
+    c["VIN_SENSOR_EXPONENT"] = ("(%du + VIN_OVERSAMPLE_EXPONENT)" % SENSOR_EXPONENT, "")
+    c["VIN_NOMINAL_MV"] = ("%du" % spec["vin_nominal_mv"], "")
+
+    current_lsb = lsb_mv / spec["current_sensitivity"]
+    current_gain, current_error = quantise(current_lsb, SENSOR_EXPONENT)
+    offset = int(round(spec["current_offset"] / spec["vref"] * spec["adc_counts"]))
+    c["CURRENT_SENSOR_GAIN"] = ("%du" % current_gain, "%.4fmA per LSB, %+.3f%%" % (current_lsb, current_error))
+    c["CURRENT_SENSOR_EXPONENT"] = ("%du" % SENSOR_EXPONENT, "")
+    c["CURRENT_SENSOR_OFFSET"] = ("%du" % offset, "%.3fV" % spec["current_offset"])
+
+    observer_period = 2.0 / tick_hz                #slot 2, every other tick
+    ad, b_last, b_new = observer_model(spec, observer_period)
+    gain, poles = observer_gain(spec, ad)
+    q = lambda value: int(round(value * (1 << OBSERVER_GAIN_EXPONENT)))
+    coefficient = lambda value: ("%d" % q(value)) if q(value) >= 0 else "(%d)" % q(value)
+    for row, label in ((0, "IL"), (1, "VC")):
+        c["OBSERVER_A_%s_IL" % label] = (coefficient(ad[row][0]), "%.5f" % ad[row][0])
+        c["OBSERVER_A_%s_VC" % label] = (coefficient(ad[row][1]), "%.5f" % ad[row][1])
+        c["OBSERVER_A_%s_LOAD" % label] = (coefficient(ad[row][2]), "%.5f" % ad[row][2])
+        c["OBSERVER_B_%s_LAST" % label] = (coefficient(b_last[row]), "%.5f" % b_last[row])
+        c["OBSERVER_B_%s_NEW" % label] = (coefficient(b_new[row]), "%.5f" % b_new[row])
+    for row, label in enumerate(("IL", "VC", "LOAD", "LOSS")):
+        c["OBSERVER_K_%s_VOUT" % label] = (coefficient(gain[row][0]), "%.5f" % gain[row][0])
+        c["OBSERVER_K_%s_IL" % label] = (coefficient(gain[row][1]), "%.5f" % gain[row][1])
+    c["OBSERVER_ESR_GAIN"] = ("%du" % q(spec["esr"]), "%.0fmOhm" % (spec["esr"] * 1000))
+    c["OBSERVER_DCR_GAIN"] = ("%du" % q(spec["dcr"]), "%.0fmOhm" % (spec["dcr"] * 1000))
+    c["OBSERVER_GAIN_EXPONENT"] = ("%du" % OBSERVER_GAIN_EXPONENT, "")
+    largest = max([abs(x) for row in ad[:2] for x in row] + [abs(x) for row in gain for x in row] +
+                  [abs(x) for x in b_last + b_new])
+    if q(largest) > 32767:
+        raise ValueError("observer coefficient %.3f does not fit a signed 16 bit gain with exponent %d"
+                         % (largest, OBSERVER_GAIN_EXPONENT))
+
+    derived = {
+        "constants": c, "period": period, "duty_full_scale": 4.0 * (period + 1),
+        "control_period_s": dt_real, "dt_real": dt_gain / float(1 << DT_EXPONENT),
+        "kp_real": kp_gain / float(1 << kp_exponent), "ki_real": ki_gain / float(1 << ki_exponent),
+        "lsb_mv": lsb_mv, "current_lsb_ma": current_lsb,
+        "observer_period_s": observer_period, "observer_poles": poles,
+    }
+    return derived
+
+
+def quantisation_report(spec, derived):
+    out = []
+    vout_lsb = derived["lsb_mv"] * spec["vout_divider"]
+    out.append("  Vout LSB %.2fmV at 10 bits (divided by 2^n with oversampling), IL/IDS LSB %.1fmA"
+               % (vout_lsb, derived["current_lsb_ma"]))
+    for label, vin in (("min", spec["vin_min_mv"]), ("nominal", spec["vin_nominal_mv"]), ("max", spec["vin_max_mv"])):
+        duty_step = vin / derived["duty_full_scale"]
+        duty = spec["target_mv"] / vin * derived["duty_full_scale"]
+        note = "finer than the 10 bit Vout LSB" if duty_step < vout_lsb else \
+            "coarser than the 10 bit Vout LSB, expect a limit cycle of one duty count"
+        out.append("  Vin %-8s %5.1fV: duty %5.1f counts, one duty count moves Vout %.1fmV, %s"
+                   % (label, vin / 1000, duty, duty_step, note))
+    out.append("  smallest error moving the P term one duty count: %.1fmV" % (1.0 / derived["kp_real"]))
+    out.append("  error integrated to one duty count in one control period: %.1fmV"
+               % (1.0 / (derived["ki_real"] * derived["dt_real"])))
+    resonance = 1.0 / (2 * math.pi * math.sqrt(spec["inductance"] * spec["capacitance"]))
+    out.append("  LC resonance %.0fHz, control rate %.1fHz" % (resonance, 1.0 / derived["control_period_s"]))
+    ripple = (spec["vin_nominal_mv"] - spec["target_mv"]) * spec["target_mv"] / spec["vin_nominal_mv"] / \
+        (spec["inductance"] * (spec["clock_hz"] / derived["duty_full_scale"]))      #mV / (H * Hz) gives mA
+    out.append("  inductor ripple %.0fmA peak to peak at nominal Vin" % ripple)
+    return out
+
+
+def hand_set_values():
+    values = {}
+    for name in HAND_SET_HEADERS:
+        with open(os.path.join(PROJECT_DIR, name)) as f:
+            for match in re.finditer(r"^#define\s+(\w+)\s+(\([^)]*\)|\S+)", f.read(), re.M):
+                values.setdefault(match.group(1), (match.group(2), name))
+    return values
+
+
+def write_header(path, spec_path, constants):
+    lines = ["/* ",
+             " * File:   DesignSpec.h",
+             " * Author: tools/design_spec.py",
+             " *",
+             " * Generated from %s, do not edit, regenerate from the spec instead" % os.path.relpath(spec_path, PROJECT_DIR),
+             " */",
+             "",
+             "#ifndef DESIGNSPEC_H",
+             "#define\tDESIGNSPEC_H",
+             "",
+             "//used in place of the hand set values in the module headers when DESIGN_SPEC_ENABLED (Global.h)"]
+    for name, (value, comment) in constants.items():
+        line = "#define %-28s%s" % (name, value)
+        if comment:
+            line = "%-60s//%s" % (line, comment)
+        lines.append(line)
+    lines += ["", "#endif\t/* DESIGNSPEC_H */", ""]
+    with open(path, "w") as f:
+        f.write("\n".join(lines))
+
+
+def main():
+    if len(sys.argv) < 2:
+        print("usage: design_spec.py spec.ini [DesignSpec.h]")
+        return 1
+    spec_path = sys.argv[1]
+    header_path = sys.argv[2] if len(sys.argv) > 2 else os.path.join(PROJECT_DIR, "DesignSpec.h")
+    spec = read_spec(spec_path)
+    derived = derive(spec)
+    constants = derived["constants"]
+    write_header(header_path, spec_path, constants)
+
+    out = ["Design spec report for " + spec_path, "", "Constants written to " + header_path + ":"]
+    hand = hand_set_values()
+    for name, (value, comment) in constants.items():
+        current, header = hand.get(name, ("-", ""))
+        flag = "" if current == value else "   differs from %s in %s" % (current, header)
+        out.append("  %-28s %-36s%s" % (name, value, flag))
+
+    out += ["", "Voltage loop at Vin %.1fV, Vout %.1fV:" % (spec["vin_nominal_mv"] / 1000, spec["target_mv"] / 1000)]
+    for label, load in (("heaviest", spec["r_min"]), ("lightest", spec["r_max"])):
+        crossover, phase_margin, gain_margin = loop_margins(spec, derived, load)
+        if crossover is None:
+            out.append("  %-8s load %6.1f ohm: no crossover below Nyquist, gain too high" % (label, load))
+            continue
+        out.append("  %-8s load %6.1f ohm: crossover %.2fHz, phase margin %.1f deg, gain margin %s"
+                   % (label, load, crossover, phase_margin,
+                      "%.1fdB" % gain_margin if gain_margin is not None else "infinite"))
+
+    poles = sorted(derived["observer_poles"], key=abs, reverse=True)
+    slowest = -derived["observer_period_s"] / math.log(abs(poles[0])) if 0 < abs(poles[0]) < 1 else None
+    out += ["", "Observer at %.2fHz:" % (1.0 / derived["observer_period_s"]),
+            "  error poles " + ", ".join("%.3f%+.3fj" % (p.real, p.imag) for p in poles),
+            "  slowest estimate error time constant %s" % ("%.1fms" % (slowest * 1000) if slowest else "unstable")]
+
+    out += ["", "Quantisation:"] + quantisation_report(spec, derived)
+    print("\n".join(out))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,94 @@
+/*
+ * File:   firmware.c
+ * Author: agent
+ *
+ * Created on 19 October 2026, 13:10
+ */
+
+//the firmware sources built as one unit for the host, as the module headers define their variables. The include
+//path is the source directory, the project root or a copy with its switches overridden by tools/hostbuild.py, and
+//main() is renamed firmwareMain by the Makefile so the simulation supplies its own
+
+#include "main.c"
+#include "ADC.c"
+#include "Benchmark.c"
+#include "Command.c"
+#include "Controller.c"
+#include "CurrentSensor.c"
+#include "Energy.c"
+#include "FaultManager.c"
+#include "FixedPoint.c"
+#include "InputVoltage.c"
+#include "Observer.c"
+#include "PWM.c"
+#include "Potentiometer.c"
+#include "Protection.c"
+#include "Reference.c"
+#include "Scope.c"
+#include "Share.c"
+#include "StateMachine.c"
+#include "Telemetry.c"
+#include "Timer0.c"
+
+#include "firmware.h"
+
+static uint8_t lastSlot;
+
+/*------------------------------------------------------------------------------
+ Function: firmwareInitialise()
+ *Use: This function runs the firmware start up, up to starting Timer0
+------------------------------------------------------------------------------*/
+void firmwareInitialise(void){
+    initialiseFirmware();
+}
+
+/*------------------------------------------------------------------------------
+ Function: firmwareTick()
+ *Use: This function runs the interrupt for a Timer0 overflow
+------------------------------------------------------------------------------*/
+void firmwareTick(void){
+    if(!timerSlotHalf) lastSlot = 1;
+    else lastSlot = timerSlotQuarter ? 4 : 3;
+    Tick490Hz();
+}
+
+/*------------------------------------------------------------------------------
+ Function: firmwareBackground()
+ *Use: This function runs one pass of the main loop
+------------------------------------------------------------------------------*/
+void firmwareBackground(void){
+    runBackgroundTasks();
+}
+
+/*------------------------------------------------------------------------------
+ Function: firmwareReadState(state)
+ *Use: This function copies out the state reported for each tick
+------------------------------------------------------------------------------*/
+void firmwareReadState(struct firmwareState *state){
+    state->state = (uint8_t) currentState;
+    state->duty = hotState.setDuty;
+    state->period = hotState.setPeriod;
+    state->referenceMilliVolts = referenceMilliVolts;
+    state->voutMilliVolts = convertRawToMilliVolts(hotState.filteredVout);
+    state->ilMilliAmps = convertRawToMilliAmps(hotState.filteredIL);
+    state->currentTripCount = hotState.currentTripCount;
+    state->faultRetryCount = faultRetryCount;
+    state->faultLatched = faultLatched;
+    state->slot = lastSlot;
+#if OBSERVER_ENABLED == 1
+    state->observerVout = observer.vout;
+    state->observerIL = observer.inductorCurrent;
+    state->observerLoad = observer.loadCurrent;
+#else
+    state->observerVout = 0;
+    state->observerIL = 0;
+    state->observerLoad = 0;
+#endif
+#if SHARE_ENABLED == 1
+    state->shareTrim = shareTrim;
+    state->shareCollisions = shareCollisionCount;
+#else
+    state->shareTrim = 0;
+    state->shareCollisions = 0;
+#endif
+}
@@ -0,0 +1,47 @@
+/*
+ * File:   firmware.h
+ * Author: agent
+ *
+ * Created on 19 October 2026, 13:10
+ */
+
+//entry points into the firmware built for the host (firmware.c), and the state the simulation reports each tick
+
+#ifndef FIRMWARE_H
+#define	FIRMWARE_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+
+struct firmwareState{
+    uint8_t state;                          //enum stateMachine
+    uint16_t duty;                          //hotState.setDuty and setPeriod
+    uint8_t period;
+    uint16_t referenceMilliVolts;
+    int16_t voutMilliVolts;                 //filtered measurements as the controller sees them
+    int16_t ilMilliAmps;
+    uint8_t currentTripCount;
+    uint8_t faultRetryCount;
+    bool faultLatched;
+    uint8_t slot;                           //slot run by the last tick, 1, 3 (slot 2 with 3) or 4 (slot 2 with 4)
+    int16_t observerVout;                   //observer estimates (Observer.h), 0 with OBSERVER_ENABLED 0
+    int16_t observerIL;
+    int16_t observerLoad;
+    int16_t shareTrim;                      //current sharing (Share.h), 0 with SHARE_ENABLED 0
+    uint16_t shareCollisions;
+};
+
+void firmwareInitialise(void);
+void firmwareTick(void);
+void firmwareBackground(void);
+void firmwareReadState(struct firmwareState *state);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* FIRMWARE_H */
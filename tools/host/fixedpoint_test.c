@@ -0,0 +1,233 @@
+/*
+ * File:   fixedpoint_test.c
+ * Author: agent
+ *
+ * Created on 19 October 2026, 16:05
+ */
+
+//property tests of the FixedPoint.c helpers, built on their own with gcc (make check). Each helper is run on random
+//inputs, weighted towards the ends of the range where saturation happens, and on the range limits themselves, and
+//compared with the same operation done in 64 bit arithmetic then saturated. The firmware's shifts round towards minus
+//infinity, so the reference divides with floor rounding rather than shifting. On the host int is 32 bits, so these
+//check the arithmetic and saturation, not the 16 bit int promotions of the target compiler
+//
+//  fixedpoint_test [cases] [seed]      default 1000000 cases of each helper, seed 1
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "FixedPoint.h"
+
+#define DEFAULT_CASES       1000000ul
+#define MAX_REPORTED        10u         //failures printed per helper, the rest are only counted
+#define MAX_EXPONENT        24u         //largest exponent tested, the firmware uses up to 20
+
+static uint64_t randomState;
+static unsigned long failures;
+static unsigned long reported;
+
+static const int32_t edges[] = {FIXED_INT16_MIN, FIXED_INT16_MIN + 1, -1, 0, 1, FIXED_INT16_MAX - 1, FIXED_INT16_MAX};
+
+/*------------------------------------------------------------------------------
+ Function: nextRandom()
+ *Use: This function returns the next 64 bit value of a xorshift generator
+------------------------------------------------------------------------------*/
+static uint64_t nextRandom(void){
+    randomState ^= randomState << 13;
+    randomState ^= randomState >> 7;
+    randomState ^= randomState << 17;
+    return randomState;
+}
+
+/*------------------------------------------------------------------------------
+ Function: randomInt16()
+ *Use: This function returns a random int16, a quarter of the time one of the
+ * range limits or a value near zero, otherwise uniform over the range
+------------------------------------------------------------------------------*/
+static int16_t randomInt16(void){
+    uint64_t r = nextRandom();
+    if((r & 3u) == 0) return (int16_t) edges[(r >> 2) % (sizeof(edges) / sizeof(edges[0]))];
+    return (int16_t) (uint16_t) (r >> 16);
+}
+
+/*------------------------------------------------------------------------------
+ Function: randomInt32()
+ *Use: This function returns a random int32 for saturateToInt16, spread over
+ * magnitudes so values in, near and far outside the int16 range all occur
+------------------------------------------------------------------------------*/
+static int32_t randomInt32(void){
+    uint64_t r = nextRandom();
+    uint8_t bits = (uint8_t) (r % 33u);
+    int64_t magnitude = (int64_t) ((r >> 8) & ((bits == 32u) ? 0x7FFFFFFFull : ((1ull << bits) - 1u)));
+    if(r & (1ull << 63)) magnitude = -magnitude - ((bits == 32u) ? 1 : 0);
+    return (int32_t) magnitude;
+}
+
+/*------------------------------------------------------------------------------
+ Function: saturateReference(value, minimum, maximum)
+ *Use: This function limits a 64 bit value to between minimum and maximum
+------------------------------------------------------------------------------*/
+static int64_t saturateReference(int64_t value, int64_t minimum, int64_t maximum){
+    if(value > maximum) return maximum;
+    if(value < minimum) return minimum;
+    return value;
+}
+
+/*------------------------------------------------------------------------------
+ Function: floorShift(value, exponent)
+ *Use: This function returns value / 2^exponent rounded towards minus infinity
+------------------------------------------------------------------------------*/
+static int64_t floorShift(int64_t value, uint8_t exponent){
+    int64_t divisor = (int64_t) 1 << exponent;
+    int64_t quotient = value / divisor;
+    if(((value % divisor) != 0) && (value < 0)) quotient--;
+    return quotient;
+}
+
+/*------------------------------------------------------------------------------
+ Function: check(name, passed, actual, expected, inputs)
+ *Use: This function counts a failure and prints the first few
+------------------------------------------------------------------------------*/
+static void check(const char *name, int passed, int64_t actual, int64_t expected, const char *inputs){
+    if(passed) return;
+    failures++;
+    if(reported++ < MAX_REPORTED) printf("FAIL %s(%s) = %lld, expected %lld\n", name, inputs, (long long) actual, (long long) expected);
+}
+
+/*------------------------------------------------------------------------------
+ Function: testSaturateToInt16(value)
+ *Use: This function checks saturateToInt16 against the 64 bit limit
+------------------------------------------------------------------------------*/
+static void testSaturateToInt16(int32_t value){
+    char inputs[64];
+    int64_t expected = saturateReference(value, FIXED_INT16_MIN, FIXED_INT16_MAX);
+    int16_t actual = saturateToInt16(value);
+    snprintf(inputs, sizeof(inputs), "%ld", (long) value);
+    check("saturateToInt16", actual == expected, actual, expected, inputs);
+}
+
+/*------------------------------------------------------------------------------
+ Function: testAddSubSaturated(a, b)
+ *Use: This function checks addSaturated and subSaturated against the 64 bit
+ * sum and difference, saturated
+------------------------------------------------------------------------------*/
+static void testAddSubSaturated(int16_t a, int16_t b){
+    char inputs[64];
+    snprintf(inputs, sizeof(inputs), "%d, %d", a, b);
+    int64_t expected = saturateReference((int64_t) a + b, FIXED_INT16_MIN, FIXED_INT16_MAX);
+    int16_t actual = addSaturated(a, b);
+    check("addSaturated", actual == expected, actual, expected, inputs);
+    //commutative, and the same as subtracting the negation where that is representable
+    check("addSaturated commutes", addSaturated(b, a) == actual, addSaturated(b, a), actual, inputs);
+    expected = saturateReference((int64_t) a - b, FIXED_INT16_MIN, FIXED_INT16_MAX);
+    actual = subSaturated(a, b);
+    check("subSaturated", actual == expected, actual, expected, inputs);
+    if(b != FIXED_INT16_MIN) check("subSaturated as add", addSaturated(a, (int16_t) -b) == actual, addSaturated(a, (int16_t) -b), actual, inputs);
+}
+
+/*------------------------------------------------------------------------------
+ Function: testClampInt16(value, minimum, maximum)
+ *Use: This function checks clampInt16, with the limits ordered
+------------------------------------------------------------------------------*/
+static void testClampInt16(int16_t value, int16_t minimum, int16_t maximum){
+    char inputs[64];
+    if(minimum > maximum){
+        int16_t swap = minimum;
+        minimum = maximum;
+        maximum = swap;
+    }
+    snprintf(inputs, sizeof(inputs), "%d, %d, %d", value, minimum, maximum);
+    int64_t expected = saturateReference(value, minimum, maximum);
+    int16_t actual = clampInt16(value, minimum, maximum);
+    check("clampInt16", actual == expected, actual, expected, inputs);
+    //idempotent, and a value already in range is unchanged
+    check("clampInt16 twice", clampInt16(actual, minimum, maximum) == actual, clampInt16(actual, minimum, maximum), actual, inputs);
+}
+
+/*------------------------------------------------------------------------------
+ Function: testMulShiftSigned(value, gain, exponent)
+ *Use: This function checks mulShiftSigned against the 64 bit product divided
+ * by 2^exponent rounding down, saturated
+------------------------------------------------------------------------------*/
+static void testMulShiftSigned(int16_t value, uint16_t gain, uint8_t exponent){
+    char inputs[64];
+    snprintf(inputs, sizeof(inputs), "%d, %u, %u", value, gain, exponent);
+    int64_t expected = saturateReference(floorShift((int64_t) value * gain, exponent), FIXED_INT16_MIN, FIXED_INT16_MAX);
+    int16_t actual = mulShiftSigned(value, gain, exponent);
+    check("mulShiftSigned", actual == expected, actual, expected, inputs);
+    //a larger gain never moves the result towards zero
+    if(gain < 0xFFFFu){
+        int16_t larger = mulShiftSigned(value, (uint16_t) (gain + 1u), exponent);
+        check("mulShiftSigned monotonic", (value >= 0) ? (larger >= actual) : (larger <= actual), larger, actual, inputs);
+    }
+}
+
+/*------------------------------------------------------------------------------
+ Function: testMulShiftUnsigned(value, gain, exponent)
+ *Use: This function checks mulShiftUnsigned against the 64 bit product
+ * shifted, saturated to the uint16 range
+------------------------------------------------------------------------------*/
+static void testMulShiftUnsigned(uint16_t value, uint16_t gain, uint8_t exponent){
+    char inputs[64];
+    snprintf(inputs, sizeof(inputs), "%u, %u, %u", value, gain, exponent);
+    int64_t expected = saturateReference(((int64_t) value * gain) >> exponent, 0, 0xFFFF);
+    uint16_t actual = mulShiftUnsigned(value, gain, exponent);
+    check("mulShiftUnsigned", actual == expected, actual, expected, inputs);
+    //the unsigned result is the signed one wherever both are in range
+    if((value <= FIXED_INT16_MAX) && (expected <= FIXED_INT16_MAX)){
+        int16_t signedResult = mulShiftSigned((int16_t) value, gain, exponent);
+        check("mulShiftUnsigned as signed", signedResult == actual, signedResult, actual, inputs);
+    }
+}
+
+/*------------------------------------------------------------------------------
+ Function: finish(name, before)
+ *Use: This function reports the failures of one helper's tests, those since
+ * before, and resets the count of printed failures for the next helper
+------------------------------------------------------------------------------*/
+static unsigned long finish(const char *name, unsigned long before){
+    unsigned long failed = failures - before;
+    if(failed > 0) printf("%s: %lu failures\n", name, failed);
+    reported = 0;
+    return failures;
+}
+
+int main(int argc, char **argv){
+    unsigned long cases = (argc > 1) ? strtoul(argv[1], NULL, 0) : DEFAULT_CASES;
+    uint64_t seed = (argc > 2) ? strtoull(argv[2], NULL, 0) : 1u;
+    randomState = seed ? seed : 1u;
+    unsigned long before = 0;
+
+    //the range limits exhaustively against each other, then random inputs
+    const size_t edgeCount = sizeof(edges) / sizeof(edges[0]);
+    for(size_t i = 0; i < edgeCount; i++){
+        testSaturateToInt16(edges[i]);
+        testSaturateToInt16(edges[i] * 2);
+        for(size_t j = 0; j < edgeCount; j++){
+            testAddSubSaturated((int16_t) edges[i], (int16_t) edges[j]);
+            for(size_t k = 0; k < edgeCount; k++) testClampInt16((int16_t) edges[i], (int16_t) edges[j], (int16_t) edges[k]);
+        }
+        for(uint8_t exponent = 0; exponent <= MAX_EXPONENT; exponent++){
+            testMulShiftSigned((int16_t) edges[i], 0xFFFFu, exponent);
+            testMulShiftSigned((int16_t) edges[i], 1u, exponent);
+            testMulShiftUnsigned((uint16_t) edges[i], 0xFFFFu, exponent);
+        }
+    }
+
+    for(unsigned long n = 0; n < cases; n++) testSaturateToInt16(randomInt32());
+    before = finish("saturateToInt16", before);
+    for(unsigned long n = 0; n < cases; n++) testAddSubSaturated(randomInt16(), randomInt16());
+    before = finish("addSaturated/subSaturated", before);
+    for(unsigned long n = 0; n < cases; n++) testClampInt16(randomInt16(), randomInt16(), randomInt16());
+    before = finish("clampInt16", before);
+    for(unsigned long n = 0; n < cases; n++) testMulShiftSigned(randomInt16(), (uint16_t) randomInt16(), (uint8_t) (nextRandom() % (MAX_EXPONENT + 1u)));
+    before = finish("mulShiftSigned", before);
+    for(unsigned long n = 0; n < cases; n++) testMulShiftUnsigned((uint16_t) randomInt16(), (uint16_t) randomInt16(), (uint8_t) (nextRandom() % (MAX_EXPONENT + 1u)));
+    before = finish("mulShiftUnsigned", before);
+
+    if(failures > 0){
+        printf("fixedpoint_test: %lu failures, seed %llu\n", failures, (unsigned long long) seed);
+        return 1;
+    }
+    printf("fixedpoint_test: %lu random cases of each helper passed, seed %llu\n", cases, (unsigned long long) seed);
+    return 0;
+}
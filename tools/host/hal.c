@@ -0,0 +1,409 @@
+/*
+ * File:   hal.c
+ * Author: agent
+ *
+ * Created on 19 October 2026, 12:55
+ */
+
+#include <string.h>
+#include "xc.h"
+#include "hal.h"
+#include "plant.h"
+
+uint64_t hostCycle;
+uint64_t hostTickCycle;
+uint64_t hostNextTick;
+void (*hostInterruptHandler)(void);
+int16_t hostAnalogOverride[HOST_ANALOG_CHANNELS];
+bool hostControlSelect;
+bool hostModeSelect;
+
+//storage only registers
+volatile TRISA_t hostTRISA;
+volatile TRISB_t hostTRISB;
+volatile ANSELA_t hostANSELA;
+volatile ANSELB_t hostANSELB;
+volatile ADCON1_t hostADCON1;
+volatile CCP1CON_t hostCCP1CON;
+volatile CCP2CON_t hostCCP2CON;
+volatile INTCON_t hostINTCON;
+volatile PIE1_t hostPIE1;
+volatile T2CON_t hostT2CON;
+volatile T4CON_t hostT4CON;
+volatile OSCCON_t hostOSCCON;
+volatile OSCSTAT_t hostOSCSTAT;
+volatile OPTION_REG_t hostOPTION_REG;
+volatile APFCON0_t hostAPFCON0;
+volatile APFCON1_t hostAPFCON1;
+volatile PSTR1CON_t hostPSTR1CON;
+volatile PWM1CON_t hostPWM1CON;
+volatile CCPTMRS_t hostCCPTMRS;
+volatile TXSTA_t hostTXSTA;
+volatile BAUDCON_t hostBAUDCON;
+volatile uint8_t ADRESH, ADRESL, PR2, PR4, CCPR1L, CCPR2L, SPBRGL, SPBRGH, TMR4;
+
+//registers behind the accessors
+static volatile PORTA_t portA;
+static volatile PORTB_t portB;
+static volatile LATA_t latA;
+static volatile LATB_t latB;
+static volatile ADCON0_t adcon0;
+static volatile PIR1_t pir1;
+static volatile RCSTA_t rcsta;
+static volatile BYTE_t txReg;
+static volatile BYTE_t rcReg;
+static volatile BYTE_t tmr0;
+static volatile BYTE_t tmr2;
+
+//peripheral state
+static uint64_t plantCycle;                 //time the plant has been stepped to, a multiple of PLANT_STEP_CYCLES
+static uint64_t timer2Match;                //time of the next Timer2 period match
+static uint64_t timer2Start;                //time of the last match, TMR2 counts from here
+static uint16_t latchedDuty;                //duty and period loaded into the PWM at the last match
+static uint32_t latchedPeriod;
+static uint64_t adcEnd;                     //end of the conversion in progress, 0 for none
+static uint16_t adcResult;
+static bool txPending;                      //TXREG was written, taken at the next access
+static uint64_t txRegFree;                  //time TXREG empties into the shift register
+static uint64_t txShiftFree;                //time the shift register finishes the byte in it
+static struct hostSerialByte txQueue[HOST_SERIAL_QUEUE_SIZE];
+static uint16_t txCount;
+static struct hostSerialByte rxQueue[HOST_SERIAL_QUEUE_SIZE];
+static uint16_t rxHead, rxTail;
+static uint8_t rxFifo[HOST_RX_FIFO_SIZE];
+static uint8_t rxFifoCount;
+static uint8_t eeprom[256];
+static uint64_t eepromFree;
+static bool inInterrupt;
+
+/*------------------------------------------------------------------------------
+ Function: hostReset()
+ *Use: This function returns the registers, peripherals and time to their
+ * power on state. The plant keeps its parameters and starts discharged
+------------------------------------------------------------------------------*/
+void hostReset(void){
+    hostCycle = 0;
+    hostTickCycle = 0;
+    hostNextTick = HOST_TICK_CYCLES;
+    inInterrupt = 0;
+    for(uint8_t i = 0; i < HOST_ANALOG_CHANNELS; i++) hostAnalogOverride[i] = -1;
+    hostControlSelect = 0;
+    hostModeSelect = 0;
+    hostTRISA.reg = 0xFF;
+    hostTRISB.reg = 0xFF;
+    hostANSELA.reg = 0x1F;
+    hostANSELB.reg = 0xFE;
+    hostINTCON.reg = 0;
+    hostOSCSTAT.reg = 0;
+    hostOSCSTAT.PLLR = 1;                   //the oscillator is ready at once, there is no lock time to wait for
+    hostOSCSTAT.HFIOFR = 1;
+    latA.reg = 0;
+    latB.reg = 0;
+    adcon0.reg = 0;
+    pir1.reg = 0;
+    rcsta.reg = 0;
+    PR2 = 0;
+    CCPR1L = 0;
+    hostCCP1CON.reg = 0;
+    plantCycle = 0;
+    timer2Match = 1;
+    timer2Start = 0;
+    latchedDuty = 0;
+    latchedPeriod = 1;
+    adcEnd = 0;
+    txPending = 0;
+    txRegFree = 0;
+    txShiftFree = 0;
+    txCount = 0;
+    rxHead = 0;
+    rxTail = 0;
+    rxFifoCount = 0;
+    memset(eeprom, 0xFF, sizeof(eeprom));
+    eepromFree = 0;
+    memset(&plant, 0, sizeof(plant));
+    plantUpdate();
+}
+
+/*------------------------------------------------------------------------------
+ Function: hostPWMDuty()
+ *Use: This function returns the duty fraction loaded into the PWM
+------------------------------------------------------------------------------*/
+double hostPWMDuty(void){
+    double duty = (double) latchedDuty / (4.0 * latchedPeriod);
+    return duty > 1.0 ? 1.0 : duty;
+}
+
+/*------------------------------------------------------------------------------
+ Function: hostPWMHalfBridge()
+ *Use: This function returns true while the ECCP is in half bridge mode, the
+ * low side switched with the dead band of PWM1CON
+------------------------------------------------------------------------------*/
+bool hostPWMHalfBridge(void){
+    return hostCCP1CON.P1M == 0b10;
+}
+
+/*------------------------------------------------------------------------------
+ Function: hostPWMPeriodCycles()
+ *Use: This function returns the PWM period loaded at the last match
+------------------------------------------------------------------------------*/
+uint32_t hostPWMPeriodCycles(void){
+    return latchedPeriod;
+}
+
+/*------------------------------------------------------------------------------
+ Function: hostSerialByteCycles()
+ *Use: This function returns the length of a start, 8 data and stop bit frame
+ * with BRG16 and BRGH set, where each bit is SPBRG + 1 instruction cycles
+------------------------------------------------------------------------------*/
+uint32_t hostSerialByteCycles(void){
+    return 10u * ((((uint32_t) SPBRGH << 8) | SPBRGL) + 1u);
+}
+
+/*------------------------------------------------------------------------------
+ Function: stepPlant(cycle)
+ *Use: This function steps the plant up to cycle with the PWM as loaded
+------------------------------------------------------------------------------*/
+static void stepPlant(uint64_t cycle){
+    if(cycle < plantCycle + PLANT_STEP_CYCLES) return;
+    uint64_t steps = (cycle - plantCycle) / PLANT_STEP_CYCLES;
+    plantAdvance((uint32_t) steps, hostPWMDuty(), latchedPeriod, hostPWMHalfBridge(), hostPWM1CON.P1DC);
+    plantCycle += steps * PLANT_STEP_CYCLES;
+}
+
+/*------------------------------------------------------------------------------
+ Function: hostSync()
+ *Use: This function brings the plant and peripherals up to the present time,
+ * called on every register access and time advance
+------------------------------------------------------------------------------*/
+void hostSync(void){
+    //Timer2 period matches load the new duty and period, PR2 + 1 instruction cycles each
+    if(timer2Match <= hostCycle){
+        stepPlant(timer2Match);
+        uint32_t period = (uint32_t) PR2 + 1u;
+        timer2Start = timer2Match + ((hostCycle - timer2Match) / period) * period;
+        timer2Match = timer2Start + period;
+        pir1.TMR2IF = 1;
+        latchedDuty = (uint16_t) (((uint16_t) CCPR1L << 2) | hostCCP1CON.DC1B);
+        latchedPeriod = period;
+    }
+    stepPlant(hostCycle);
+
+    //the over current clear output on RB3 holds the trip latches reset while low
+    if(!latB.LATB3 && !hostTRISB.TRISB3) plantClearTrips();
+
+    //ADC, a conversion samples the input when GO is seen and completes HOST_ADC_CYCLES later
+    if(adcon0.GO_nDONE && adcon0.ADON){
+        if(adcEnd == 0){
+            uint8_t channel = adcon0.CHS;
+            if((channel < HOST_ANALOG_CHANNELS) && (hostAnalogOverride[channel] >= 0)) adcResult = (uint16_t) hostAnalogOverride[channel];
+            else adcResult = plantConvert(plantSensorVolts(channel, hostPWMDuty(), latchedPeriod, (uint32_t) (hostCycle - timer2Start)));
+            adcEnd = hostCycle + HOST_ADC_CYCLES;
+        }
+        else if(hostCycle >= adcEnd){
+            ADRESH = (uint8_t) (adcResult >> 8);
+            ADRESL = (uint8_t) adcResult;
+            adcon0.GO_nDONE = 0;
+            adcEnd = 0;
+        }
+    }
+
+    //EUSART transmit, a byte written to TXREG moves to the shift register once it is free
+    if(txPending){
+        txPending = 0;
+        uint64_t start = (hostCycle > txShiftFree) ? hostCycle : txShiftFree;
+        txRegFree = start;
+        txShiftFree = start + hostSerialByteCycles();
+        if(txCount < HOST_SERIAL_QUEUE_SIZE){
+            txQueue[txCount].cycle = start;
+            txQueue[txCount].value = txReg.reg;
+            txCount++;
+        }
+    }
+    pir1.TXIF = (hostCycle >= txRegFree);
+
+    //EUSART receive, clearing CREN clears an overrun, bytes arriving with the FIFO full are lost and set OERR
+    if(!rcsta.CREN){
+        rcsta.OERR = 0;
+        rxFifoCount = 0;
+    }
+    while((rxTail != rxHead) && (rxQueue[rxTail].cycle + hostSerialByteCycles() <= hostCycle)){
+        if(rcsta.CREN && rcsta.SPEN && !rcsta.OERR){
+            if(rxFifoCount < HOST_RX_FIFO_SIZE) rxFifo[rxFifoCount++] = rxQueue[rxTail].value;
+            else rcsta.OERR = 1;
+        }
+        rxTail = (rxTail + 1u) % HOST_SERIAL_QUEUE_SIZE;
+    }
+    pir1.RCIF = (rxFifoCount > 0);
+}
+
+/*------------------------------------------------------------------------------
+ Function: checkInterrupt()
+ *Use: This function sets TMR0IF at each Timer0 overflow and enters the
+ * interrupt handler when it is enabled, so the interrupt preempts the main
+ * loop at its next register access or delay. Overflows while the flag is
+ * still set are lost, as on the target
+------------------------------------------------------------------------------*/
+static void checkInterrupt(void){
+    if(hostCycle >= hostNextTick){
+        hostTickCycle = hostNextTick + ((hostCycle - hostNextTick) / HOST_TICK_CYCLES) * HOST_TICK_CYCLES;
+        hostNextTick = hostTickCycle + HOST_TICK_CYCLES;
+        hostINTCON.TMR0IF = 1;
+    }
+    if(!inInterrupt && hostINTCON.TMR0IF && hostINTCON.TMR0IE && hostINTCON.GIE && (hostInterruptHandler != NULL)){
+        inInterrupt = 1;
+        hostInterruptHandler();
+        inInterrupt = 0;
+    }
+}
+
+/*------------------------------------------------------------------------------
+ Function: hostAdvance(cycles)
+ *Use: This function moves simulated time on, for code with no register access
+ * or a delay. An interrupt during the time runs at the overflow and extends
+ * the time taken, as it would a delay loop
+------------------------------------------------------------------------------*/
+void hostAdvance(uint64_t cycles){
+    do{
+        uint64_t step = cycles;
+        if((hostNextTick > hostCycle) && (hostNextTick - hostCycle < step)) step = hostNextTick - hostCycle;
+        hostCycle += step;
+        cycles -= step;
+        hostSync();
+        checkInterrupt();
+    }while(cycles > 0);
+}
+
+/*------------------------------------------------------------------------------
+ Function: hostAccess()
+ *Use: This function accounts for one register access
+------------------------------------------------------------------------------*/
+static void hostAccess(void){
+    hostAdvance(HOST_ACCESS_CYCLES);
+}
+
+/*------------------------------------------------------------------------------
+ Function: hostReceive(cycle, value)
+ *Use: This function queues a byte whose start bit arrives on RX at cycle,
+ * bytes must be queued in time order. Returns false if the queue is full
+------------------------------------------------------------------------------*/
+bool hostReceive(uint64_t cycle, uint8_t value){
+    uint16_t next = (rxHead + 1u) % HOST_SERIAL_QUEUE_SIZE;
+    if(next == rxTail) return 0;
+    rxQueue[rxHead].cycle = cycle;
+    rxQueue[rxHead].value = value;
+    rxHead = next;
+    return 1;
+}
+
+/*------------------------------------------------------------------------------
+ Function: hostTransmitted(bytes, size)
+ *Use: This function copies out the bytes sent on TX since the last call
+------------------------------------------------------------------------------*/
+uint16_t hostTransmitted(struct hostSerialByte *bytes, uint16_t size){
+    hostSync();
+    uint16_t count = txCount < size ? txCount : size;
+    memcpy(bytes, txQueue, count * sizeof(txQueue[0]));
+    memmove(txQueue, txQueue + count, (txCount - count) * sizeof(txQueue[0]));
+    txCount -= count;
+    return count;
+}
+
+/*------------------------------------------------------------------------------
+ Function: hostSetTrip(tripIL, tripIDS)
+ *Use: This function forces a trip comparator, as a fault on the board would
+------------------------------------------------------------------------------*/
+void hostSetTrip(bool tripIL, bool tripIDS){
+    hostSync();
+    if(tripIL) plant.tripIL = 1;
+    if(tripIDS) plant.tripIDS = 1;
+}
+
+//xc.h accessors
+volatile PORTA_t *hostAccessPORTA(void){
+    hostAccess();
+    portA.reg = latA.reg & ~hostTRISA.reg;                  //outputs read back their latch
+    portA.RA1 = !plant.tripIDS;                             //trip comparators are active low
+    portA.RA3 = !plant.tripIL;
+    portA.RA7 = hostModeSelect;
+    return &portA;
+}
+
+volatile PORTB_t *hostAccessPORTB(void){
+    hostAccess();
+    portB.reg = latB.reg & ~hostTRISB.reg;
+    if(hostTRISB.TRISB0) portB.RB0 = hostControlSelect;
+    if(hostTRISB.TRISB2) portB.RB2 = 1;                     //RX idles high
+    return &portB;
+}
+
+volatile LATA_t *hostAccessLATA(void){
+    hostAccess();
+    return &latA;
+}
+
+volatile LATB_t *hostAccessLATB(void){
+    hostAccess();
+    return &latB;
+}
+
+volatile ADCON0_t *hostAccessADCON0(void){
+    hostAccess();
+    return &adcon0;
+}
+
+volatile PIR1_t *hostAccessPIR1(void){
+    hostAccess();
+    return &pir1;
+}
+
+volatile RCSTA_t *hostAccessRCSTA(void){
+    hostAccess();
+    return &rcsta;
+}
+
+volatile BYTE_t *hostAccessTXREG(void){
+    hostAccess();
+    txPending = 1;                                          //only ever written
+    return &txReg;
+}
+
+volatile BYTE_t *hostAccessRCREG(void){
+    hostAccess();
+    rcReg.reg = rxFifo[0];
+    if(rxFifoCount > 0){
+        rxFifoCount--;
+        memmove(rxFifo, rxFifo + 1, rxFifoCount);
+    }
+    pir1.RCIF = (rxFifoCount > 0);
+    return &rcReg;
+}
+
+volatile BYTE_t *hostAccessTMR0(void){
+    hostAccess();
+    uint64_t count = (hostCycle - hostTickCycle) / 64u;
+    tmr0.reg = count > 255u ? 255u : (uint8_t) count;
+    return &tmr0;
+}
+
+volatile BYTE_t *hostAccessTMR2(void){
+    hostAccess();
+    tmr2.reg = (uint8_t) (hostCycle - timer2Start);
+    return &tmr2;
+}
+
+//XC8 library
+void hostDelayCycles(uint64_t cycles){
+    hostAdvance(cycles);
+}
+
+uint8_t eeprom_read(uint8_t address){
+    hostAccess();
+    return eeprom[address];
+}
+
+void eeprom_write(uint8_t address, uint8_t value){
+    if(hostCycle < eepromFree) hostAdvance(eepromFree - hostCycle);     //waits for the previous write to finish
+    hostAccess();
+    eeprom[address] = value;
+    eepromFree = hostCycle + HOST_EEPROM_CYCLES;
+}
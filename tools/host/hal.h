@@ -0,0 +1,59 @@
+/*
+ * File:   hal.h
+ * Author: agent
+ *
+ * Created on 19 October 2026, 12:55
+ */
+
+//host side of the register shim in xc.h: simulated time, the pins and analog inputs a test drives, and the serial
+//bytes in and out. Time is counted in instruction cycles (8MHz). Firmware code only takes time where it touches a
+//peripheral (HOST_ACCESS_CYCLES per access) or waits on one, so cycle counts are the peripheral and polling time of
+//the code, not its full execution time
+
+#ifndef HAL_H
+#define	HAL_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define HOST_ACCESS_CYCLES      2u          //a bit test and branch of a polling loop, or a register move
+#define HOST_ADC_CYCLES         24u         //11.5 TAD at Fosc/8 plus the acquisition
+#define HOST_TICK_CYCLES        16384u      //Timer0 overflow with the 1:64 prescaler, 2.048ms
+#define HOST_EEPROM_CYCLES      32000u      //4ms write time, the next write waits for it
+#define HOST_RX_FIFO_SIZE       2u          //EUSART receive FIFO, a third byte before a read is an overrun
+#define HOST_SERIAL_QUEUE_SIZE  4096u
+#define HOST_ANALOG_CHANNELS    16u
+
+struct hostSerialByte{
+    uint64_t cycle;                         //start bit
+    uint8_t value;
+};
+
+extern uint64_t hostCycle;                  //simulated time since power on
+extern uint64_t hostTickCycle;              //time of the last Timer0 overflow, TMR0 counts from here
+extern uint64_t hostNextTick;
+extern void (*hostInterruptHandler)(void);  //called for an enabled Timer0 overflow, the firmware interrupt
+extern int16_t hostAnalogOverride[HOST_ANALOG_CHANNELS];    //raw result for a channel in place of the plant, -1 for none
+extern bool hostControlSelect;              //RB0 jumper, high selects pot control at start up and target 2
+extern bool hostModeSelect;                 //RA7, low selects closed loop
+
+void hostReset(void);
+void hostAdvance(uint64_t cycles);
+void hostSync(void);
+double hostPWMDuty(void);
+uint32_t hostPWMPeriodCycles(void);
+bool hostPWMHalfBridge(void);
+uint32_t hostSerialByteCycles(void);
+bool hostReceive(uint64_t cycle, uint8_t value);
+uint16_t hostTransmitted(struct hostSerialByte *bytes, uint16_t size);
+void hostSetTrip(bool tripIL, bool tripIDS);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* HAL_H */
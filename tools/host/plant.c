@@ -0,0 +1,367 @@
+/*
+ * File:   plant.c
+ * Author: agent
+ *
+ * Created on 19 October 2026, 12:40
+ */
+
+#include <math.h>
+#include <stddef.h>
+#include <string.h>
+#include "plant.h"
+
+struct plantParameters plantParameters;
+struct plantState plant;
+
+//discretised model x[k+1] = Ad x[k] + Bd u[k], x = (inductor current, capacitor voltage), u = (switch node volts, sink amps)
+static double Ad[2][2];
+static double Bd[2][2];
+static double outputGain;                   //k = 1 / (1 + ESR * G), Vout = k * (vc + ESR * (il - isink))
+static uint32_t noiseState;
+
+/*------------------------------------------------------------------------------
+ Function: plantConductance()
+ *Use: This function returns the conductance on the output in S, the
+ * resistive load and the connection to the bus
+------------------------------------------------------------------------------*/
+static double plantConductance(void){
+    double G = plantParameters.loadOhms > 0.0 ? 1.0 / plantParameters.loadOhms : 0.0;
+    if(plantParameters.busOhms > 0.0) G += 1.0 / plantParameters.busOhms;
+    return G;
+}
+
+/*------------------------------------------------------------------------------
+ Function: plantSink()
+ *Use: This function returns the output current in A which does not depend
+ * on the output voltage, the constant current load less the current the bus
+ * voltage drives back through the connection
+------------------------------------------------------------------------------*/
+static double plantSink(void){
+    double sink = plantParameters.loadMilliAmps * 1e-3;
+    if(plantParameters.busOhms > 0.0) sink -= plantParameters.busMilliVolts * 1e-3 / plantParameters.busOhms;
+    return sink;
+}
+
+//parameter names as used by tools/specs/default.ini and the sim scripts
+static const struct{
+    const char *name;
+    size_t offset;
+} plantParameterNames[] = {
+    {"inductance_uh",                   offsetof(struct plantParameters, inductanceUH)},
+    {"capacitance_uf",                  offsetof(struct plantParameters, capacitanceUF)},
+    {"esr_mohm",                        offsetof(struct plantParameters, esrMilliOhms)},
+    {"inductor_mohm",                   offsetof(struct plantParameters, inductorMilliOhms)},
+    {"low_side_mohm",                   offsetof(struct plantParameters, lowSideMilliOhms)},
+    {"diode_mv",                        offsetof(struct plantParameters, diodeMilliVolts)},
+    {"load_ohm",                        offsetof(struct plantParameters, loadOhms)},
+    {"load_ma",                         offsetof(struct plantParameters, loadMilliAmps)},
+    {"bus_ohm",                         offsetof(struct plantParameters, busOhms)},
+    {"bus_mv",                          offsetof(struct plantParameters, busMilliVolts)},
+    {"vin_mv",                          offsetof(struct plantParameters, vinMilliVolts)},
+    {"vout_divider",                    offsetof(struct plantParameters, voutDivider)},
+    {"vin_divider",                     offsetof(struct plantParameters, vinDivider)},
+    {"adc_vref_v",                      offsetof(struct plantParameters, adcVref)},
+    {"vout_offset_lsb",                 offsetof(struct plantParameters, voutOffsetLsb)},
+    {"adc_noise_lsb",                   offsetof(struct plantParameters, adcNoiseLsb)},
+    {"current_sensitivity_mv_per_a",    offsetof(struct plantParameters, currentSensitivity)},
+    {"current_offset_v",                offsetof(struct plantParameters, currentOffset)},
+    {"trip_ma",                         offsetof(struct plantParameters, tripMilliAmps)},
+    {"pot_duty_v",                      offsetof(struct plantParameters, potDutyVolts)},
+    {"pot_freq_v",                      offsetof(struct plantParameters, potFreqVolts)},
+};
+
+/*------------------------------------------------------------------------------
+ Function: plantDefaults(parameters)
+ *Use: This function fills in the default board, the present sensors and
+ * dividers with the example power stage and load of tools/specs/default.ini
+------------------------------------------------------------------------------*/
+void plantDefaults(struct plantParameters *parameters){
+    parameters->inductanceUH = 100.0;
+    parameters->capacitanceUF = 220.0;
+    parameters->esrMilliOhms = 50.0;
+    parameters->inductorMilliOhms = 100.0;
+    parameters->lowSideMilliOhms = 0.0;       //ideal switches by default, the efficiency scenarios set the losses
+    parameters->diodeMilliVolts = 0.0;
+    parameters->loadOhms = 12.0;
+    parameters->loadMilliAmps = 0.0;
+    parameters->busOhms = 0.0;
+    parameters->busMilliVolts = 0.0;
+    parameters->vinMilliVolts = 24000.0;
+    parameters->voutDivider = (390.0 + 100.0) / 100.0;
+    parameters->vinDivider = (560.0 + 100.0) / 100.0;
+    parameters->adcVref = 5.0;
+    parameters->voutOffsetLsb = 0.0;
+    parameters->adcNoiseLsb = 1.0;
+    parameters->currentSensitivity = 0.4;
+    parameters->currentOffset = 2.5;
+    parameters->tripMilliAmps = 5000.0;
+    parameters->potDutyVolts = 2.5;
+    parameters->potFreqVolts = 2.5;
+    parameters->noiseSeed = 1;
+}
+
+/*------------------------------------------------------------------------------
+ Function: plantSetParameter(name, value)
+ *Use: This function sets one parameter by its spec file name, the sensitivity
+ * is given in mV per A. Returns false for an unknown name. plantUpdate() must
+ * be called before the next step
+------------------------------------------------------------------------------*/
+bool plantSetParameter(const char *name, double value){
+    if(strcmp(name, "noise_seed") == 0){
+        plantParameters.noiseSeed = (uint32_t) value;
+        noiseState = 0;
+        return true;
+    }
+    if(strcmp(name, "current_sensitivity_mv_per_a") == 0) value /= 1000.0;
+    for(size_t i = 0; i < sizeof(plantParameterNames) / sizeof(plantParameterNames[0]); i++){
+        if(strcmp(name, plantParameterNames[i].name) == 0){
+            *(double *) ((char *) &plantParameters + plantParameterNames[i].offset) = value;
+            return true;
+        }
+    }
+    return false;
+}
+
+/*------------------------------------------------------------------------------
+ Function: plantUpdate()
+ *Use: This function discretises the averaged model for the present
+ * parameters, using the series for exp(A h) and its integral. A step of 1us
+ * is well below the LC period so a few terms are exact to double precision
+------------------------------------------------------------------------------*/
+void plantUpdate(void){
+    double L = plantParameters.inductanceUH * 1e-6;
+    double C = plantParameters.capacitanceUF * 1e-6;
+    double esr = plantParameters.esrMilliOhms * 1e-3;
+    double rL = plantParameters.inductorMilliOhms * 1e-3;
+    double G = plantConductance();
+    double h = PLANT_STEP_CYCLES / PLANT_CYCLES_PER_SECOND;
+    outputGain = 1.0 / (1.0 + esr * G);
+    double k = outputGain;
+
+    double A[2][2] = {{-(k * esr + rL) / L, -k / L}, {(1.0 - k * esr * G) / C, -k * G / C}};
+    double B[2][2] = {{1.0 / L, k * esr / L}, {0.0, (k * esr * G - 1.0) / C}};
+
+    //Ad = sum (A h)^n / n!, Gamma = sum A^n h^(n+1) / (n+1)!
+    double term[2][2] = {{1.0, 0.0}, {0.0, 1.0}};
+    double gamma[2][2] = {{h, 0.0}, {0.0, h}};
+    memcpy(Ad, term, sizeof(Ad));
+    double gammaTerm[2][2];
+    memcpy(gammaTerm, gamma, sizeof(gammaTerm));
+    for(int n = 1; n < 12; n++){
+        double next[2][2], nextGamma[2][2];
+        for(int i = 0; i < 2; i++){
+            for(int j = 0; j < 2; j++){
+                next[i][j] = (term[i][0] * A[0][j] + term[i][1] * A[1][j]) * h / n;
+                nextGamma[i][j] = (gammaTerm[i][0] * A[0][j] + gammaTerm[i][1] * A[1][j]) * h / (n + 1);
+            }
+        }
+        memcpy(term, next, sizeof(term));
+        memcpy(gammaTerm, nextGamma, sizeof(gammaTerm));
+        for(int i = 0; i < 2; i++){
+            for(int j = 0; j < 2; j++){
+                Ad[i][j] += term[i][j];
+                gamma[i][j] += gammaTerm[i][j];
+            }
+        }
+    }
+    for(int i = 0; i < 2; i++){
+        for(int j = 0; j < 2; j++) Bd[i][j] = gamma[i][0] * B[0][j] + gamma[i][1] * B[1][j];
+    }
+    if(noiseState == 0) noiseState = plantParameters.noiseSeed ? plantParameters.noiseSeed : 1;
+}
+
+/*------------------------------------------------------------------------------
+ Function: plantSwitchNode(duty, halfBridge, deadFraction, il, inputCurrent)
+ *Use: This function returns the switch node voltage averaged over a switching
+ * period and sets the average current drawn from Vin. In single output mode
+ * the diode conducts while the switch is off. In half bridge mode the low side
+ * conducts for the off time less the dead band before each edge, and the
+ * diode across the switch taking the current conducts in the dead band
+------------------------------------------------------------------------------*/
+static double plantSwitchNode(double duty, bool halfBridge, double deadFraction, double il, double *inputCurrent){
+    double vin = plantParameters.vinMilliVolts * 1e-3;
+    double diode = plantParameters.diodeMilliVolts * 1e-3;
+    if(!halfBridge){
+        *inputCurrent = duty * il;
+        return duty * vin - (il > 0.0 ? (1.0 - duty) * diode : 0.0);
+    }
+    double high = duty, low = 1.0 - duty, dead = 0.0;       //a duty of 0 or 100% has no edges, no dead band
+    if((duty > 0.0) && (duty < 1.0)){
+        high = duty > deadFraction ? duty - deadFraction : 0.0;
+        low = low > deadFraction ? low - deadFraction : 0.0;
+        dead = 1.0 - high - low;
+    }
+    if(il >= 0.0){
+        *inputCurrent = high * il;
+        return high * vin - low * il * plantParameters.lowSideMilliOhms * 1e-3 - dead * diode;
+    }
+    *inputCurrent = (high + dead) * il;                     //reversed, the high side diode returns it to Vin
+    return (high + dead) * vin - low * il * plantParameters.lowSideMilliOhms * 1e-3 + dead * diode;
+}
+
+/*------------------------------------------------------------------------------
+ Function: plantAdvance(steps, duty, periodCycles, halfBridge, deadCycles)
+ *Use: This function moves the model on by a number of 1us steps with the
+ * switch at the given average duty, or off while a trip comparator is
+ * latched. In single output mode the diode stops the inductor current going
+ * negative, in half bridge mode the low side lets it reverse. A peak current
+ * above the trip level latches both comparators, as the IL and switch
+ * currents share the peak. The energy drawn from Vin and delivered to the
+ * load is added up for the efficiency
+------------------------------------------------------------------------------*/
+void plantAdvance(uint32_t steps, double duty, uint32_t periodCycles, bool halfBridge, uint32_t deadCycles){
+    double sink = plantSink();
+    double h = PLANT_STEP_CYCLES / PLANT_CYCLES_PER_SECOND;
+    double vin = plantParameters.vinMilliVolts * 1e-3;
+    double deadFraction = periodCycles > 0 ? (double) deadCycles / periodCycles : 0.0;
+    if(plant.tripIL || plant.tripIDS) duty = 0.0;
+    double tripLevel = plantParameters.tripMilliAmps * 1e-3 - 0.5 * plantRipple(duty, periodCycles);
+
+    for(uint32_t i = 0; i < steps; i++){
+        double il = plant.inductorCurrent;
+        double vc = plant.capacitorVoltage;
+        double inputCurrent;
+        double switchNode = plantSwitchNode(duty, halfBridge, deadFraction, il, &inputCurrent);
+        plant.inductorCurrent = Ad[0][0] * il + Ad[0][1] * vc + Bd[0][0] * switchNode + Bd[0][1] * sink;
+        plant.capacitorVoltage = Ad[1][0] * il + Ad[1][1] * vc + Bd[1][0] * switchNode + Bd[1][1] * sink;
+        if(!halfBridge && (plant.inductorCurrent < 0.0)) plant.inductorCurrent = 0.0;
+        plant.inputEnergy += vin * inputCurrent * h;
+        plant.outputEnergy += plantVout() * plantLoadCurrent() * h;
+        if((duty > 0.0) && (plant.inductorCurrent > tripLevel)){
+            plant.tripIL = 1;
+            plant.tripIDS = 1;
+            duty = 0.0;
+        }
+    }
+}
+
+/*------------------------------------------------------------------------------
+ Function: plantVout()
+ *Use: This function returns the averaged output voltage, including the ESR
+ * drop of the capacitor current
+------------------------------------------------------------------------------*/
+double plantVout(void){
+    double esr = plantParameters.esrMilliOhms * 1e-3;
+    double sink = plantSink();
+    return outputGain * (plant.capacitorVoltage + esr * (plant.inductorCurrent - sink));
+}
+
+/*------------------------------------------------------------------------------
+ Function: plantLoadCurrent()
+ *Use: This function returns the total load current in A, including the
+ * current into the bus when connected to one
+------------------------------------------------------------------------------*/
+double plantLoadCurrent(void){
+    return plantVout() * plantConductance() + plantSink();
+}
+
+/*------------------------------------------------------------------------------
+ Function: plantRipple(duty, periodCycles)
+ *Use: This function returns the peak to peak inductor ripple current in A for
+ * a switching period of periodCycles instruction cycles
+------------------------------------------------------------------------------*/
+double plantRipple(double duty, uint32_t periodCycles){
+    if(plant.tripIL || plant.tripIDS || (duty <= 0.0) || (plant.inductorCurrent <= 0.0)) return 0.0;
+    double onTime = duty * periodCycles / PLANT_CYCLES_PER_SECOND;
+    double ripple = (plantParameters.vinMilliVolts * 1e-3 - plantVout()) * onTime / (plantParameters.inductanceUH * 1e-6);
+    if(ripple < 0.0) ripple = 0.0;
+    if(ripple > 2.0 * plant.inductorCurrent) ripple = 2.0 * plant.inductorCurrent;   //discontinuous, the valley is clamped at 0
+    return ripple;
+}
+
+/*------------------------------------------------------------------------------
+ Function: plantOutputRipple(duty, periodCycles)
+ *Use: This function returns the peak to peak switching ripple on the output
+ * in V, the ripple current through the ESR plus the charge on C
+------------------------------------------------------------------------------*/
+double plantOutputRipple(double duty, uint32_t periodCycles){
+    double ripple = plantRipple(duty, periodCycles);
+    double period = periodCycles / PLANT_CYCLES_PER_SECOND;
+    return ripple * (outputGain * plantParameters.esrMilliOhms * 1e-3 + period / (8.0 * plantParameters.capacitanceUF * 1e-6));
+}
+
+/*------------------------------------------------------------------------------
+ Function: plantInstantCurrent(duty, periodCycles, phaseCycles)
+ *Use: This function returns the inductor current at a point in the switching
+ * period, the average plus the ripple triangle, which peaks at the end of
+ * the on time
+------------------------------------------------------------------------------*/
+static double plantInstantCurrent(double duty, uint32_t periodCycles, uint32_t phaseCycles){
+    double ripple = plantRipple(duty, periodCycles);
+    double position = (double) phaseCycles / periodCycles;
+    double triangle;
+    if(position < duty) triangle = position / duty - 0.5;
+    else triangle = 0.5 - (position - duty) / (1.0 - duty);
+    return plant.inductorCurrent + ripple * triangle;
+}
+
+/*------------------------------------------------------------------------------
+ Function: plantGaussian()
+ *Use: This function returns a normally distributed value of unit variance
+ * from a seeded xorshift generator, so each run is repeatable
+------------------------------------------------------------------------------*/
+static double plantGaussian(void){
+    double u[2];
+    for(int i = 0; i < 2; i++){
+        noiseState ^= noiseState << 13;
+        noiseState ^= noiseState >> 17;
+        noiseState ^= noiseState << 5;
+        u[i] = (noiseState + 1.0) / 4294967297.0;
+    }
+    return sqrt(-2.0 * log(u[0])) * cos(6.283185307179586 * u[1]);
+}
+
+/*------------------------------------------------------------------------------
+ Function: plantSensorVolts(channel, duty, periodCycles, phaseCycles)
+ *Use: This function returns the voltage at an ADC channel when sampled at
+ * phaseCycles into the switching period, including the ripple. Returns a
+ * negative value for a channel with nothing connected
+------------------------------------------------------------------------------*/
+double plantSensorVolts(uint8_t channel, double duty, uint32_t periodCycles, uint32_t phaseCycles){
+    bool switching = (duty > 0.0) && (duty < 1.0) && !(plant.tripIL || plant.tripIDS) && (periodCycles > 0);
+    double current = switching ? plantInstantCurrent(duty, periodCycles, phaseCycles) : plant.inductorCurrent;
+    double esr = plantParameters.esrMilliOhms * 1e-3;
+
+    switch(channel){
+        case 0:                                                 //IDS on RA0, the switch current flows during the on time only
+            if(switching && ((double) phaseCycles / periodCycles >= duty)) current = 0.0;
+            if(plant.tripIL || plant.tripIDS || duty <= 0.0) current = 0.0;
+            return plantParameters.currentOffset + plantParameters.currentSensitivity * current;
+        case 2:                                                 //IL on RA2
+            return plantParameters.currentOffset + plantParameters.currentSensitivity * current;
+        case 4:                                                 //Vout on RA4, the ripple current through the ESR
+            return (plantVout() + outputGain * esr * (current - plant.inductorCurrent)) / plantParameters.voutDivider
+                    + plantParameters.voutOffsetLsb * plantParameters.adcVref / 1024.0;
+        case 6:                                                 //Vin on RB7
+            return plantParameters.vinMilliVolts * 1e-3 / plantParameters.vinDivider;
+        case 10:                                                //frequency pot on RB2
+            return plantParameters.potFreqVolts;
+        case 11:                                                //duty pot on RB1
+            return plantParameters.potDutyVolts;
+        default:
+            return -1.0;
+    }
+}
+
+/*------------------------------------------------------------------------------
+ Function: plantConvert(volts)
+ *Use: This function converts a voltage to a 10 bit result with the ADC noise
+------------------------------------------------------------------------------*/
+uint16_t plantConvert(double volts){
+    if(volts < 0.0) return 0;
+    double counts = volts / plantParameters.adcVref * 1024.0;
+    if(plantParameters.adcNoiseLsb > 0.0) counts += plantParameters.adcNoiseLsb * plantGaussian();
+    long rounded = lround(floor(counts));
+    if(rounded < 0) rounded = 0;
+    if(rounded > 1023) rounded = 1023;
+    return (uint16_t) rounded;
+}
+
+/*------------------------------------------------------------------------------
+ Function: plantClearTrips()
+ *Use: This function clears the trip comparator latches, as the RB3 pulse does
+------------------------------------------------------------------------------*/
+void plantClearTrips(void){
+    plant.tripIL = 0;
+    plant.tripIDS = 0;
+}
@@ -0,0 +1,78 @@
+/*
+ * File:   plant.h
+ * Author: agent
+ *
+ * Created on 19 October 2026, 12:40
+ */
+
+//averaged model of the buck power stage and its sensors, driven by hal.c from the PWM registers and sampled by the
+//ADC. The default values are those of tools/specs/default.ini
+
+#ifndef PLANT_H
+#define	PLANT_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define PLANT_STEP_CYCLES       8u          //integration step of 1us in instruction cycles (8MHz)
+#define PLANT_CYCLES_PER_SECOND 8000000.0
+
+struct plantParameters{
+    double inductanceUH;
+    double capacitanceUF;
+    double esrMilliOhms;
+    double inductorMilliOhms;               //winding and high side switch resistance in series with the inductor
+    double lowSideMilliOhms;                //low side switch on resistance, in half bridge mode
+    double diodeMilliVolts;                 //forward drop of the freewheel diode, which conducts in the off time in
+                                            //single output mode and in the dead band in half bridge mode
+    double loadOhms;                        //resistive load, 0 for none
+    double loadMilliAmps;                   //constant current load in parallel
+    double busOhms;                         //connection to an external bus at busMilliVolts, 0 for none
+    double busMilliVolts;
+    double vinMilliVolts;
+    double voutDivider;                     //Vout / Vadc, (top + bottom) / bottom
+    double vinDivider;
+    double adcVref;
+    double voutOffsetLsb;                   //offset added to the Vout conversions
+    double adcNoiseLsb;                     //rms noise of each conversion
+    double currentSensitivity;              //V per A
+    double currentOffset;                   //V at 0A
+    double tripMilliAmps;                   //peak inductor current which latches both trip comparators
+    double potDutyVolts;
+    double potFreqVolts;
+    uint32_t noiseSeed;
+};
+
+struct plantState{
+    double inductorCurrent;                 //A, averaged over a switching period
+    double capacitorVoltage;                //V, excluding the ESR drop
+    bool tripIL;                            //trip comparator latches, cleared by the RB3 pulse
+    bool tripIDS;
+    double inputEnergy;                     //J drawn from Vin since power on
+    double outputEnergy;                    //J delivered to the load since power on
+};
+
+extern struct plantParameters plantParameters;
+extern struct plantState plant;
+
+void plantDefaults(struct plantParameters *parameters);
+bool plantSetParameter(const char *name, double value);
+void plantUpdate(void);
+void plantAdvance(uint32_t steps, double duty, uint32_t periodCycles, bool halfBridge, uint32_t deadCycles);
+double plantVout(void);
+double plantLoadCurrent(void);
+double plantRipple(double duty, uint32_t periodCycles);
+double plantOutputRipple(double duty, uint32_t periodCycles);
+double plantSensorVolts(uint8_t channel, double duty, uint32_t periodCycles, uint32_t phaseCycles);
+uint16_t plantConvert(double volts);
+void plantClearTrips(void);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* PLANT_H */
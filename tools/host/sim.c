@@ -0,0 +1,230 @@
+/*
+ * File:   sim.c
+ * Author: agent
+ *
+ * Created on 19 October 2026, 13:20
+ */
+
+//runs the firmware against the plant model, driven by a script on stdin, one command per line:
+//
+//  set <parameter> <value>     plant parameter by its spec file name (plant.c), ie set load_ohm 6
+//  pin control_select|mode_select <0|1>
+//  analog <channel> <raw|off>  fixed ADC result for a channel in place of the plant
+//  trip il|ids|both            latch a trip comparator
+//  rx <hex bytes>              bytes arriving on RX back to back from now
+//  every <ticks>               output every n ticks, default 1
+//  run <seconds>               power on at the first run, then run the firmware and output a row per tick
+//  ticks <n>                   as run, until n more Timer0 ticks have been handled, so inputs set between two ticks
+//                              are seen from the next tick, as when a recorded trace is replayed a sample per tick
+//  tx                          write the bytes transmitted since the last tx as lines tx,<cycle>,<byte> then tx,end,
+//                              for a driver connecting sims on a bus (tools/share_bus.py), used in place of --tx
+//  out                         write the output now as a line out,<cycle>,<plant_vout_mv>,<load_ma>, for a driver
+//                              connecting the outputs of sims to a common load through bus_ohm and bus_mv
+//
+//each row is: t_s,state,duty,period,ref_mv,vout_mv,il_ma,plant_vout_mv,plant_il_ma,load_ma,ripple_mv,trip,periph_cycles,slot,
+//obs_vout_mv,obs_il_ma,obs_load_ma,share_trim_mv,share_collisions,low_side,input_mj,output_mj
+//where vout_mv and il_ma are the filtered values the firmware sees, plant_* are the model and ripple_mv is the peak to
+//peak switching ripple on the output. periph_cycles is the
+//peripheral access and wait time of the interrupt (see hal.h, computation is not counted) and slot the slot it ran. obs_* are the
+//observer estimates, 0 unless the firmware is built with OBSERVER_ENABLED, and share_* the current sharing trim and
+//collision count, 0 unless built with SHARE_ENABLED. low_side is 1 while the ECCP switches the low side (half bridge
+//mode, SYNCHRONOUS_ENABLED), input_mj and output_mj the energy drawn from Vin and delivered to the load since power on.
+//transmitted bytes are written to the file given by --tx as cycle,byte. Output is flushed after each command so a
+//driver can run the sim interactively
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "hal.h"
+#include "plant.h"
+#include "firmware.h"
+
+#define HOST_BACKGROUND_CYCLES  40u         //a pass of the main loop with nothing to send or receive
+
+static bool poweredOn;
+static uint32_t tickCount;
+static uint32_t tickTarget;                //tick count the ticks commands have run to
+static uint64_t cycleTarget;                //cycle the run commands have run to
+static uint32_t outputEvery = 1;
+static FILE *txFile;
+
+/*------------------------------------------------------------------------------
+ Function: writeTransmitted(file, prefix)
+ *Use: This function writes out the bytes sent since the last call
+------------------------------------------------------------------------------*/
+static void writeTransmitted(FILE *file, const char *prefix){
+    struct hostSerialByte bytes[256];
+    uint16_t count;
+    while((count = hostTransmitted(bytes, 256)) > 0){
+        for(uint16_t i = 0; i < count; i++) fprintf(file, "%s%llu,%u\n", prefix, (unsigned long long) bytes[i].cycle, bytes[i].value);
+    }
+}
+
+/*------------------------------------------------------------------------------
+ Function: writeRow(periphCycles)
+ *Use: This function writes the state after a tick
+------------------------------------------------------------------------------*/
+static void writeRow(uint64_t periphCycles){
+    struct firmwareState state;
+    firmwareReadState(&state);
+    printf("%.6f,%u,%u,%u,%u,%d,%d,%.1f,%.1f,%.1f,%.1f,%u,%llu,%u,%d,%d,%d,%d,%u,%u,%.3f,%.3f\n",
+            hostTickCycle / PLANT_CYCLES_PER_SECOND, state.state, state.duty, state.period, state.referenceMilliVolts,
+            state.voutMilliVolts, state.ilMilliAmps, plantVout() * 1000.0, plant.inductorCurrent * 1000.0,
+            plantLoadCurrent() * 1000.0, plantOutputRipple(hostPWMDuty(), hostPWMPeriodCycles()) * 1000.0, (plant.tripIL ? 1u : 0u) | (plant.tripIDS ? 2u : 0u),
+            (unsigned long long) periphCycles, state.slot, state.observerVout, state.observerIL, state.observerLoad,
+            state.shareTrim, state.shareCollisions, hostPWMHalfBridge() ? 1u : 0u, plant.inputEnergy * 1000.0,
+            plant.outputEnergy * 1000.0);
+}
+
+/*------------------------------------------------------------------------------
+ Function: runTick()
+ *Use: This function is the interrupt handler, it runs the firmware interrupt
+ * and writes a row
+------------------------------------------------------------------------------*/
+static void runTick(void){
+    uint64_t entry = hostCycle;
+    firmwareTick();
+    if((++tickCount % outputEvery) == 0) writeRow(hostCycle - entry);
+}
+
+/*------------------------------------------------------------------------------
+ Function: powerOn()
+ *Use: This function runs the firmware start up the first time it is called
+------------------------------------------------------------------------------*/
+static void powerOn(void){
+    if(poweredOn) return;
+    poweredOn = 1;
+    hostInterruptHandler = runTick;
+    firmwareInitialise();
+}
+
+/*------------------------------------------------------------------------------
+ Function: runFor(cycles)
+ *Use: This function runs the main loop, the interrupt is entered from the
+ * register accesses and delays of the main loop as each tick falls due. The
+ * run ends cycles after the end the last call asked for, so the time a pass
+ * overruns the end is not added up over many short runs
+------------------------------------------------------------------------------*/
+static void runFor(uint64_t cycles){
+    cycleTarget += cycles;
+    powerOn();
+    while(hostCycle < cycleTarget){
+        firmwareBackground();
+        hostAdvance(HOST_BACKGROUND_CYCLES);
+    }
+    tickTarget = tickCount;
+    if(txFile != NULL) writeTransmitted(txFile, "");
+}
+
+/*------------------------------------------------------------------------------
+ Function: runTicks(ticks)
+ *Use: This function runs the main loop until the interrupt has run for the
+ * given number of ticks more than the last call asked for. A background pass
+ * waiting on the EEPROM spans more than one tick, any extra ticks are taken
+ * from the next call so the count stays aligned
+------------------------------------------------------------------------------*/
+static void runTicks(uint32_t ticks){
+    tickTarget += ticks;
+    powerOn();
+    while((int32_t) (tickCount - tickTarget) < 0){
+        firmwareBackground();
+        hostAdvance(HOST_BACKGROUND_CYCLES);
+    }
+    cycleTarget = hostCycle;
+    if(txFile != NULL) writeTransmitted(txFile, "");
+}
+
+/*------------------------------------------------------------------------------
+ Function: runCommand(line)
+ *Use: This function runs one script line, returns false if it is not valid
+------------------------------------------------------------------------------*/
+static bool runCommand(char *line){
+    char *command = strtok(line, " \t\r\n");
+    if((command == NULL) || (command[0] == '#')) return 1;
+    char *first = strtok(NULL, " \t\r\n");
+    char *second = strtok(NULL, " \t\r\n");
+
+    if(strcmp(command, "set") == 0){
+        if((first == NULL) || (second == NULL) || !plantSetParameter(first, atof(second))) return 0;
+        plantUpdate();
+    }
+    else if(strcmp(command, "pin") == 0){
+        if((first == NULL) || (second == NULL)) return 0;
+        if(strcmp(first, "control_select") == 0) hostControlSelect = atoi(second) != 0;
+        else if(strcmp(first, "mode_select") == 0) hostModeSelect = atoi(second) != 0;
+        else return 0;
+    }
+    else if(strcmp(command, "analog") == 0){
+        if((first == NULL) || (second == NULL)) return 0;
+        int channel = atoi(first);
+        if((channel < 0) || (channel >= (int) HOST_ANALOG_CHANNELS)) return 0;
+        hostAnalogOverride[channel] = (strcmp(second, "off") == 0) ? -1 : (int16_t) atoi(second);
+    }
+    else if(strcmp(command, "trip") == 0){
+        if(first == NULL) return 0;
+        hostSetTrip(strcmp(first, "ids") != 0, strcmp(first, "il") != 0);
+    }
+    else if(strcmp(command, "rx") == 0){
+        uint64_t cycle = hostCycle;
+        for(char *hex = first; hex != NULL; hex = second, second = strtok(NULL, " \t\r\n")){
+            if(!hostReceive(cycle, (uint8_t) strtoul(hex, NULL, 16))) return 0;
+            cycle += hostSerialByteCycles();
+        }
+    }
+    else if(strcmp(command, "tx") == 0){
+        writeTransmitted(stdout, "tx,");
+        printf("tx,end\n");
+    }
+    else if(strcmp(command, "out") == 0){
+        printf("out,%llu,%.1f,%.1f\n", (unsigned long long) hostCycle, plantVout() * 1000.0, plantLoadCurrent() * 1000.0);
+    }
+    else if(strcmp(command, "every") == 0){
+        if((first == NULL) || (atoi(first) < 1)) return 0;
+        outputEvery = (uint32_t) atoi(first);
+    }
+    else if(strcmp(command, "run") == 0){
+        if(first == NULL) return 0;
+        runFor((uint64_t) (atof(first) * PLANT_CYCLES_PER_SECOND + 0.5));
+    }
+    else if(strcmp(command, "ticks") == 0){
+        if((first == NULL) || (atoi(first) < 1)) return 0;
+        runTicks((uint32_t) atoi(first));
+    }
+    else return 0;
+    return 1;
+}
+
+int main(int argc, char **argv){
+    for(int i = 1; i < argc; i++){
+        if((strcmp(argv[i], "--tx") == 0) && (i + 1 < argc)){
+            txFile = fopen(argv[++i], "w");
+            if(txFile == NULL){
+                perror(argv[i]);
+                return 2;
+            }
+        }
+        else{
+            fprintf(stderr, "usage: sim [--tx file] < script\n");
+            return 2;
+        }
+    }
+
+    plantDefaults(&plantParameters);
+    hostReset();
+    printf("t_s,state,duty,period,ref_mv,vout_mv,il_ma,plant_vout_mv,plant_il_ma,load_ma,ripple_mv,trip,periph_cycles,slot,obs_vout_mv,obs_il_ma,obs_load_ma,share_trim_mv,share_collisions,low_side,input_mj,output_mj\n");
+    fflush(stdout);
+
+    char line[1024];
+    unsigned lineNumber = 0;
+    while(fgets(line, sizeof(line), stdin) != NULL){
+        lineNumber++;
+        if(!runCommand(line)){
+            fprintf(stderr, "sim: line %u not understood\n", lineNumber);
+            return 2;
+        }
+        fflush(stdout);
+        if(txFile != NULL) fflush(txFile);
+    }
+    if(txFile != NULL) fclose(txFile);
+    return 0;
+}
@@ -0,0 +1,178 @@
+/*
+ * File:   xc.h
+ * Author: agent
+ *
+ * Created on 19 October 2026, 12:15
+ */
+
+//host stand-in for the XC8 device header, so the firmware sources compile unmodified with gcc (see hal.c).
+//only the PIC16F1827 registers the firmware uses are declared. Plain registers are storage, the registers
+//with hardware behaviour the firmware waits on or reads back are accessor calls into hal.c, which advance
+//the simulated time and the plant as the real peripheral would
+
+#ifndef HOST_XC_H
+#define	HOST_XC_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+//compiler keywords and intrinsics
+#define __interrupt(...)
+#define __bank(x)
+#define __at(x)
+#define __persistent
+#define __near
+#define NOP()                   do{ }while(0)
+#define CLRWDT()                do{ }while(0)
+#define di()                    (INTCONbits.GIE = 0)
+#define ei()                    (INTCONbits.GIE = 1)
+#define __delay_us(x)           hostDelayCycles((uint64_t) (x) * (_XTAL_FREQ / 4000000UL))
+#define __delay_ms(x)           hostDelayCycles((uint64_t) (x) * (_XTAL_FREQ / 4000UL))
+
+void hostDelayCycles(uint64_t cycles);
+uint8_t eeprom_read(uint8_t address);
+void eeprom_write(uint8_t address, uint8_t value);
+
+//a register with its bit fields, REG is the whole register and the field names are the xxxbits members
+#define HOST_REGISTER_TYPE(name, fields)    typedef union { uint8_t reg; struct { fields }; } name##_t
+#define HOST_PLAIN_REGISTER(name)           extern volatile name##_t host##name
+#define HOST_LIVE_REGISTER(name)            volatile name##_t *hostAccess##name(void)
+
+HOST_REGISTER_TYPE(PORTA, unsigned RA0:1; unsigned RA1:1; unsigned RA2:1; unsigned RA3:1; unsigned RA4:1; unsigned RA5:1; unsigned RA6:1; unsigned RA7:1;);
+HOST_REGISTER_TYPE(PORTB, unsigned RB0:1; unsigned RB1:1; unsigned RB2:1; unsigned RB3:1; unsigned RB4:1; unsigned RB5:1; unsigned RB6:1; unsigned RB7:1;);
+HOST_REGISTER_TYPE(LATA, unsigned LATA0:1; unsigned LATA1:1; unsigned LATA2:1; unsigned LATA3:1; unsigned LATA4:1; unsigned LATA5:1; unsigned LATA6:1; unsigned LATA7:1;);
+HOST_REGISTER_TYPE(LATB, unsigned LATB0:1; unsigned LATB1:1; unsigned LATB2:1; unsigned LATB3:1; unsigned LATB4:1; unsigned LATB5:1; unsigned LATB6:1; unsigned LATB7:1;);
+HOST_REGISTER_TYPE(TRISA, unsigned TRISA0:1; unsigned TRISA1:1; unsigned TRISA2:1; unsigned TRISA3:1; unsigned TRISA4:1; unsigned TRISA5:1; unsigned TRISA6:1; unsigned TRISA7:1;);
+HOST_REGISTER_TYPE(TRISB, unsigned TRISB0:1; unsigned TRISB1:1; unsigned TRISB2:1; unsigned TRISB3:1; unsigned TRISB4:1; unsigned TRISB5:1; unsigned TRISB6:1; unsigned TRISB7:1;);
+HOST_REGISTER_TYPE(ANSELA, unsigned ANSA0:1; unsigned ANSA1:1; unsigned ANSA2:1; unsigned ANSA3:1; unsigned ANSA4:1; unsigned :3;);
+HOST_REGISTER_TYPE(ANSELB, unsigned :1; unsigned ANSB1:1; unsigned ANSB2:1; unsigned ANSB3:1; unsigned ANSB4:1; unsigned ANSB5:1; unsigned ANSB6:1; unsigned ANSB7:1;);
+HOST_REGISTER_TYPE(ADCON0, unsigned ADON:1; unsigned GO_nDONE:1; unsigned CHS:5; unsigned :1;);
+HOST_REGISTER_TYPE(ADCON1, unsigned ADPREF:2; unsigned ADNREF:1; unsigned :1; unsigned ADCS:3; unsigned ADFM:1;);
+HOST_REGISTER_TYPE(CCP1CON, unsigned CCP1M:4; unsigned DC1B:2; unsigned P1M:2;);
+HOST_REGISTER_TYPE(CCP2CON, unsigned CCP2M:4; unsigned DC2B:2; unsigned P2M:2;);
+HOST_REGISTER_TYPE(INTCON, unsigned IOCIF:1; unsigned INTF:1; unsigned TMR0IF:1; unsigned IOCIE:1; unsigned INTE:1; unsigned TMR0IE:1; unsigned PEIE:1; unsigned GIE:1;);
+HOST_REGISTER_TYPE(PIR1, unsigned TMR1IF:1; unsigned TMR2IF:1; unsigned CCP1IF:1; unsigned SSP1IF:1; unsigned TXIF:1; unsigned RCIF:1; unsigned ADIF:1; unsigned TMR1GIF:1;);
+HOST_REGISTER_TYPE(PIE1, unsigned TMR1IE:1; unsigned TMR2IE:1; unsigned CCP1IE:1; unsigned SSP1IE:1; unsigned TXIE:1; unsigned RCIE:1; unsigned ADIE:1; unsigned TMR1GIE:1;);
+HOST_REGISTER_TYPE(T2CON, unsigned T2CKPS:2; unsigned TMR2ON:1; unsigned T2OUTPS:4; unsigned :1;);
+HOST_REGISTER_TYPE(T4CON, unsigned T4CKPS:2; unsigned TMR4ON:1; unsigned T4OUTPS:4; unsigned :1;);
+HOST_REGISTER_TYPE(OSCCON, unsigned SCS:2; unsigned :1; unsigned IRCF:4; unsigned SPLLEN:1;);
+HOST_REGISTER_TYPE(OSCSTAT, unsigned HFIOFS:1; unsigned LFIOFR:1; unsigned MFIOFR:1; unsigned HFIOFL:1; unsigned HFIOFR:1; unsigned OSTS:1; unsigned PLLR:1; unsigned T1OSCR:1;);
+HOST_REGISTER_TYPE(OPTION_REG, unsigned PS:3; unsigned PSA:1; unsigned TMR0SE:1; unsigned TMR0CS:1; unsigned INTEDG:1; unsigned nWPUEN:1;);
+HOST_REGISTER_TYPE(APFCON0, unsigned CCP1SEL:1; unsigned P1CSEL:1; unsigned P1DSEL:1; unsigned CCP2SEL:1; unsigned P2BSEL:1; unsigned SS1SEL:1; unsigned SDO1SEL:1; unsigned RXDTSEL:1;);
+HOST_REGISTER_TYPE(APFCON1, unsigned TXCKSEL:1; unsigned :7;);
+HOST_REGISTER_TYPE(PSTR1CON, unsigned STR1A:1; unsigned STR1B:1; unsigned STR1C:1; unsigned STR1D:1; unsigned STR1SYNC:1; unsigned :3;);
+HOST_REGISTER_TYPE(PWM1CON, unsigned P1DC:7; unsigned P1RSEN:1;);
+HOST_REGISTER_TYPE(CCPTMRS, unsigned C1TSEL:2; unsigned C2TSEL:2; unsigned C3TSEL:2; unsigned C4TSEL:2;);
+HOST_REGISTER_TYPE(TXSTA, unsigned TX9D:1; unsigned TRMT:1; unsigned BRGH:1; unsigned SENDB:1; unsigned SYNC:1; unsigned TXEN:1; unsigned TX9:1; unsigned CSRC:1;);
+HOST_REGISTER_TYPE(RCSTA, unsigned RX9D:1; unsigned OERR:1; unsigned FERR:1; unsigned ADDEN:1; unsigned CREN:1; unsigned SREN:1; unsigned RX9:1; unsigned SPEN:1;);
+HOST_REGISTER_TYPE(BAUDCON, unsigned ABDEN:1; unsigned WUE:1; unsigned :1; unsigned BRG16:1; unsigned SCKP:1; unsigned :1; unsigned RCIDL:1; unsigned ABDOVF:1;);
+typedef union { uint8_t reg; } BYTE_t;              //registers with no named bits
+
+//storage only
+HOST_PLAIN_REGISTER(TRISA);
+HOST_PLAIN_REGISTER(TRISB);
+HOST_PLAIN_REGISTER(ANSELA);
+HOST_PLAIN_REGISTER(ANSELB);
+HOST_PLAIN_REGISTER(ADCON1);
+HOST_PLAIN_REGISTER(CCP1CON);
+HOST_PLAIN_REGISTER(CCP2CON);
+HOST_PLAIN_REGISTER(INTCON);
+HOST_PLAIN_REGISTER(PIE1);
+HOST_PLAIN_REGISTER(T2CON);
+HOST_PLAIN_REGISTER(T4CON);
+HOST_PLAIN_REGISTER(OSCCON);
+HOST_PLAIN_REGISTER(OSCSTAT);
+HOST_PLAIN_REGISTER(OPTION_REG);
+HOST_PLAIN_REGISTER(APFCON0);
+HOST_PLAIN_REGISTER(APFCON1);
+HOST_PLAIN_REGISTER(PSTR1CON);
+HOST_PLAIN_REGISTER(PWM1CON);
+HOST_PLAIN_REGISTER(CCPTMRS);
+HOST_PLAIN_REGISTER(TXSTA);
+HOST_PLAIN_REGISTER(BAUDCON);
+extern volatile uint8_t ADRESH, ADRESL, PR2, PR4, CCPR1L, CCPR2L, SPBRGL, SPBRGH, TMR4;
+
+//accessors, see hal.c for the behaviour of each
+HOST_LIVE_REGISTER(PORTA);          //pin levels from the plant: trip comparators, control and mode select
+HOST_LIVE_REGISTER(PORTB);
+HOST_LIVE_REGISTER(LATA);
+HOST_LIVE_REGISTER(LATB);           //the over current clear pulse on RB3 resets the trip latches
+HOST_LIVE_REGISTER(ADCON0);         //setting GO_nDONE runs a conversion of the selected channel
+HOST_LIVE_REGISTER(PIR1);           //TMR2IF from the PWM period, TXIF and RCIF from the EUSART
+HOST_LIVE_REGISTER(RCSTA);          //clearing CREN clears an overrun
+volatile BYTE_t *hostAccessTXREG(void);        //a write sends the byte
+volatile BYTE_t *hostAccessRCREG(void);        //a read takes the next received byte
+volatile BYTE_t *hostAccessTMR0(void);         //time since the tick started, prescaled by 64
+volatile BYTE_t *hostAccessTMR2(void);
+
+#define TRISA           (hostTRISA.reg)
+#define TRISAbits       hostTRISA
+#define TRISB           (hostTRISB.reg)
+#define TRISBbits       hostTRISB
+#define ANSELA          (hostANSELA.reg)
+#define ANSELAbits      hostANSELA
+#define ANSELB          (hostANSELB.reg)
+#define ANSELBbits      hostANSELB
+#define ADCON1          (hostADCON1.reg)
+#define ADCON1bits      hostADCON1
+#define CCP1CON         (hostCCP1CON.reg)
+#define CCP1CONbits     hostCCP1CON
+#define CCP2CON         (hostCCP2CON.reg)
+#define CCP2CONbits     hostCCP2CON
+#define INTCON          (hostINTCON.reg)
+#define INTCONbits      hostINTCON
+#define TMR0IF_bit      (hostINTCON.TMR0IF)
+#define PIE1            (hostPIE1.reg)
+#define PIE1bits        hostPIE1
+#define T2CON           (hostT2CON.reg)
+#define T2CONbits       hostT2CON
+#define T4CON           (hostT4CON.reg)
+#define T4CONbits       hostT4CON
+#define OSCCON          (hostOSCCON.reg)
+#define OSCCONbits      hostOSCCON
+#define OSCSTAT         (hostOSCSTAT.reg)
+#define OSCSTATbits     hostOSCSTAT
+#define OPTION_REG      (hostOPTION_REG.reg)
+#define OPTION_REGbits  hostOPTION_REG
+#define APFCON0         (hostAPFCON0.reg)
+#define APFCON0bits     hostAPFCON0
+#define APFCON1         (hostAPFCON1.reg)
+#define APFCON1bits     hostAPFCON1
+#define PSTR1CON        (hostPSTR1CON.reg)
+#define PSTR1CONbits    hostPSTR1CON
+#define PWM1CON         (hostPWM1CON.reg)
+#define PWM1CONbits     hostPWM1CON
+#define CCPTMRS         (hostCCPTMRS.reg)
+#define CCPTMRSbits     hostCCPTMRS
+#define TXSTA           (hostTXSTA.reg)
+#define TXSTAbits       hostTXSTA
+#define BAUDCON         (hostBAUDCON.reg)
+#define BAUDCONbits     hostBAUDCON
+
+#define PORTA           (hostAccessPORTA()->reg)
+#define PORTAbits       (*hostAccessPORTA())
+#define PORTB           (hostAccessPORTB()->reg)
+#define PORTBbits       (*hostAccessPORTB())
+#define LATA            (hostAccessLATA()->reg)
+#define LATAbits        (*hostAccessLATA())
+#define LATB            (hostAccessLATB()->reg)
+#define LATBbits        (*hostAccessLATB())
+#define ADCON0          (hostAccessADCON0()->reg)
+#define ADCON0bits      (*hostAccessADCON0())
+#define PIR1            (hostAccessPIR1()->reg)
+#define PIR1bits        (*hostAccessPIR1())
+#define RCSTA           (hostAccessRCSTA()->reg)
+#define RCSTAbits       (*hostAccessRCSTA())
+#define TXREG           (hostAccessTXREG()->reg)
+#define RCREG           (hostAccessRCREG()->reg)
+#define TMR0            (hostAccessTMR0()->reg)
+#define TMR2            (hostAccessTMR2()->reg)
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* HOST_XC_H */
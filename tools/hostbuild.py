@@ -0,0 +1,116 @@
+#!/usr/bin/env python3
+"""
+File:   hostbuild.py
+
+Builds the host simulation of the firmware (tools/host) with gcc, optionally with firmware
+switches and constants overridden, and runs scripts through it. Used by benchmark.py,
+replay.py, monte_carlo.py and share_bus.py:
+
+    python tools/hostbuild.py [--set NAME=VALUE ...]
+
+Each --set replaces the value of every "#define NAME" in the module headers, in a copy of
+the sources under tools/host/build, so the project files are never changed. Builds with
+the same overrides share a directory and are only rebuilt when a source changes. Prints
+the path of the sim executable.
+"""
+
+import argparse
+import hashlib
+import os
+import re
+import subprocess
+import sys
+
+PROJECT_DIR = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+HOST_DIR = os.path.join(PROJECT_DIR, "tools", "host")
+BUILD_ROOT = os.path.join(HOST_DIR, "build")
+
+
+def parse_overrides(items):
+    """NAME=VALUE strings to a dict"""
+    overrides = {}
+    for item in items or []:
+        name, sep, value = item.partition("=")
+        if not sep or not re.match(r"^\w+$", name.strip()):
+            raise ValueError("override %r is not NAME=VALUE" % item)
+        overrides[name.strip()] = value.strip()
+    return overrides
+
+
+def apply_overrides(text, overrides, found):
+    for name, value in overrides.items():
+        pattern = re.compile(r"^(\s*#define\s+%s\s+)(\([^)]*\)|\S+)" % re.escape(name), re.M)
+        text, count = pattern.subn(lambda m: m.group(1) + value, text)
+        if count:
+            found.add(name)
+    return text
+
+
+def copy_sources(overrides, source_dir):
+    """the firmware sources with the overrides applied, only files whose content changed are rewritten"""
+    os.makedirs(source_dir, exist_ok=True)
+    found = set()
+    for name in sorted(os.listdir(PROJECT_DIR)):
+        if not name.endswith((".c", ".h")):
+            continue
+        with open(os.path.join(PROJECT_DIR, name)) as f:
+            text = f.read()
+        if name.endswith(".h"):
+            text = apply_overrides(text, overrides, found)
+        path = os.path.join(source_dir, name)
+        if os.path.exists(path):
+            with open(path) as f:
+                if f.read() == text:
+                    continue
+        with open(path, "w") as f:
+            f.write(text)
+    missing = set(overrides) - found
+    if missing:
+        raise ValueError("no #define for %s in the module headers" % ", ".join(sorted(missing)))
+
+
+def build(overrides=None, quiet=True):
+    """path to the sim built with the overrides, building it if needed"""
+    overrides = overrides or {}
+    if overrides:
+        key = hashlib.sha1(repr(sorted(overrides.items())).encode()).hexdigest()[:12]
+        build_dir = os.path.join(BUILD_ROOT, key)
+        source_dir = os.path.join(build_dir, "src")
+        copy_sources(overrides, source_dir)
+    else:
+        build_dir = os.path.join(BUILD_ROOT, "default")
+        source_dir = PROJECT_DIR
+    result = subprocess.run(["make", "-C", HOST_DIR, "FIRMWARE_DIR=" + source_dir, "BUILD_DIR=" + build_dir],
+                            stdout=subprocess.PIPE, stderr=subprocess.STDOUT, universal_newlines=True)
+    if result.returncode != 0:
+        sys.stderr.write(result.stdout)
+        raise RuntimeError("host build failed")
+    if not quiet:
+        sys.stderr.write(result.stdout)
+    return os.path.join(build_dir, "sim")
+
+
+def run(sim, script, tx_path=None):
+    """runs a script through the sim, returns the rows as dicts of floats"""
+    command = [sim] + (["--tx", tx_path] if tx_path else [])
+    result = subprocess.run(command, input=script, stdout=subprocess.PIPE, stderr=subprocess.PIPE,
+                            universal_newlines=True)
+    if result.returncode != 0:
+        raise RuntimeError("sim failed: " + result.stderr.strip())
+    lines = result.stdout.splitlines()
+    header = lines[0].split(",")
+    return [dict(zip(header, map(float, line.split(",")))) for line in lines[1:]]
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n\n")[1].strip())
+    parser.add_argument("--set", action="append", metavar="NAME=VALUE", help="override a firmware #define")
+    args = parser.parse_args()
+    try:
+        print(build(parse_overrides(args.set), quiet=False))
+    except (ValueError, RuntimeError) as error:
+        sys.exit("hostbuild: %s" % error)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,250 @@
+#!/usr/bin/env python3
+"""
+File:   memory_report.py
+
+Produces a RAM/flash budget report from the XC8 .map and .lst files of a build, or an
+estimate of the RAM of a configuration from the host build. Run automatically by the
+.build-post target in the Makefile and by the host check (tools/host/Makefile), or by hand:
+
+    python tools/memory_report.py dist/default
+    python tools/memory_report.py --estimate [--set NAME=VALUE ...]
+
+For every .map file found under the given directory (or the .map file given)
+the report lists the used/free space per memory class, which bank each of the
+interrupt-hot objects was placed in, the largest functions, and the number of
+bank selects (movlb) in each function taken from the matching .lst file.
+The report is printed and written to memory_report.txt beside the .map file.
+The exit status is 1 if no map is found or a hot object is not in bank 0.
+
+--estimate needs no XC8. It builds the firmware for the host (see hostbuild.py) with
+packed structs and short enums, which gives the XC8 size of each static object (the
+baseline map's 226 bytes of bss are matched exactly), places the __bank() objects in
+their banks and checks each bank and the total against the PIC16F1827, with
+STACK_RESERVE bytes kept for the compiled stack. The exit status is 1 if it does not fit.
+"""
+
+import argparse
+import os
+import re
+import subprocess
+import sys
+
+import hostbuild
+
+#objects which are accessed on every tick and should be in bank 0 (see HotState.h)
+HOT_SYMBOLS = ["_hotState", "_currentState"]
+
+#classes reported, in order
+CLASSES = ["CODE", "COMMON", "BANK0", "BANK1", "BANK2", "BANK3", "BANK4", "EEDATA"]
+
+BANK_RANGES = [("COMMON", 0x70, 0x7F), ("BANK0", 0x20, 0x6F), ("BANK1", 0xA0, 0xEF),
+               ("BANK2", 0x120, 0x16F), ("BANK3", 0x1A0, 0x1EF), ("BANK4", 0x220, 0x24F)]
+
+#compiled stack (parameters and autos) kept free by the estimate, 90 bytes in the map of the baseline build
+STACK_RESERVE = 96
+
+#objects of the host build which are not firmware (tools/host/firmware.c)
+HOST_ONLY_SYMBOLS = ["lastSlot"]
+
+
+def parse_class_sizes(text):
+    """total size of each class from the linker -A options, ie -ACODE=00h-07FFhx2"""
+    sizes = {}
+    for name, ranges in re.findall(r"-A(\w+)=([0-9A-Fa-fhx,\-/]+)", text):
+        total = 0
+        for part in ranges.split("/")[0].split(","):
+            m = re.match(r"([0-9A-Fa-f]+)h-([0-9A-Fa-f]+)h(?:x(\d+))?", part)
+            if m:
+                total += (int(m.group(2), 16) - int(m.group(1), 16) + 1) * int(m.group(3) or 1)
+        sizes[name] = total
+    return sizes
+
+
+def parse_unused(text):
+    """free space per class from the UNUSED ADDRESS RANGES table"""
+    unused = {}
+    block = text.split("UNUSED ADDRESS RANGES", 1)
+    if len(block) < 2:
+        return unused
+    current = None
+    for line in block[1].splitlines()[3:]:
+        if not line.strip():
+            if current is not None:
+                break
+            continue
+        fields = line.split()
+        if re.match(r"[0-9A-Fa-f]+-[0-9A-Fa-f]+$", fields[0]):
+            rng = fields[0]
+        else:
+            current = fields[0]
+            rng = fields[1]
+        lo, hi = (int(x, 16) for x in rng.split("-"))
+        unused[current] = unused.get(current, 0) + (hi - lo + 1)
+    return unused
+
+
+def parse_symbols(text):
+    """address of each symbol from the symbol table"""
+    symbols = {}
+    for name, psect, addr in re.findall(r"^(_\w+)\s+(\w+)\s+([0-9A-F]{5})\s*$", text, re.M):
+        symbols[name] = (psect, int(addr, 16))
+    return symbols
+
+
+def parse_function_sizes(text):
+    """function sizes in words from the per file estimated size section"""
+    return {name: int(size) for name, size in
+            re.findall(r"^\t\t(_\w+)\s*\tCODE\s*\t[0-9A-F]+\t[0-9A-F]+\t(\d+)", text, re.M)}
+
+
+def parse_bank_selects(lst_path):
+    """number of movlb instructions in each function of the assembler listing"""
+    counts = {}
+    current = None
+    with open(lst_path, errors="replace") as f:
+        for line in f:
+            m = re.search(r";; \*+ function (_\w+) \*+", line)
+            if m:
+                current = m.group(1)
+                counts[current] = 0
+            elif current and re.search(r"\tmovlb\t", line):
+                counts[current] += 1
+    return counts
+
+
+def bank_of(addr):
+    for name, lo, hi in BANK_RANGES:
+        if lo <= addr <= hi:
+            return name
+    return "other"
+
+
+def report(map_path):
+    with open(map_path, errors="replace") as f:
+        text = f.read()
+    sizes = parse_class_sizes(text)
+    unused = parse_unused(text)
+    symbols = parse_symbols(text)
+    functions = parse_function_sizes(text)
+    lst_path = os.path.splitext(map_path)[0] + ".lst"
+    selects = parse_bank_selects(lst_path) if os.path.exists(lst_path) else {}
+
+    out = ["Memory report for " + map_path, ""]
+    out.append("%-8s %8s %8s %8s %6s" % ("Class", "Size", "Used", "Free", "Used%"))
+    for cls in CLASSES:
+        if cls not in sizes:
+            continue
+        free = unused.get(cls, 0)
+        used = sizes[cls] - free
+        out.append("%-8s %8d %8d %8d %5.1f%%" % (cls, sizes[cls], used, free, 100.0 * used / sizes[cls]))
+
+    out += ["", "Hot object placement (should be BANK0 or COMMON):"]
+    misplaced = 0
+    for name in HOT_SYMBOLS:
+        if name in symbols:
+            psect, addr = symbols[name]
+            out.append("  %-24s 0x%03X %-7s %s" % (name, addr, bank_of(addr), psect))
+            misplaced += bank_of(addr) not in ("BANK0", "COMMON")
+        else:
+            out.append("  %-24s not found" % name)
+            misplaced += 1
+
+    out += ["", "Functions by size (words) and bank selects:"]
+    for name, size in sorted(functions.items(), key=lambda item: -item[1]):
+        out.append("  %-32s %5d %5s" % (name, size, selects.get(name, "-")))
+    if "_Tick490Hz" in selects:
+        out += ["", "Bank selects in _Tick490Hz: %d" % selects["_Tick490Hz"]]
+    out.append("Total bank selects: %d" % sum(selects.values()))
+
+    result = "\n".join(out) + "\n"
+    with open(os.path.join(os.path.dirname(map_path), "memory_report.txt"), "w") as f:
+        f.write(result)
+    return result, misplaced == 0
+
+
+def static_objects(overrides):
+    """size of each static object of the firmware built for the host with the given overrides, and the source
+    directory it was built from"""
+    sim = hostbuild.build(overrides)
+    build_dir = os.path.dirname(sim)
+    source_dir = os.path.join(build_dir, "src") if overrides else hostbuild.PROJECT_DIR
+    obj = os.path.join(build_dir, "ram.o")
+    subprocess.check_call(["gcc", "-std=gnu99", "-w", "-fpack-struct", "-fshort-enums", "-fno-common",
+                           "-I" + hostbuild.HOST_DIR, "-I" + source_dir, "-Dmain=firmwareMain",
+                           "-c", os.path.join(hostbuild.HOST_DIR, "firmware.c"), "-o", obj])
+    symbols = subprocess.check_output(["nm", "-S", obj], universal_newlines=True)
+    objects = {}
+    for fields in (line.split() for line in symbols.splitlines()):
+        if len(fields) == 4 and fields[2] in "bBdD" and fields[3] not in HOST_ONLY_SYMBOLS:
+            objects[fields[3]] = int(fields[1], 16)
+    return objects, source_dir
+
+
+def fixed_banks(source_dir):
+    """bank of each object declared with __bank() in the module headers"""
+    banks = {}
+    for name in os.listdir(source_dir):
+        if name.endswith(".h"):
+            with open(os.path.join(source_dir, name), errors="replace") as f:
+                for bank, symbol in re.findall(r"^__bank\((\d)\)[^=;\[]*?(\w+)\s*[=;\[]", f.read(), re.M):
+                    banks[symbol] = "BANK" + bank
+    return banks
+
+
+def estimate(overrides):
+    """RAM estimate of a configuration against the bank sizes, returns the report and True if it fits"""
+    objects, source_dir = static_objects(overrides)
+    placed = {}
+    for symbol, bank in fixed_banks(source_dir).items():
+        if symbol in objects:
+            placed[bank] = placed.get(bank, 0) + objects[symbol]
+    ram = sum(hi - lo + 1 for _, lo, hi in BANK_RANGES)
+    total = sum(objects.values())
+    out = ["RAM estimate for %s" % (" ".join("%s=%s" % item for item in sorted(overrides.items())) or "the committed configuration"),
+           "", "%-8s %8s %8s" % ("Bank", "Size", "Fixed")]
+    fits = True
+    for name, lo, hi in BANK_RANGES:
+        size = hi - lo + 1
+        out.append("%-8s %8d %8d" % (name, size, placed.get(name, 0)))
+        fits = fits and placed.get(name, 0) <= size
+    free = ram - STACK_RESERVE - total
+    out += ["", "Static objects %d bytes in %d objects, %d bytes placed by __bank()" % (total, len(objects), sum(placed.values())),
+            "Free after the %d byte stack reserve: %d bytes of %d" % (STACK_RESERVE, free, ram),
+            "Largest: " + ", ".join("%s %d" % item for item in sorted(objects.items(), key=lambda item: -item[1])[:8])]
+    fits = fits and free >= 0
+    out.append("fits" if fits else "DOES NOT FIT")
+    return "\n".join(out) + "\n", fits
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n\n")[1].strip())
+    parser.add_argument("target", nargs="?", default="dist", help="build directory or .map file, default %(default)s")
+    parser.add_argument("--estimate", action="store_true", help="estimate the RAM from the host build instead")
+    parser.add_argument("--set", action="append", metavar="NAME=VALUE", help="override a firmware #define, with --estimate")
+    args = parser.parse_args()
+
+    if args.estimate:
+        try:
+            result, fits = estimate(hostbuild.parse_overrides(args.set))
+        except (ValueError, RuntimeError, subprocess.CalledProcessError) as error:
+            sys.exit("memory_report: %s" % error)
+        print(result)
+        return 0 if fits else 1
+
+    maps = [args.target] if args.target.endswith(".map") else [
+        os.path.join(root, name) for root, _, files in os.walk(args.target) for name in files if name.endswith(".map")]
+    if not maps:
+        print("memory_report: no .map files found under " + args.target)
+        return 1
+    status = 0
+    for path in sorted(maps):
+        result, placed = report(path)
+        print(result)
+        if not placed:
+            print("memory_report: a hot object is not in bank 0 or common RAM in " + path)
+            status = 1
+    return status
+
+
+if __name__ == "__main__":
+    sys.exit(main())
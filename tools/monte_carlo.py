@@ -0,0 +1,326 @@
+#!/usr/bin/env python3
+"""
+File:   monte_carlo.py
+
+Runs a Monte Carlo tolerance sweep of the voltage loop, so a gain or filter change can be
+checked across the spread of boards and loads rather than on one unit:
+
+    python tools/monte_carlo.py tools/specs/default.ini [--trials N] [--jobs N] [--seed N]
+                                [--set NAME=VALUE ...] [--csv trials.csv] [--trace N trace.csv]
+
+Each trial draws L, C, ESR, the Vout divider resistors, the ADC reference and offset from
+the [tolerance] section of the spec, and the input voltage and load from their ranges, and
+runs the real firmware on the host simulation (tools/host, built by hostbuild.py) against
+the plant model with those values. The firmware is built with TARGET_VOLTAGE_MV_1 and _2
+set to the two targets of the [monte_carlo] section, powers on and soft starts into the
+first, and the control select jumper steps it to the second after settle_before_step_s.
+Each trial records the overshoot of the plant output, the settling time into the band, the
+final regulation error and the phase margin at that trial's values. A trial fails if it
+does not settle, ends oscillating, ends on a duty limit, ends outside voltage mode control
+(a fault) or has less than the minimum phase margin. Trials run in parallel across the CPU
+cores, a sim process each, and each one is seeded from the sweep seed and its number, so a
+failing trial can be rerun alone with --trace to write its waveforms.
+
+--set overrides any firmware #define for the build, so the sweep tests the values that
+would be flashed. The phase and gain margins are the small signal margins of the PI voltage
+loop (design_spec.py) with the gains as flashed, read from the module headers (or
+DesignSpec.h when DESIGN_SPEC_ENABLED is set in Global.h). The plant is the averaged LC
+model of tools/host/plant.c, discontinuous conduction at light load is not modelled.
+"""
+
+import argparse
+import configparser
+import csv
+import math
+import multiprocessing
+import os
+import random
+import re
+import sys
+
+import design_spec
+import hostbuild
+
+PROJECT_DIR = design_spec.PROJECT_DIR
+
+#headers holding the constants the margins and duty limits use, DesignSpec.h replaces the hand set values when enabled
+MODEL_HEADERS = ["Controller.h", "InputVoltage.h", "Reference.h", "PWM.h", "Observer.h"]
+
+STATE_VOLTAGE_MODE = 2          #enum stateMachine
+
+PERCENTILES = (5, 50, 95, 99)
+
+
+def read_defines(path, values):
+    with open(path) as f:
+        for match in re.finditer(r"^#define\s+(\w+)\s+(\([^)]*\)|\S+)", f.read(), re.M):
+            values.setdefault(match.group(1), match.group(2))
+
+
+def evaluate(name, defines, depth=0):
+    """integer value of an object like macro, resolving the macros it refers to"""
+    text = re.sub(r"(?<=\d)(UL|ul|u|U|L)\b", "", defines[name])
+    if depth > 8:
+        raise ValueError("macro %s nests too deeply" % name)
+    text = re.sub(r"\b[A-Z_][A-Z0-9_]*\b", lambda m: str(evaluate(m.group(0), defines, depth + 1)), text)
+    return int(eval(text.replace("/", "//"), {"__builtins__": {}}))
+
+
+def read_firmware(overrides):
+    """the firmware constants the margins and duty limits need, as integers"""
+    defines = {}
+    for name, value in overrides.items():
+        defines[name] = value
+    with open(os.path.join(PROJECT_DIR, "Global.h")) as f:
+        if re.search(r"^#define\s+DESIGN_SPEC_ENABLED\s+1\b", f.read(), re.M):
+            read_defines(os.path.join(PROJECT_DIR, "DesignSpec.h"), defines)
+    for name in MODEL_HEADERS:
+        read_defines(os.path.join(PROJECT_DIR, name), defines)
+
+    names = ["VOLTAGE_MODE_CONTROL_PERIOD", "VOLTAGE_MODE_KP", "VOLTAGE_MODE_KP_EXPONENT", "VOLTAGE_MODE_KI",
+             "VOLTAGE_MODE_KI_EXPONENT", "DT_GAIN", "DT_EXPONENT", "SIZE_OF_VSENSOR_FILTER", "MIN_DUTY", "MAX_DUTY",
+             "VOLTAGE_MODE_ALGORITHM", "VOLTAGE_MODE_PI", "OBSERVER_ENABLED", "DROOP_ENABLED", "CONTROL_METHOD",
+             "VOLTAGE_MODE_CONTROL"]
+    return {name: evaluate(name, defines) for name in names}
+
+
+def model_notes(fw):
+    """parts of the configured loop the margins leave out, the step responses are of the firmware as built"""
+    notes = []
+    if fw["CONTROL_METHOD"] != fw["VOLTAGE_MODE_CONTROL"]:
+        notes.append("CONTROL_METHOD is not VOLTAGE_MODE_CONTROL, the margins are of the voltage loop")
+    if fw["VOLTAGE_MODE_ALGORITHM"] != fw["VOLTAGE_MODE_PI"]:
+        notes.append("VOLTAGE_MODE_ALGORITHM is not the PI controller, the margins are of the PI controller")
+    if fw["OBSERVER_ENABLED"]:
+        notes.append("OBSERVER_ENABLED is set, the margins are of the moving average without the observer")
+    if fw["DROOP_ENABLED"]:
+        notes.append("DROOP_ENABLED is set, the margins leave out droop")
+    return notes
+
+
+def read_sweep(path):
+    ini = configparser.ConfigParser(inline_comment_prefixes=(";",))
+    ini.read(path)
+    g = lambda section, key, default: ini.getfloat(section, key, fallback=default)
+    return {
+        "inductance_pct": g("tolerance", "inductance_pct", 20), "capacitance_pct": g("tolerance", "capacitance_pct", 20),
+        "esr_pct": g("tolerance", "esr_pct", 50), "divider_pct": g("tolerance", "divider_pct", 1),
+        "vref_pct": g("tolerance", "adc_vref_pct", 1), "offset_lsb": g("tolerance", "vout_offset_lsb", 2),
+        "noise_lsb": g("tolerance", "adc_noise_lsb", 1),
+        "trials": int(g("monte_carlo", "trials", 2000)), "seed": int(g("monte_carlo", "seed", 1)),
+        "from_mv": g("monte_carlo", "step_from_mv", 12000), "to_mv": g("monte_carlo", "step_to_mv", 16000),
+        "settle_s": g("monte_carlo", "settle_before_step_s", 1), "run_s": g("monte_carlo", "run_after_step_s", 2),
+        "band_pct": g("monte_carlo", "settle_band_pct", 2), "tail_s": g("monte_carlo", "tail_s", 0.25),
+        "min_phase_margin": g("monte_carlo", "min_phase_margin_deg", 45),
+    }
+
+
+def draw_trial(spec, sweep, seed, index):
+    """the component values, operating point and ADC errors of one trial"""
+    rng = random.Random(seed * 1000003 + index)
+    spread = lambda nominal, pct: nominal * (1.0 + rng.uniform(-pct, pct) / 100.0)
+    divider = spec["vout_divider"]
+    bottom = spread(1.0, sweep["divider_pct"])
+    top = spread(divider - 1.0, sweep["divider_pct"])
+    return {
+        "trial": index,
+        "inductance": spread(spec["inductance"], sweep["inductance_pct"]),
+        "capacitance": spread(spec["capacitance"], sweep["capacitance_pct"]),
+        "esr": spread(spec["esr"], sweep["esr_pct"]),
+        "load": 1.0 / rng.uniform(1.0 / spec["r_max"], 1.0 / spec["r_min"]),   #uniform in load current
+        "vin_mv": rng.uniform(spec["vin_min_mv"], spec["vin_max_mv"]),
+        "vout_divider": (top + bottom) / bottom,
+        "vref": spread(spec["vref"], sweep["vref_pct"]),
+        "offset_lsb": rng.uniform(-sweep["offset_lsb"], sweep["offset_lsb"]),
+        "noise_seed": rng.getrandbits(32),
+    }
+
+
+def trial_script(spec, sweep, trial):
+    """sim script setting the trial's plant, settling at the first target then stepping to the second"""
+    parameters = [
+        ("inductance_uh", trial["inductance"] * 1e6), ("capacitance_uf", trial["capacitance"] * 1e6),
+        ("esr_mohm", trial["esr"] * 1e3), ("inductor_mohm", spec["dcr"] * 1e3), ("load_ohm", trial["load"]),
+        ("vin_mv", trial["vin_mv"]), ("vout_divider", trial["vout_divider"]), ("adc_vref_v", trial["vref"]),
+        ("vout_offset_lsb", trial["offset_lsb"]), ("adc_noise_lsb", sweep["noise_lsb"]),
+        ("noise_seed", trial["noise_seed"]),
+    ]
+    lines = ["set %s %.9g" % parameter for parameter in parameters]
+    lines += ["run %g" % sweep["settle_s"], "pin control_select 1", "run %g" % sweep["run_s"]]
+    return "\n".join(lines) + "\n"
+
+
+def simulate(sim, spec, derived, fw, sweep, trial, trace=None):
+    """runs one trial on the sim, returns its results and appends (time, reference, Vout, measured, duty, state)
+    rows from the step on to trace"""
+    rows = [row for row in hostbuild.run(sim, trial_script(spec, sweep, trial)) if row["t_s"] >= sweep["settle_s"]]
+    if trace is not None:
+        for row in rows:
+            trace.append({"time_s": round(row["t_s"] - sweep["settle_s"], 6), "reference_mv": int(row["ref_mv"]),
+                          "vout_mv": row["plant_vout_mv"], "measured_mv": int(row["vout_mv"]),
+                          "duty": int(row["duty"]), "state": int(row["state"])})
+    return measure(spec, derived, fw, sweep, trial, rows)
+
+
+def measure(spec, derived, fw, sweep, trial, rows):
+    """overshoot, settling and failure of the step from the rows after it"""
+    tail_start = rows[-1]["t_s"] - sweep["tail_s"]
+    vout = [row["plant_vout_mv"] for row in rows]
+    tail = [row["plant_vout_mv"] for row in rows if row["t_s"] > tail_start]
+    final = sum(tail) / len(tail)
+    step = sweep["to_mv"] - sweep["from_mv"]
+    band = abs(final) * sweep["band_pct"] / 100.0
+    direction = 1.0 if step >= 0 else -1.0
+    overshoot = max(0.0, max((v - final) * direction for v in vout))
+
+    settled_s = sweep["settle_s"]
+    for row in reversed(rows):
+        if abs(row["plant_vout_mv"] - final) > band:
+            settled_s = row["t_s"]
+            break
+    settling_s = settled_s - sweep["settle_s"] if settled_s <= tail_start else None
+
+    measurement_gain = spec["vout_divider"] / trial["vout_divider"] * spec["vref"] / trial["vref"]
+    margin_spec = dict(spec, inductance=trial["inductance"], capacitance=trial["capacitance"], esr=trial["esr"])
+    crossover, phase_margin, gain_margin = design_spec.loop_margins(margin_spec, derived, trial["load"],
+                                                                    trial["vin_mv"], measurement_gain)
+
+    reasons = []
+    if settling_s is None:
+        reasons.append("unsettled")
+    if max(tail) - min(tail) > 2 * band:
+        reasons.append("oscillating")
+    period = fw["VOLTAGE_MODE_CONTROL_PERIOD"]
+    limits = (fw["MAX_DUTY"] * period // 25, fw["MIN_DUTY"] * period // 25)     #duty limits of controlRoutine()
+    limited = sum(1 for row in rows if row["t_s"] > tail_start and int(row["duty"]) in limits)
+    if limited * 2 > len(tail):                 #held on a limit rather than touching it in the limit cycle
+        reasons.append("duty limit")
+    if int(rows[-1]["state"]) != STATE_VOLTAGE_MODE:
+        reasons.append("fault")
+    if phase_margin is not None and phase_margin < sweep["min_phase_margin"]:
+        reasons.append("phase margin")
+    if crossover is None:
+        reasons.append("no crossover")
+
+    result = {k: trial[k] for k in ("trial", "vin_mv", "load")}
+    result.update({
+        "inductance_uh": trial["inductance"] * 1e6, "capacitance_uf": trial["capacitance"] * 1e6,
+        "esr_mohm": trial["esr"] * 1e3, "divider_error_pct": (trial["vout_divider"] / spec["vout_divider"] - 1) * 100,
+        "offset_lsb": trial["offset_lsb"], "overshoot_pct": overshoot / abs(step) * 100.0 if step else 0.0,
+        "settling_ms": settling_s * 1000.0 if settling_s is not None else None,
+        "final_error_mv": final - sweep["to_mv"], "ripple_mv": max(tail) - min(tail),
+        "phase_margin": phase_margin, "gain_margin": gain_margin, "failure": ",".join(reasons),
+    })
+    return result
+
+
+def run_trial(args):
+    sim, spec, derived, fw, sweep, seed, index = args
+    return simulate(sim, spec, derived, fw, sweep, draw_trial(spec, sweep, seed, index))
+
+
+def percentile(values, pct):
+    ordered = sorted(values)
+    at = (len(ordered) - 1) * pct / 100.0
+    low = int(math.floor(at))
+    high = min(low + 1, len(ordered) - 1)
+    return ordered[low] + (ordered[high] - ordered[low]) * (at - low)
+
+
+def report(results, sweep, fw, notes, spec_path):
+    failed = [r for r in results if r["failure"]]
+    out = ["Monte Carlo sweep of %s, %d trials, seed %d" % (spec_path, len(results), sweep["seed"]),
+           "  step %.0fmV to %.0fmV, settling band %.1f%%, KP %d/2^%d, KI %d/2^%d, filter %d samples" % (
+               sweep["from_mv"], sweep["to_mv"], sweep["band_pct"], fw["VOLTAGE_MODE_KP"],
+               fw["VOLTAGE_MODE_KP_EXPONENT"], fw["VOLTAGE_MODE_KI"], fw["VOLTAGE_MODE_KI_EXPONENT"],
+               fw["SIZE_OF_VSENSOR_FILTER"])]
+    out += ["  note: " + note for note in notes]
+    out += ["", "  %-20s" % "" + "".join("%10s" % ("p%d" % p) for p in PERCENTILES) + "%10s" % "worst"]
+    metrics = (("overshoot %", "overshoot_pct", max), ("settling ms", "settling_ms", max),
+               ("final error mV", "final_error_mv", lambda v: max(v, key=abs)), ("ripple mV", "ripple_mv", max),
+               ("phase margin deg", "phase_margin", min), ("gain margin dB", "gain_margin", min))
+    for label, key, worst in metrics:
+        values = [r[key] for r in results if r[key] is not None]
+        if not values:
+            out.append("  %-20s%10s" % (label, "-"))
+            continue
+        out.append("  %-20s" % label + "".join("%10.1f" % percentile(values, p) for p in PERCENTILES)
+                   + "%10.1f" % worst(values))
+
+    out += ["", "Failures: %d of %d (%.2f%%)" % (len(failed), len(results), 100.0 * len(failed) / len(results))]
+    counts = {}
+    for r in failed:
+        for reason in r["failure"].split(","):
+            counts[reason] = counts.get(reason, 0) + 1
+    for reason, count in sorted(counts.items(), key=lambda item: -item[1]):
+        out.append("  %-14s %d" % (reason, count))
+    for r in sorted(failed, key=lambda r: r["phase_margin"] if r["phase_margin"] is not None else -999)[:10]:
+        out.append("  trial %5d: Vin %4.1fV, load %5.1f ohm, L %5.1fuH, C %5.1fuF, ESR %5.1fmOhm, %s" % (
+            r["trial"], r["vin_mv"] / 1000, r["load"], r["inductance_uh"], r["capacitance_uf"], r["esr_mohm"],
+            r["failure"]))
+    return "\n".join(out)
+
+
+def write_csv(path, rows):
+    with open(path, "w", newline="") as f:
+        writer = csv.DictWriter(f, fieldnames=list(rows[0].keys()))
+        writer.writeheader()
+        writer.writerows(rows)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Monte Carlo tolerance sweep of the voltage loop")
+    parser.add_argument("spec", help="design spec, see tools/specs/default.ini")
+    parser.add_argument("--trials", type=int, help="number of trials, default from the spec")
+    parser.add_argument("--jobs", type=int, default=os.cpu_count(), help="worker processes, default one per core")
+    parser.add_argument("--seed", type=int, help="sweep seed, default from the spec")
+    parser.add_argument("--set", action="append", default=[], metavar="NAME=VALUE",
+                        help="override a firmware constant, e.g. --set VOLTAGE_MODE_KI=40")
+    parser.add_argument("--csv", help="write every trial to this CSV file")
+    parser.add_argument("--trace", nargs=2, metavar=("TRIAL", "CSV"), help="rerun one trial and write its waveforms")
+    args = parser.parse_args()
+
+    spec = design_spec.read_spec(args.spec)
+    derived = design_spec.derive(spec)
+    sweep = read_sweep(args.spec)
+    if args.trials is not None:
+        sweep["trials"] = args.trials
+    if args.seed is not None:
+        sweep["seed"] = args.seed
+    try:
+        overrides = hostbuild.parse_overrides(args.set)
+        fw = read_firmware(overrides)
+        #the step is the control select jumper moving between the two targets
+        overrides.update({"TARGET_VOLTAGE_MV_1": "%du" % sweep["from_mv"],
+                          "TARGET_VOLTAGE_MV_2": "%du" % sweep["to_mv"]})
+        sim = hostbuild.build(overrides)
+    except (ValueError, RuntimeError) as error:
+        sys.exit("monte_carlo: %s" % error)
+    #the loop margins use the gains as flashed rather than the real gains of the spec
+    derived["kp_real"] = fw["VOLTAGE_MODE_KP"] / float(1 << fw["VOLTAGE_MODE_KP_EXPONENT"])
+    derived["ki_real"] = fw["VOLTAGE_MODE_KI"] / float(1 << fw["VOLTAGE_MODE_KI_EXPONENT"])
+    derived["dt_real"] = fw["DT_GAIN"] / float(1 << fw["DT_EXPONENT"])
+    derived["duty_full_scale"] = 4.0 * (fw["VOLTAGE_MODE_CONTROL_PERIOD"] + 1)
+    spec["filter_length"] = fw["SIZE_OF_VSENSOR_FILTER"]
+
+    if args.trace:
+        trace = []
+        result = simulate(sim, spec, derived, fw, sweep, draw_trial(spec, sweep, sweep["seed"], int(args.trace[0])),
+                          trace)
+        write_csv(args.trace[1], trace)
+        print("\n".join("  %-18s %s" % (key, "%.6g" % value if isinstance(value, float) else value)
+                         for key, value in result.items()))
+        return 0
+
+    work = [(sim, spec, derived, fw, sweep, sweep["seed"], index) for index in range(sweep["trials"])]
+    with multiprocessing.Pool(max(1, args.jobs)) as pool:
+        results = pool.map(run_trial, work, chunksize=max(1, len(work) // (4 * max(1, args.jobs))))
+
+    if args.csv:
+        write_csv(args.csv, results)
+    print(report(results, sweep, fw, model_notes(fw), args.spec))
+    return 1 if any(r["failure"] for r in results) else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
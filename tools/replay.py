@@ -0,0 +1,195 @@
+#!/usr/bin/env python3
+"""
+File:   replay.py
+
+Replays a recorded trace through the firmware on the host simulation (tools/host), a sample
+per tick, and writes the duty, period and state the firmware chose at each tick:
+
+    python tools/replay.py trace [--capture N] [--settle S] [--set NAME=VALUE ...]
+                                 [--baseline] [-o output.csv]
+
+The trace is a CSV or a raw telemetry capture (see telemetry_decode.py). A CSV has a column
+per recorded input, each optional:
+    vout, il, ids, vin, pot_duty, pot_freq, or anN  raw 10 bit ADC counts for that channel
+    trip_il, trip_ids                               1 latches the trip comparator, as the
+                                                    firmware sees the latch until it clears it
+    control_select, mode_select                     pin levels
+and a t_s column giving each sample's time from the start of the trace. Without t_s there is
+a sample per tick (2.048ms), the rate the firmware samples at, and each sample is applied
+between two ticks so the next tick reads it. A telemetry capture replays scope capture N
+(default the first), which is a tick rate trace of one channel, 8 bits scaled back to 10.
+Burst captures are not at the tick rate and are refused.
+
+Channels the trace does not cover come from the plant model of tools/host/plant.c, so a
+recorded Vout with the plant's IL replays the voltage loop against the recording. The
+firmware's duty does not change a recorded input, the loop is open on those channels, which
+is what reproduces the controller's reaction to an incident. The firmware runs from power
+on for --settle seconds (default 1.5, 0 to start the trace at power on) on the plant alone
+before the trace starts.
+
+--set builds the firmware with defines overridden (see hostbuild.py), so a filter or gain
+change can be replayed against the same trace. --baseline also replays the project as
+committed and reports where the two first differ. The output has a row per tick from the
+start of the trace: t_s, sample, state, state_name, duty, period, ref_mv, vout_mv, il_ma,
+trip, and with --baseline the baseline's state, duty and period.
+"""
+
+import argparse
+import csv
+import sys
+
+import hostbuild
+import telemetry_decode
+
+TICK_S = 16384 / 8e6            #Timer0 overflow, tools/host/hal.h HOST_TICK_CYCLES
+
+#ADC channel of each named input, ADC_CHANNEL() of the gpio pins in Global.h
+CHANNELS = {"ids": 0, "il": 2, "vout": 4, "vin": 6, "pot_freq": 10, "pot_duty": 11}
+TRIPS = {"trip_il": "il", "trip_ids": "ids"}
+PINS = ("control_select", "mode_select")
+
+#enum stateMachine, in order
+STATE_NAMES = ["initialising", "potControl", "voltageModeControl", "currentModeControl", "overCurrentFault",
+               "overVoltageFault", "underVoltageFault", "shortCircuitFault"]
+
+OUTPUT_COLUMNS = ["t_s", "sample", "state", "state_name", "duty", "period", "ref_mv", "vout_mv", "il_ma", "trip"]
+
+
+def read_csv_trace(path):
+    """samples as (time, {input: value}) from a CSV, times in seconds from the first sample"""
+    with open(path, newline="") as f:
+        reader = csv.DictReader(f)
+        columns = [name.strip() for name in reader.fieldnames or []]
+        inputs = [name for name in columns if name in CHANNELS or name in TRIPS or name in PINS or
+                  (name.startswith("an") and name[2:].isdigit())]
+        if not inputs:
+            raise ValueError("%s has none of the input columns, see replay.py" % path)
+        samples = []
+        for index, row in enumerate(reader):
+            row = {key.strip(): value for key, value in row.items() if key is not None}
+            time = float(row["t_s"]) if "t_s" in row else index * TICK_S
+            samples.append((time, {name: int(float(row[name])) for name in inputs if row.get(name, "").strip()}))
+    if "t_s" in columns and samples:
+        start = samples[0][0]
+        samples = [(time - start, values) for time, values in samples]
+    return samples
+
+
+def read_telemetry_trace(path, number):
+    """samples from scope capture number of a raw telemetry capture"""
+    with open(path, "rb") as f:
+        _, captures = telemetry_decode.read_capture(f.read())
+    if number >= len(captures):
+        raise ValueError("%s has %d complete scope captures" % (path, len(captures)))
+    capture = captures[number]
+    if capture["channel"] & telemetry_decode.SCOPE_BURST_FLAG:
+        raise ValueError("scope capture %d is a burst capture, only tick rate captures can be replayed" % number)
+    name = "an%d" % (capture["channel"] & ~telemetry_decode.SCOPE_BURST_FLAG)
+    return [(index * TICK_S, {name: value << 2}) for index, value in enumerate(capture["samples"])]
+
+
+def read_trace(path, number=0):
+    with open(path, "rb") as f:
+        head = f.read(1)
+    if head and head[0] == telemetry_decode.TELEMETRY_SYNC:
+        return read_telemetry_trace(path, number)
+    return read_csv_trace(path)
+
+
+def channel_of(name):
+    return CHANNELS[name] if name in CHANNELS else int(name[2:])
+
+
+def build_script(samples, settle_s):
+    """sim script applying each sample between two ticks, the sample's time rounded to the tick it is first seen on"""
+    lines = ["run %.9f" % settle_s] if settle_s > 0 else []
+    previous = {}
+    tick = 0
+    for time, values in samples:
+        target = int(round(time / TICK_S))
+        if target > tick:
+            lines.append("ticks %d" % (target - tick))
+            tick = target
+        for name, value in sorted(values.items()):
+            if name in TRIPS:
+                if value and not previous.get(name):
+                    lines.append("trip " + TRIPS[name])
+            elif name in PINS:
+                if value != previous.get(name):
+                    lines.append("pin %s %d" % (name, 1 if value else 0))
+            elif value != previous.get(name):
+                lines.append("analog %d %d" % (channel_of(name), max(0, min(1023, value))))
+            previous[name] = value
+    lines.append("ticks 1")                     #the tick reading the last sample
+    return "\n".join(lines) + "\n"
+
+
+def replay(sim, samples, settle_s):
+    """rows of the ticks from the start of the trace, with the trace sample each tick read"""
+    script = build_script(samples, settle_s)
+    rows = [row for row in hostbuild.run(sim, script) if row["t_s"] >= settle_s]
+    start = rows[0]["t_s"] if rows else 0.0
+    out = []
+    for index, row in enumerate(rows):
+        state = int(row["state"])
+        out.append({
+            "t_s": "%.6f" % (row["t_s"] - start), "sample": index, "state": state,
+            "state_name": STATE_NAMES[state] if state < len(STATE_NAMES) else state,
+            "duty": int(row["duty"]), "period": int(row["period"]), "ref_mv": int(row["ref_mv"]),
+            "vout_mv": int(row["vout_mv"]), "il_ma": int(row["il_ma"]), "trip": int(row["trip"]),
+        })
+    return out
+
+
+def compare(rows, baseline):
+    """adds the baseline columns, returns a summary of where the replays differ"""
+    first = None
+    largest = 0
+    state_changes = 0
+    for row, base in zip(rows, baseline):
+        row["baseline_state"], row["baseline_duty"], row["baseline_period"] = base["state"], base["duty"], base["period"]
+        differs = (row["state"], row["duty"], row["period"]) != (base["state"], base["duty"], base["period"])
+        if differs and first is None:
+            first = row
+        largest = max(largest, abs(row["duty"] - base["duty"]))
+        state_changes += row["state"] != base["state"]
+    if first is None:
+        return "replay: same duty, period and state as the baseline at every tick"
+    return ("replay: first differs from the baseline at %ss (sample %d), largest duty difference %d counts, "
+            "state differs on %d ticks" % (first["t_s"], first["sample"], largest, state_changes))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n\n")[1].strip())
+    parser.add_argument("trace", help="CSV trace or raw telemetry capture")
+    parser.add_argument("--capture", type=int, default=0, help="scope capture of a telemetry capture, default 0")
+    parser.add_argument("--settle", type=float, default=1.5, help="seconds on the plant before the trace, default 1.5")
+    parser.add_argument("--set", action="append", metavar="NAME=VALUE", help="override a firmware #define")
+    parser.add_argument("--baseline", action="store_true", help="also replay the committed settings and compare")
+    parser.add_argument("-o", "--output", help="output CSV, default stdout")
+    args = parser.parse_args()
+
+    try:
+        samples = read_trace(args.trace, args.capture)
+        if not samples:
+            raise ValueError("%s has no samples" % args.trace)
+        rows = replay(hostbuild.build(hostbuild.parse_overrides(args.set)), samples, args.settle)
+        summary = None
+        if args.baseline:
+            summary = compare(rows, replay(hostbuild.build(), samples, args.settle))
+    except (OSError, ValueError, RuntimeError) as error:
+        sys.exit("replay: %s" % error)
+
+    columns = OUTPUT_COLUMNS + (["baseline_state", "baseline_duty", "baseline_period"] if args.baseline else [])
+    output = open(args.output, "w", newline="") if args.output else sys.stdout
+    writer = csv.DictWriter(output, fieldnames=columns)
+    writer.writeheader()
+    writer.writerows(rows)
+    if args.output:
+        output.close()
+    if summary:
+        sys.stderr.write(summary + "\n")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,292 @@
+#!/usr/bin/env python3
+"""
+File:   share_bus.py
+
+Runs several nodes of the firmware with current sharing (Share.h) on a simulated shared bus,
+each a host simulation (tools/host) with its own clock error, power on time and Vout sense
+offset, with their outputs in parallel on a common load, and reports the bus collisions, how
+the share slots settle and how evenly the nodes share the load current:
+
+    python tools/share_bus.py [--nodes N] [--seconds S] [--clock-ppm PPM] [--start-spread S]
+                              [--load OHMS] [--bus-mohm MOHMS] [--bus-uf UF] [--offset-lsb LSB]
+                              [--seed N] [--set NAME=VALUE ...] [--csv rows.csv]
+
+Each node is built with SHARE_ENABLED, TELEMETRY_ENABLED, COMMAND_ENABLED, DROOP_ENABLED and
+its own SHARE_NODE_ID. Its clock is off by a random amount within --clock-ppm (default 10000,
+the +/-1% of the internal oscillator the board runs from), it powers on at a random time within
+--start-spread (default one share period) and its Vout sense is offset by a random amount
+within --offset-lsb (default 2), the mismatch current sharing has to correct. The sims are run
+side by side in steps of --step-ms of bus time. After each step the bytes each node sent are
+placed on the bus at their start times. The bus is open drain, so bytes from different nodes
+that overlap in time are combined as a wired AND and counted as a collision. Every node receives
+every byte, its own included, as the firmware expects to hear its own frame back.
+
+Each output connects to the load through --bus-mohm (default 20) once its sim has started up.
+Within a step a node sees the load voltage through its connection (bus_ohm and bus_mv of the
+plant), after each step the load voltage moves on the total node current, with --bus-uf across
+the load (default 220 per node, the output capacitors of the nodes). The same nodes are also
+run without SHARE_ENABLED on a second load, as the spread sharing is measured against.
+
+The report gives the collided bytes on the bus and the time of the last one, the share
+frames each node sent and the collisions its firmware detected, each node's final trim and
+mean output current, and the spread of the node currents (largest less smallest mean) over
+the last --settle seconds (default 1) with and without sharing. The exit status is 1 if bytes
+still collided in the last --settle seconds, that is the slots did not settle into turns, or
+if sharing did not at least halve the current spread.
+"""
+
+import argparse
+import csv
+import random
+import subprocess
+import sys
+
+import hostbuild
+
+CYCLES_PER_SECOND = 8e6
+BAUD = 32e6 / (4 * (68 + 1))        #TELEMETRY_BAUD_DIVIDER, Telemetry.h
+BYTE_S = 10 / BAUD                  #start, 8 data and stop bits
+TELEMETRY_SYNC = 0xA5
+TELEMETRY_ID_SHARE = 0x05
+SHARE_PERIOD_S = 49 * 16384 / 8e6   #SHARE_PERIOD ticks, Share.h
+ROW_TICKS = 49                      #a row per share period from each sim
+SPREAD_REDUCTION = 0.5              #sharing must at least halve the current spread, the unshared spread varies by
+                                    #tens of mA from run to run with the duty limit cycle of each node
+
+
+class Node:
+    """one sim, running on its own clock from its own power on time"""
+
+    def __init__(self, number, sim, clock_error, start_s, offset_lsb, bus_ohm):
+        self.number = number
+        self.clock = 1.0 + clock_error
+        self.clock_error = clock_error
+        self.start_s = start_s
+        self.offset_lsb = offset_lsb
+        self.cycles = 0
+        self.rows = []
+        self.frames = 0
+        self.last = b""
+        self.bus_ohm = bus_ohm
+        self.caught_up = False
+        self.connected = False
+        self.current_ma = 0.0
+        self.currents = []              #(bus time, output current) of each step once connected
+        self.process = subprocess.Popen([sim], stdin=subprocess.PIPE, stdout=subprocess.PIPE, universal_newlines=True,
+                                        bufsize=1)
+        self.header = self.process.stdout.readline().strip().split(",")
+        self.send("every %d\nset load_ohm 0\nset vout_offset_lsb %g\n" % (ROW_TICKS, offset_lsb))
+
+    def send(self, text):
+        self.process.stdin.write(text)
+        self.process.stdin.flush()
+
+    def run_to(self, bus_s):
+        """runs the sim up to bus time bus_s, returns the bytes it sent as (bus time, byte)"""
+        if bus_s <= self.start_s:
+            return []
+        target = int(round((bus_s - self.start_s) * CYCLES_PER_SECOND * self.clock))
+        if target > self.cycles:
+            self.send("run %.9f\n" % ((target - self.cycles) / CYCLES_PER_SECOND))
+            self.cycles = target
+        self.send("tx\n")
+        sent = []
+        while True:
+            line = self.process.stdout.readline()
+            if not line:
+                raise RuntimeError("node %d sim stopped" % self.number)
+            fields = line.strip().split(",")
+            if fields[0] == "tx":
+                if fields[1] == "end":
+                    break
+                cycle, value = int(fields[1]), int(fields[2])
+                sent.append((self.start_s + cycle / (CYCLES_PER_SECOND * self.clock), value))
+                self.count_frame(value)
+            else:
+                self.rows.append(dict(zip(self.header, map(float, fields))))
+        return sent
+
+    def output(self, bus_s):
+        """the output current into the load in mA at bus time bus_s, 0 until connected"""
+        if self.cycles == 0:
+            return 0.0
+        self.send("out\n")
+        fields = self.process.stdout.readline().strip().split(",")
+        if fields[0] != "out":
+            raise RuntimeError("node %d sim stopped" % self.number)
+        self.caught_up = int(fields[1]) <= self.cycles
+        self.current_ma = float(fields[3])
+        if not self.connected:
+            return 0.0
+        self.currents.append((bus_s, self.current_ma))
+        return self.current_ma
+
+    def connect(self, bus_mv):
+        """sets the bus voltage for the next step. The output is connected once the sim has caught up with bus time
+        after its start up, which runs on past the first steps, until then the sim is not moved on by a step and
+        would not respond to the bus"""
+        if self.caught_up and not self.connected:
+            self.send("set bus_ohm %g\n" % self.bus_ohm)
+            self.connected = True
+        self.send("set bus_mv %.3f\n" % bus_mv)
+
+    def count_frame(self, value):
+        """counts share frames by their sync and ID bytes"""
+        self.last = (self.last + bytes([value]))[-2:]
+        if self.last == bytes([TELEMETRY_SYNC, TELEMETRY_ID_SHARE]):
+            self.frames += 1
+
+    def receive(self, values):
+        if values and self.cycles > 0:
+            self.send("rx %s\n" % " ".join("%02x" % value for value in values))
+
+    def close(self):
+        self.process.stdin.close()
+        self.process.wait()
+
+
+class Load:
+    """the common load on the node outputs, a resistor with the bus capacitance across it. The nodes see the bus
+    voltage through their connection resistance within a step and the bus moves on their total current each step,
+    backward Euler through the load. The node inductors and this capacitance still need steps well below their
+    period, approx 1ms"""
+
+    def __init__(self, load_ohm, bus_uf):
+        self.load_ohm = load_ohm
+        self.capacitance = bus_uf * 1e-6
+        self.bus_mv = 0.0
+
+    def step(self, current_ma, step_s):
+        """moves the bus on by a step with the total node current current_ma, returns the bus voltage in mV"""
+        c = self.capacitance / step_s
+        self.bus_mv = (c * self.bus_mv + current_ma) / (c + 1.0 / self.load_ohm)
+        return self.bus_mv
+
+
+class Bus:
+    """the open drain bus, bytes from different nodes that overlap in time are ANDed. A byte is held back until no
+    byte sent later can overlap it, so one that collides across a step is combined before it is delivered"""
+
+    def __init__(self):
+        self.pending = []               #(start time, value, nodes sending)
+        self.collisions = []            #times of the collided bytes
+
+    def step(self, sent, bus_s):
+        """adds the bytes sent as (time, value, node), returns the bytes complete by bus time bus_s"""
+        bytes_ = sorted([(time, value, {node}) for time, value, node in sent] + self.pending, key=lambda b: b[0])
+        merged = []
+        for time, value, nodes in bytes_:
+            if merged and time - merged[-1][0] < BYTE_S and not (nodes & merged[-1][2]):
+                start, combined, previous = merged[-1]
+                merged[-1] = (start, combined & value, previous | nodes)
+                self.collisions.append(time)
+            else:
+                merged.append((time, value, nodes))
+        self.pending = [byte for byte in merged if byte[0] >= bus_s - BYTE_S]
+        return [value for time, value, _ in merged if time < bus_s - BYTE_S]
+
+
+def mean_current(node, start_s):
+    """mean output current of a node from bus time start_s on, in mA"""
+    currents = [current for time, current in node.currents if time >= start_s]
+    return sum(currents) / len(currents) if currents else 0.0
+
+
+def spread(nodes, start_s):
+    """largest less smallest mean output current of the nodes from bus time start_s on, in mA"""
+    means = [mean_current(node, start_s) for node in nodes]
+    return max(means) - min(means)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n\n")[1].strip())
+    parser.add_argument("--nodes", type=int, default=3, help="nodes on the bus, default %(default)s")
+    parser.add_argument("--seconds", type=float, default=10.0, help="bus time to run, default %(default)s")
+    parser.add_argument("--clock-ppm", type=float, default=10000.0, help="clock error limit, default %(default)s")
+    parser.add_argument("--start-spread", type=float, default=SHARE_PERIOD_S, help="power on spread in seconds")
+    parser.add_argument("--load", type=float, help="common load in ohms, default 12 / nodes, 1A from each node")
+    parser.add_argument("--bus-mohm", type=float, default=20.0, help="connection of each node to the load, default "
+                        "%(default)s")
+    parser.add_argument("--bus-uf", type=float, help="capacitance across the load, default 220uF per node")
+    parser.add_argument("--offset-lsb", type=float, default=2.0, help="Vout sense offset limit, default %(default)s")
+    parser.add_argument("--step-ms", type=float, default=0.1, help="bus time step, default %(default)s, the load "
+                        "voltage is only stable with steps well below the period of the output filter")
+    parser.add_argument("--settle", type=float, default=1.0, help="end of the run that must be free of collisions and "
+                        "where the current spread is measured")
+    parser.add_argument("--seed", type=int, default=1)
+    parser.add_argument("--set", action="append", metavar="NAME=VALUE", help="override a firmware #define")
+    parser.add_argument("--csv", help="write the rows of every node, with a node column")
+    args = parser.parse_args()
+
+    generator = random.Random(args.seed)
+    load_ohm = args.load or 12.0 / args.nodes
+    bus_uf = args.bus_uf or 220.0 * args.nodes
+    step_s = args.step_ms / 1000.0
+    nodes = []
+    alone = []                          #the same nodes without sharing, on their own load
+    try:
+        for number in range(args.nodes):
+            overrides = {"SHARE_ENABLED": "1", "TELEMETRY_ENABLED": "1", "COMMAND_ENABLED": "1", "DROOP_ENABLED": "1",
+                         "SHARE_NODE_ID": "%du" % number}
+            overrides.update(hostbuild.parse_overrides(args.set))
+            settings = (generator.uniform(-1.0, 1.0) * args.clock_ppm * 1e-6, generator.uniform(0.0, args.start_spread),
+                        generator.uniform(-1.0, 1.0) * args.offset_lsb, args.bus_mohm / 1000.0)
+            nodes.append(Node(number, hostbuild.build(overrides), *settings))
+            overrides["SHARE_ENABLED"] = "0"
+            alone.append(Node(number, hostbuild.build(overrides), *settings))
+
+        bus = Bus()
+        load = Load(load_ohm, bus_uf)
+        alone_load = Load(load_ohm, bus_uf)
+        steps = int(round(args.seconds / step_s))
+        for step in range(1, steps + 1):
+            bus_s = step * step_s
+            sent = [(time, value, node.number) for node in nodes for time, value in node.run_to(bus_s)]
+            for node in alone:
+                node.run_to(bus_s)          #telemetry frames are sent without sharing, they are not on the bus
+            values = bus.step(sent, bus_s)
+            load_mv = load.step(sum(node.output(bus_s) for node in nodes), step_s)
+            alone_mv = alone_load.step(sum(node.output(bus_s) for node in alone), step_s)
+            for node in nodes:
+                node.receive(values)
+                node.connect(load_mv)
+            for node in alone:
+                node.connect(alone_mv)
+    except (ValueError, RuntimeError) as error:
+        sys.exit("share_bus: %s" % error)
+    finally:
+        for node in nodes + alone:
+            node.close()
+
+    collisions = bus.collisions
+    settled = not any(time > args.seconds - args.settle for time in collisions)
+    shared = spread(nodes, args.seconds - args.settle)
+    unshared = spread(alone, args.seconds - args.settle)
+    out = ["Share bus, %d nodes for %gs, clock error within %gppm, %g ohm load at %.0fmV" % (
+               args.nodes, args.seconds, args.clock_ppm, load_ohm, load.bus_mv),
+           "  collided bytes %d, last at %s" % (len(collisions), "%.3fs" % max(collisions) if collisions else "-"),
+           "  current spread over the last %gs %.0fmA, %.0fmA without sharing" % (args.settle, shared, unshared)]
+    for node, single in zip(nodes, alone):
+        last = node.rows[-1] if node.rows else {}
+        out.append("  node %d: clock %+6.0fppm, on at %5.1fms, offset %+4.1f LSB, %4d frames sent, %3d collisions "
+                   "detected, trim %+4dmV, output %5.0fmA, %5.0fmA without sharing" % (
+                       node.number, node.clock_error * 1e6, node.start_s * 1000.0, node.offset_lsb, node.frames,
+                       last.get("share_collisions", 0), last.get("share_trim_mv", 0),
+                       mean_current(node, args.seconds - args.settle), mean_current(single, args.seconds - args.settle)))
+    out.append("share_bus: slots %s" % ("settled" if settled else "still colliding in the last %gs" % args.settle))
+    reduced = shared < unshared * SPREAD_REDUCTION
+    out.append("share_bus: sharing %s the current spread" % ("halved" if reduced else "did not halve"))
+    print("\n".join(out))
+
+    if args.csv:
+        with open(args.csv, "w", newline="") as f:
+            writer = csv.writer(f)
+            writer.writerow(["node"] + nodes[0].header)
+            for node in nodes:
+                for row in node.rows:
+                    writer.writerow([node.number] + [row[name] for name in node.header])
+    sys.exit(0 if settled and reduced else 1)
+
+
+if __name__ == "__main__":
+    main()
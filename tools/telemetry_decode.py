@@ -0,0 +1,166 @@
+#!/usr/bin/env python3
+"""
+File:   telemetry_decode.py
+
+Decodes a raw capture of the telemetry serial output (115200 baud, see Telemetry.h)
+into CSV files that can be plotted or fed to offline analysis:
+
+    python tools/telemetry_decode.py capture.bin [output_dir]
+
+Frames are found by the sync byte and checked against their checksum, bad frames are
+counted and skipped. One CSV is written per frame type (faults.csv, benchmark.csv,
+energy.csv) with a row per frame, and each complete scope capture is reassembled in
+time order into scope_N.csv with the samples scaled back to 10 bit ADC counts and the
+trigger sample marked. The frame layouts follow the payload comments in the send
+functions of FaultManager.c, Benchmark.c, Energy.c and Scope.c.
+"""
+
+import csv
+import os
+import sys
+
+TELEMETRY_SYNC = 0xA5
+
+TELEMETRY_ID_FAULTS = 0x01
+TELEMETRY_ID_BENCHMARK = 0x02
+TELEMETRY_ID_ENERGY = 0x03
+TELEMETRY_ID_SCOPE = 0x04
+
+#must match Scope.h
+SIZE_OF_SCOPE_BUFFER = 32
+SCOPE_PRE_TRIGGER = 8
+SCOPE_BURST_FLAG = 0x80
+
+#enum faultType and enum scopeTrigger, in order
+FAULT_TYPES = ["none", "tripIL", "tripIDS", "tripBoth", "phase2Shed", "overVoltage", "underVoltage", "shortCircuit"]
+SCOPE_TRIGGERS = ["currentTrip", "above", "below", "stateChange", "command"]
+
+#enum benchmarkSlot, in order
+BENCHMARK_SLOTS = ["common", "slot1", "slot3", "slot4"]
+
+
+def read_frames(data):
+    """yields (frame ID, payload) for each frame with a valid checksum, and counts the bad ones"""
+    stats = {"frames": 0, "bad": 0}
+    i = 0
+    while i + 4 <= len(data):
+        if data[i] != TELEMETRY_SYNC:
+            i += 1
+            continue
+        frame_id, length = data[i + 1], data[i + 2]
+        end = i + 3 + length
+        if end >= len(data):
+            break
+        payload = data[i + 3:end]
+        if (frame_id + length + sum(payload)) & 0xFF != data[end]:
+            stats["bad"] += 1
+            i += 1                              #resynchronise from the next byte
+            continue
+        stats["frames"] += 1
+        yield frame_id, payload
+        i = end + 1
+    read_frames.stats = stats
+
+
+def u16(payload, at):
+    return (payload[at] << 8) | payload[at + 1]
+
+
+def s16(payload, at):
+    value = u16(payload, at)
+    return value - 0x10000 if value & 0x8000 else value
+
+
+def u32(payload, at):
+    return (u16(payload, at) << 16) | u16(payload, at + 2)
+
+
+def decode_faults(payload):
+    fault = payload[6]
+    return {"countIL": u16(payload, 0), "countIDS": u16(payload, 2), "retries": payload[4],
+            "latched": payload[5], "lastFault": FAULT_TYPES[fault] if fault < len(FAULT_TYPES) else fault,
+            "lastFaultTick": u32(payload, 7)}
+
+
+def decode_benchmark(payload):
+    row = {name: payload[n] for n, name in enumerate(BENCHMARK_SLOTS)}
+    at = len(BENCHMARK_SLOTS)
+    row.update({"voutMin": u16(payload, at), "voutMax": u16(payload, at + 2),
+                "errorMax": u16(payload, at + 4), "errorMean": s16(payload, at + 6)})
+    return row
+
+
+def decode_energy(payload):
+    return {"outputJ": u32(payload, 0), "inputJ": u32(payload, 4), "outputmW": u16(payload, 8),
+            "inputmW": u16(payload, 10), "efficiencyPercent": u16(payload, 12) / 10.0}
+
+
+DECODERS = {TELEMETRY_ID_FAULTS: ("faults", decode_faults),
+            TELEMETRY_ID_BENCHMARK: ("benchmark", decode_benchmark),
+            TELEMETRY_ID_ENERGY: ("energy", decode_energy)}
+
+
+def write_csv(path, rows):
+    with open(path, "w", newline="") as f:
+        writer = csv.DictWriter(f, fieldnames=list(rows[0].keys()))
+        writer.writeheader()
+        writer.writerows(rows)
+
+
+def read_capture(data):
+    """the decoded frames as a list of rows per frame type, and the complete scope captures, each with the channel byte,
+    trigger and samples (top 8 bits) in the order taken"""
+    tables = {}
+    captures = []
+    scope = None
+    for frame_id, payload in read_frames(data):
+        if frame_id in DECODERS:
+            name, decoder = DECODERS[frame_id]
+            tables.setdefault(name, []).append(decoder(payload))
+        elif frame_id == TELEMETRY_ID_SCOPE:
+            channel, trigger, index, samples = payload[0], payload[1], payload[2], payload[3:]
+            if index == 0:
+                scope = {"channel": channel, "trigger": trigger, "samples": []}
+            if scope is None or index != len(scope["samples"]):
+                scope = None                    #part of a capture was lost
+                continue
+            scope["samples"] += list(samples)
+            if len(scope["samples"]) >= SIZE_OF_SCOPE_BUFFER:
+                captures.append(scope)
+                scope = None
+    return tables, captures
+
+
+def decode(capture_path, output_dir):
+    with open(capture_path, "rb") as f:
+        data = f.read()
+    tables, captures = read_capture(data)
+
+    os.makedirs(output_dir, exist_ok=True)
+    out = ["Decoded %d frames (%d bad) from %s" % (read_frames.stats["frames"], read_frames.stats["bad"], capture_path)]
+    for name, rows in sorted(tables.items()):
+        write_csv(os.path.join(output_dir, name + ".csv"), rows)
+        out.append("  %-10s %6d frames" % (name, len(rows)))
+    for n, capture in enumerate(captures):
+        trigger = capture["trigger"]
+        rate = "burst" if capture["channel"] & SCOPE_BURST_FLAG else "tick"
+        rows = [{"sample": i - SCOPE_PRE_TRIGGER, "adc": value << 2, "trigger": int(i == SCOPE_PRE_TRIGGER)}
+                for i, value in enumerate(capture["samples"])]
+        write_csv(os.path.join(output_dir, "scope_%d.csv" % n), rows)
+        out.append("  scope_%d    channel AN%d, %s trigger, %s rate after the trigger" % (
+            n, capture["channel"] & ~SCOPE_BURST_FLAG,
+            SCOPE_TRIGGERS[trigger] if trigger < len(SCOPE_TRIGGERS) else trigger, rate))
+    return "\n".join(out)
+
+
+def main():
+    if len(sys.argv) < 2:
+        print("usage: telemetry_decode.py capture.bin [output_dir]")
+        return 1
+    output_dir = sys.argv[2] if len(sys.argv) > 2 else os.path.splitext(sys.argv[1])[0]
+    print(decode(sys.argv[1], output_dir))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())